@@ -2,44 +2,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 #include <limits.h>
 
-#define GRID_WIDTH 20
-#define GRID_HEIGHT 15
-#define CELL_SIZE 40
-// K_PATHS is how many disjoint paths to find
-#define K_PATHS 5 
-
-typedef enum {
-    CELL_EMPTY,
-    CELL_WALL,
-    CELL_START, // Will be Green
-    CELL_END,   // Will be Red
-    // Specific path types for different shades of blue
-    CELL_PATH_1,
-    CELL_PATH_2,
-    CELL_PATH_3,
-    CELL_PATH_4,
-    CELL_PATH_5
-} CellType;
-
-typedef struct {
-    int x, y;
-} Point;
-
-// Struct for Dijkstra's priority queue
-typedef struct Node {
-    Point pos;
-    int cost;
-} Node;
-
-// Struct to store a single complete path
-typedef struct {
-    Point points[GRID_WIDTH * GRID_HEIGHT]; // Max possible path length
-    int length;
-    int cost;
-} Path;
+#include "grid.h"
+#include "grid_map.h"
+#include "palette.h"
+#include "ch.h"
+#include "alt.h"
+#include "cpd.h"
+#include "goal_bounds.h"
+#include "grid_search.h"
+#include "map_snapshot.h"
+#include "query_server.h"
+#include "shm_ring.h"
+#include "task_pool.h"
+#include "raster.h"
+#include "path_runs.h"
+#include "path_code.h"
+#include "fixed_grid.h"
+#include "mem_track.h"
+#include "map_edit.h"
+#include "components.h"
+#include "sipp.h"
+#include "stress_bench.h"
+#include "search_tree.h"
+#include "speculative_paths.h"
 
 CellType grid[GRID_HEIGHT][GRID_WIDTH]; // Main grid for walls, start, end
 CellType grid_path_type[GRID_HEIGHT][GRID_WIDTH]; // Stores which path type a cell is (CELL_PATH_1, etc.)
@@ -49,8 +38,217 @@ bool start_selected = false;
 bool end_selected = false;
 bool paths_found_and_drawn = false;
 
+// Map file the walls were loaded from; preprocessed data is saved next to it
+const char* map_path = "grid.map";
+// Contraction hierarchy for the current walls (NULL until 'H' is pressed or loaded)
+ContractionHierarchy* route_ch = NULL;
+ChWorkspace* route_ch_workspace = NULL;
+
+// Compressed path database for the current walls (NULL until 'P' is pressed or loaded)
+CompressedPathDb* route_cpd = NULL;
+// Goal bounds for the current walls (NULL until 'G' is pressed or loaded)
+GoalBounds* route_goal_bounds = NULL;
+// ALT landmarks for the current walls (NULL until 'L' is pressed)
+AltLandmarks* route_landmarks = NULL;
+
+// Published versions of the walls; queries read a pinned snapshot instead of the grid
+MapStore* route_walls = NULL;
+int route_walls_reader = -1;
+
+// Timed doors ('T'): their closed windows and the safe intervals they leave
+#define DOOR_PERCENT 8
+#define SCHEDULE_HORIZON 2048 // Steps the doors cycle for; they stay open afterwards
+#define SCHEDULE_STEPS_PER_SECOND 4
+SippBlock* door_blocks = NULL; // Sorted by cell
+int door_block_count = 0;
+SippMap* route_doors = NULL;
+// The timed path on display, one point per step, and when its playback began
+TimedPoint* schedule_path = NULL;
+int schedule_length = 0;
+Uint64 schedule_started = 0;
+
+// Recomputes the safe intervals of the doors for new walls
+void rebuild_route_doors(const GridMap* map) {
+    sipp_free(route_doors);
+    route_doors = door_blocks && map ? sipp_create(map, door_blocks, door_block_count) : NULL;
+}
+
+void clear_schedule() {
+    free(schedule_path);
+    schedule_path = NULL;
+    schedule_length = 0;
+}
+
+// Connected areas of the current walls, kept up to date by apply_wall_edits()
+MapComponents* route_components = NULL;
+
+// Publishes the walls of the global grid as a new snapshot (only changed tiles
+// are copied) and labels its connected areas from scratch
+void publish_grid_walls() {
+    GridMap* map = gridmap_from_grid();
+    components_free(route_components);
+    route_components = map ? components_build(map) : NULL;
+    if (door_blocks)
+        rebuild_route_doors(map);
+
+    if (!route_walls) {
+        if (map)
+            route_walls = map_store_create(map);
+        gridmap_free(map);
+        if (route_walls)
+            route_walls_reader = map_store_register_reader(route_walls);
+        return;
+    }
+    gridmap_free(map);
+
+    MapSnapshot* draft = map_store_begin_edit(route_walls);
+    if (!draft)
+        return;
+    for (int y = 0; y < GRID_HEIGHT; y++) {
+        for (int x = 0; x < GRID_WIDTH; x++)
+            map_snapshot_set_wall(draft, x, y, grid[y][x] == CELL_WALL);
+    }
+    map_store_publish(route_walls, draft);
+}
+
+// Number of open map sessions (windows)
+int session_count = 0;
+
+// Frame-budgeted K-loop ('B'): paths are searched in the slack of each frame
+// instead of blocking inside handle_click
+#define FRAME_TIME_MS 16
+bool frame_budgeted_search = false;
+GridSearch* budgeted_search = NULL;
+const MapSnapshot* budgeted_snapshot = NULL;
+int budgeted_path_index = 0;
+
+// Cells of the paths the current query has found, which its later searches
+// avoid. The searches only read it and the walls they pin stay immutable;
+// grid_path_type is the composite the visualizer draws.
+BlockOverlay* query_overlay = NULL;
+
+// Dijkstra tree from the start of the last query, kept when the query is
+// cleared. A new end from the same start is then only a path extraction if the
+// tree settled it already, or resumes the tree's frontier if not. It pins the
+// walls it grew on and is rooted again when the start or the walls change.
+SearchTree* start_tree = NULL;
+const MapSnapshot* start_tree_snapshot = NULL;
+
+void drop_start_tree() {
+    search_tree_free(start_tree);
+    map_snapshot_release(start_tree_snapshot);
+    start_tree = NULL;
+    start_tree_snapshot = NULL;
+}
+
+// The cached tree rooted at start on the current walls, NULL if there is none
+SearchTree* acquire_start_tree() {
+    if (!route_walls)
+        return NULL;
+    const MapSnapshot* current = map_store_acquire(route_walls, route_walls_reader);
+    if (start_tree && current == start_tree_snapshot) {
+        map_snapshot_release(current); // The tree holds a reference already
+    }
+    else {
+        drop_start_tree();
+        start_tree_snapshot = current;
+        start_tree = current ? search_tree_create(map_snapshot_map(current)) : NULL;
+        if (!start_tree) {
+            drop_start_tree();
+            return NULL;
+        }
+        // Same ties as dijkstra_find_path, so path 1 and the hover preview
+        // are the path it would find
+        search_tree_set_scan_order(start_tree, true);
+    }
+    Point source = search_tree_source(start_tree);
+    if (source.x != start.x || source.y != start.y)
+        search_tree_reset(start_tree, start, NULL);
+    return start_tree;
+}
+
+void cancel_budgeted_paths() {
+    grid_search_free(budgeted_search);
+    map_snapshot_release(budgeted_snapshot);
+    budgeted_search = NULL;
+    budgeted_snapshot = NULL;
+}
+
+// K-loop run on the shared worker pool (used while several sessions are open)
+typedef struct {
+    PoolTask task;
+    const MapSnapshot* snapshot;
+    GridSearch* search;
+    SearchOptions options;
+    BlockOverlay* overlay; // The job's own, so workers never touch session state
+    Point from, to;
+    int found;
+    Path paths[K_PATHS];
+} PathJob;
+
+TaskPool* search_pool = NULL;
+int pool_queue = -1;     // The bound session's fairness queue
+PathJob* pool_job = NULL; // The bound session's K-loop in progress
+
+void cancel_pool_paths() {
+    if (!pool_job)
+        return;
+    task_pool_cancel(search_pool, &pool_job->task);
+    grid_search_free(pool_job->search);
+    map_snapshot_release(pool_job->snapshot);
+    block_overlay_free(pool_job->overlay);
+    free(pool_job);
+    pool_job = NULL;
+}
+
+void cancel_pending_paths() {
+    cancel_budgeted_paths();
+    cancel_pool_paths();
+}
+
+// Where the grid is drawn in the window: cell size in pixels (zoom) and the
+// screen position of the grid's top-left corner (pan)
+typedef struct {
+    float cell_size;
+    float offset_x;
+    float offset_y;
+} Viewport;
+Viewport view = { CELL_SIZE, 0.0f, 0.0f };
+
+// The grid as one texel per cell, scaled up in a single draw call. Only rows
+// flagged in grid_rows_dirty are uploaded again.
+SDL_Texture* grid_texture = NULL;
+bool grid_rows_dirty[GRID_HEIGHT];
+// palette_generation() the texture was filled with
+unsigned int grid_palette_generation = 0;
+
+// Below this cell size (pixels) grid lines only produce moiré, so they are hidden
+#define GRID_LINE_MIN_CELL_SIZE 6.0f
+
+// Grid lines of one viewport, rendered into a window-sized target texture
+// and composited in one call until the viewport or the window size changes
+typedef struct {
+    SDL_Texture* texture;
+    Viewport view; // What the texture holds; cell_size 0 when it must be redrawn
+    int width, height;
+} GridLineCache;
+GridLineCache grid_lines = { NULL, { 0.0f, 0.0f, 0.0f }, 0, 0 };
+
+void mark_grid_dirty() {
+    for (int y = 0; y < GRID_HEIGHT; y++)
+        grid_rows_dirty[y] = true;
+}
+
+void drop_route_hierarchy() {
+    ch_workspace_free(route_ch_workspace);
+    ch_free(route_ch);
+    route_ch_workspace = NULL;
+    route_ch = NULL;
+}
+
 // Initialize grid with random walls
 void initialize_grid() {
+    cancel_pending_paths();
     srand(time(NULL));
     for (int y = 0; y < GRID_HEIGHT; y++) {
         for (int x = 0; x < GRID_WIDTH; x++) {
@@ -58,30 +256,127 @@ void initialize_grid() {
             grid_path_type[y][x] = CELL_EMPTY; // Initialize path type grid
         }
     }
+    if (query_overlay)
+        block_overlay_clear(query_overlay);
+    mark_grid_dirty();
+    clear_schedule();
 
     start.x = start.y = -1;
     end.x = end.y = -1;
     start_selected = false;
     end_selected = false;
     paths_found_and_drawn = false;
+
+    // The walls changed, so any preprocessed data for the old ones is stale
+    drop_route_hierarchy();
+    cpd_close(route_cpd);
+    route_cpd = NULL;
+    goal_bounds_free(route_goal_bounds);
+    route_goal_bounds = NULL;
+    alt_free(route_landmarks);
+    route_landmarks = NULL;
+    publish_grid_walls();
+}
+
+void prepare_route_landmarks() {
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return;
+
+    cancel_pending_paths(); // They may be using the old landmarks
+
+    alt_free(route_landmarks);
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    route_landmarks = alt_build(map, ALT_DEFAULT_LANDMARKS);
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    if (route_landmarks) {
+        printf("Built %d ALT landmarks in %.2f ms (%zu bytes each)\n", alt_landmark_count(route_landmarks),
+            (double)(t1 - t0) * 1000.0 / SDL_GetPerformanceFrequency(), alt_bytes_per_landmark(route_landmarks));
+    }
+    gridmap_free(map);
+}
+
+/**
+ * @brief Writes the grid with its current paths, as drawn, to an image next to the map file.
+ */
+void export_grid_image() {
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return;
+
+    char image_path[1024];
+    SDL_snprintf(image_path, sizeof(image_path), "%s.png", map_path);
+    RasterScene scene = { map, NULL, 0, &grid_path_type[0][0],
+        start_selected ? start : (Point){ -1, -1 }, end_selected ? end : (Point){ -1, -1 }, CELL_SIZE, true };
+    Raster* raster = raster_create(&scene);
+    RasterStats stats;
+    if (raster && raster_write(raster, image_path, RASTER_PNG, 0, &stats))
+        printf("Saved %s (%dx%d) in %.2f ms\n", image_path, raster_width(raster), raster_height(raster), stats.render_ms + stats.write_ms);
+    raster_free(raster);
+    gridmap_free(map);
+}
+
+/**
+ * @brief Loads the contraction hierarchy saved next to the map file, or (if
+ * build is set) contracts the current walls and saves map and hierarchy.
+ */
+void prepare_route_hierarchy(bool build) {
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return;
+
+    char ch_path[1024];
+    SDL_snprintf(ch_path, sizeof(ch_path), "%s.ch", map_path);
+
+    drop_route_hierarchy();
+    route_ch = ch_load(ch_path, map);
+    if (route_ch) {
+        printf("Loaded contraction hierarchy from %s\n", ch_path);
+    }
+    else if (build) {
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        route_ch = ch_build(map);
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        if (route_ch) {
+            printf("Built contraction hierarchy in %.1f ms (%d shortcuts)\n",
+                (double)(t1 - t0) * 1000.0 / SDL_GetPerformanceFrequency(), ch_shortcut_count(route_ch));
+            if (gridmap_save(map, map_path) && ch_save(route_ch, ch_path))
+                printf("Saved %s and %s\n", map_path, ch_path);
+        }
+    }
+    if (route_ch)
+        route_ch_workspace = ch_workspace_create(route_ch);
+    gridmap_free(map);
 }
 
 Point screen_to_grid(int screen_x, int screen_y) {
     Point grid_pos;
-    grid_pos.x = screen_x / CELL_SIZE;
-    grid_pos.y = screen_y / CELL_SIZE;
+    grid_pos.x = (int)SDL_floorf((screen_x - view.offset_x) / view.cell_size);
+    grid_pos.y = (int)SDL_floorf((screen_y - view.offset_y) / view.cell_size);
     return grid_pos;
 }
 
 bool is_valid_position(int x, int y) {
     // A position is valid if it's in bounds AND
     // not a wall AND not already part of any found path
-    // (by checking if grid_path_type is not CELL_EMPTY).
+    // (by checking the query's overlay).
     return (x >= 0 && x < GRID_WIDTH && y >= 0 && y < GRID_HEIGHT &&
         grid[y][x] != CELL_WALL &&
-        grid_path_type[y][x] == CELL_EMPTY); // Check the path_type grid
+        !(query_overlay && block_overlay_test(query_overlay, x, y)));
 }
 
+// Scratch of one dijkstra_find_path() query. Allocated through mem_alloc()
+// rather than kept on the stack, so it shows up in the query's memory stats.
+typedef struct {
+    int dist[GRID_HEIGHT][GRID_WIDTH];
+    bool visited[GRID_HEIGHT][GRID_WIDTH];
+    // Store the parent point for each node to reconstruct the path
+    Point parent[GRID_HEIGHT][GRID_WIDTH];
+    // Priority queue (simple array of nodes to visit)
+    Node* nodes[GRID_WIDTH * GRID_HEIGHT];
+    Point reverse_path[GRID_WIDTH * GRID_HEIGHT];
+} DijkstraWorkspace;
+
 /**
  * @brief Finds the single shortest path using Dijkstra's algorithm.
  * * @return Path struct. cost is -1 if no path is found.
@@ -96,7 +391,7 @@ Path dijkstra_find_path() {
     // so we need a special check for the end node during neighbor exploration.
     if (!is_valid_position(start.x, start.y)) {
         // Check if end is also invalid *for the same reason*
-        if (!is_valid_position(end.x, end.y) && grid_path_type[end.y][end.x] != CELL_EMPTY) {
+        if (!is_valid_position(end.x, end.y) && query_overlay && block_overlay_test(query_overlay, end.x, end.y)) {
             // This is fine, end can be on a path
         }
         else {
@@ -104,11 +399,12 @@ Path dijkstra_find_path() {
         }
     }
 
-
-    int dist[GRID_HEIGHT][GRID_WIDTH];
-    bool visited[GRID_HEIGHT][GRID_WIDTH] = { false };
-    // Store the parent point for each node to reconstruct the path
-    Point parent[GRID_HEIGHT][GRID_WIDTH];
+    DijkstraWorkspace* work = mem_calloc(1, sizeof(DijkstraWorkspace));
+    if (!work)
+        return result_path;
+    int (*dist)[GRID_WIDTH] = work->dist;
+    bool (*visited)[GRID_WIDTH] = work->visited;
+    Point (*parent)[GRID_WIDTH] = work->parent;
 
     // Initialize all distances to infinity and parents to -1
     for (int y = 0; y < GRID_HEIGHT; y++) {
@@ -118,12 +414,11 @@ Path dijkstra_find_path() {
         }
     }
 
-    // Priority queue (simple array of nodes to visit)
-    Node* nodes[GRID_WIDTH * GRID_HEIGHT];
+    Node** nodes = work->nodes;
     int node_count = 0;
 
     // Add start node
-    Node* start_node = malloc(sizeof(Node));
+    Node* start_node = mem_alloc(sizeof(Node));
     start_node->pos = start;
     start_node->cost = 0;
     nodes[node_count++] = start_node;
@@ -151,7 +446,7 @@ Path dijkstra_find_path() {
         int cy = current->pos.y;
 
         if (visited[cy][cx]) {
-            free(current); // Free node, already processed
+            mem_free(current); // Free node, already processed
             continue;
         }
         visited[cy][cx] = true;
@@ -184,7 +479,7 @@ Path dijkstra_find_path() {
                 dist[ny][nx] = new_cost;
                 parent[ny][nx] = (Point){ cx, cy }; // Store parent
 
-                Node* neighbor = malloc(sizeof(Node));
+                Node* neighbor = mem_alloc(sizeof(Node));
                 neighbor->pos.x = nx;
                 neighbor->pos.y = ny;
                 neighbor->cost = new_cost;
@@ -192,7 +487,7 @@ Path dijkstra_find_path() {
                 nodes[node_count++] = neighbor;
             }
         }
-        free(current); // Free processed node
+        mem_free(current); // Free processed node
         current = NULL;
     }
 
@@ -203,7 +498,7 @@ Path dijkstra_find_path() {
         int path_len = 0;
 
         // Store path in reverse (end to start)
-        Point reverse_path[GRID_WIDTH * GRID_HEIGHT];
+        Point* reverse_path = work->reverse_path;
         while (at.x != -1 && at.y != -1) {
             reverse_path[path_len++] = at;
             if (at.x == start.x && at.y == start.y)
@@ -217,85 +512,583 @@ Path dijkstra_find_path() {
             result_path.points[i] = reverse_path[path_len - 1 - i];
         }
 
-        free(current); // Free the end node
+        mem_free(current); // Free the end node
     }
 
     // --- Cleanup ---
     // Free any remaining nodes in the queue (if no path found or loop broken)
     for (int i = 0; i < node_count; i++)
-        free(nodes[i]);
+        mem_free(nodes[i]);
+    mem_free(work);
 
     return result_path;
 }
 
+/**
+ * @brief Same query as dijkstra_find_path, but A* guided by the ALT landmarks.
+ * Cells of earlier paths are blocked through the query's overlay, the end is always allowed.
+ */
+Path alt_find_path() {
+    Path result_path;
+    result_path.length = 0;
+    result_path.cost = -1;
+
+    if (!route_walls)
+        return result_path;
+    const MapSnapshot* snapshot = map_store_acquire(route_walls, route_walls_reader);
+    const GridMap* map = map_snapshot_map(snapshot);
 
-// Draw the grid
-void draw_grid(SDL_Renderer* renderer) {
+    SearchOptions options = { query_overlay, alt_heuristic, route_landmarks, NULL, NULL };
+    PathBuffer buffer = path_buffer_for(&result_path);
+    grid_astar(map, start, end, &options, &buffer, NULL);
+    path_buffer_store(&buffer, &result_path);
+
+    map_snapshot_release(snapshot);
+    return result_path;
+}
+
+/**
+ * @brief A* that skips every move whose goal bounds do not contain the end.
+ * Only exact while no path cells are blocked, so it is used for the first path.
+ */
+Path goal_bounded_find_path() {
+    Path result_path;
+    result_path.length = 0;
+    result_path.cost = -1;
+
+    if (!route_walls)
+        return result_path;
+    const MapSnapshot* snapshot = map_store_acquire(route_walls, route_walls_reader);
+    const GridMap* map = map_snapshot_map(snapshot);
+
+    SearchOptions options = { NULL, grid_manhattan_heuristic, map, goal_bounds_allows, route_goal_bounds };
+    PathBuffer buffer = path_buffer_for(&result_path);
+    grid_astar(map, start, end, &options, &buffer, NULL);
+    path_buffer_store(&buffer, &result_path);
+
+    map_snapshot_release(snapshot);
+    return result_path;
+}
+
+/**
+ * @brief Prints the cost of path i and marks its cells, which blocks them for later paths.
+ * @param search The search that found the path, if the caller still has it;
+ * its runs are then read straight from the search's parents.
+ * @return false if there was no path (the K-loop stops).
+ */
+bool record_path(int i, const Path* path, const GridSearch* search) {
+    if (path->cost == -1) {
+        printf("No more paths found.\n");
+        return false;
+    }
+
+    // Path found! Print cost.
+    printf("  Path %d Cost: %d\n", i + 1, path->cost);
+
+    // Assign the correct CELL_PATH_N type based on iteration
+    CellType current_path_type;
+    switch (i) {
+    case 0: current_path_type = CELL_PATH_1; break;
+    case 1: current_path_type = CELL_PATH_2; break;
+    case 2: current_path_type = CELL_PATH_3; break;
+    case 3: current_path_type = CELL_PATH_4; break;
+    case 4: current_path_type = CELL_PATH_5; break;
+    default: current_path_type = CELL_EMPTY; // Should not happen
+    }
+
+    // Color the path AND block its cells in the query's overlay for future
+    // searches. Start and end are its first and last points and keep their
+    // own type; the rest is stamped as straight runs.
+    static PathRun runs[GRID_WIDTH * GRID_HEIGHT];
+    int run_count = 0;
+    if (path->length > 2 && search)
+        run_count = grid_search_path_runs(search, 1, path->length - 2, runs, GRID_WIDTH * GRID_HEIGHT);
+    else if (path->length > 2)
+        run_count = path_runs_from_points(path->points + 1, path->length - 2, runs, GRID_WIDTH * GRID_HEIGHT);
+    path_runs_stamp(runs, run_count, &grid_path_type[0][0], GRID_WIDTH, current_path_type);
+    for (int r = 0; r < run_count; r++) {
+        for (int y = path_run_first_row(&runs[r]); y <= path_run_last_row(&runs[r]); y++)
+            grid_rows_dirty[y] = true;
+    }
+    if (query_overlay)
+        block_overlay_add_path_inner(query_overlay, path->points, path->length);
+    return true;
+}
+
+/**
+ * @brief Starts the search for path i of the frame-budgeted K-loop.
+ * The search object and the pinned walls are reused for all K paths.
+ */
+void begin_budgeted_path(int i) {
+    if (!budgeted_search && route_walls) {
+        budgeted_snapshot = map_store_acquire(route_walls, route_walls_reader);
+        budgeted_search = grid_search_create(map_snapshot_map(budgeted_snapshot));
+    }
+    if (!budgeted_search) {
+        cancel_budgeted_paths();
+        return;
+    }
+
+    // record_path() only adds to the overlay between searches, never during one
+    const GridMap* map = map_snapshot_map(budgeted_snapshot);
+    SearchOptions options = { query_overlay, grid_manhattan_heuristic, map, NULL, NULL };
+    if (route_landmarks) {
+        options.heuristic = alt_heuristic;
+        options.heuristic_context = route_landmarks;
+    }
+    budgeted_path_index = i;
+    grid_search_begin(budgeted_search, start, end, &options);
+}
+
+/**
+ * @brief Runs the pending K-loop for at most budget_ms, recording each path
+ * as soon as its search completes.
+ */
+void run_budgeted_paths(double budget_ms) {
+    Uint64 begin = SDL_GetPerformanceCounter();
+    while (budgeted_search) {
+        double left = budget_ms - (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+        if (left <= 0.0)
+            return;
+        if (grid_search_step(budgeted_search, 0, left) == SEARCH_RUNNING)
+            return;
+
+        Path path;
+        PathBuffer buffer = path_buffer_for(&path);
+        grid_search_path(budgeted_search, &buffer);
+        path_buffer_store(&buffer, &path);
+        if (record_path(budgeted_path_index, &path, budgeted_search) && budgeted_path_index + 1 < K_PATHS) {
+            begin_budgeted_path(budgeted_path_index + 1);
+        }
+        else {
+            cancel_budgeted_paths();
+            printf("----------------------------------------\n");
+            printf("Path search complete.\n");
+        }
+    }
+}
+
+// One slice of a pool K-loop: continues the current search, starting the next path when one is found
+bool path_job_step(PoolTask* task, double budget_ms) {
+    PathJob* job = (PathJob*)task;
+    Uint64 begin = SDL_GetPerformanceCounter();
+    for (;;) {
+        double left = budget_ms - (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+        if (left <= 0.0)
+            return false;
+        SearchStatus status = grid_search_step(job->search, 0, left);
+        if (status == SEARCH_RUNNING)
+            return false;
+        if (status == SEARCH_NO_PATH)
+            return true;
+
+        Path* path = &job->paths[job->found++];
+        PathBuffer buffer = path_buffer_for(path);
+        grid_search_path(job->search, &buffer);
+        path_buffer_store(&buffer, path);
+        if (job->found == K_PATHS || !block_overlay_add_path_inner(job->overlay, path->points, path->length))
+            return true;
+        grid_search_begin(job->search, job->from, job->to, &job->options);
+    }
+}
+
+/**
+ * @brief Hands the K-loop of the bound session to the shared worker pool.
+ * @return false if that is not possible (the caller searches inline instead).
+ */
+bool submit_pool_paths() {
+    if (!search_pool || pool_queue < 0 || !route_walls)
+        return false;
+    PathJob* job = calloc(1, sizeof(PathJob));
+    if (!job)
+        return false;
+    job->snapshot = map_store_acquire(route_walls, route_walls_reader);
+    job->search = grid_search_create(map_snapshot_map(job->snapshot));
+    job->overlay = block_overlay_create(GRID_WIDTH, GRID_HEIGHT);
+    if (!job->search || !job->overlay) {
+        grid_search_free(job->search);
+        map_snapshot_release(job->snapshot);
+        block_overlay_free(job->overlay);
+        free(job);
+        return false;
+    }
+
+    // Same engines as the inline loop: ALT with landmarks, Dijkstra without
+    SearchOptions options = { job->overlay, NULL, NULL, NULL, NULL };
+    if (route_landmarks) {
+        options.heuristic = alt_heuristic;
+        options.heuristic_context = route_landmarks;
+    }
+    job->options = options;
+    job->from = start;
+    job->to = end;
+    grid_search_begin(job->search, start, end, &job->options);
+    pool_job = job;
+    task_pool_submit(search_pool, pool_queue, &job->task, path_job_step);
+    return true;
+}
+
+// Records the paths of a finished pool K-loop into the bound session
+void collect_pool_paths() {
+    if (!pool_job || !task_pool_finished(&pool_job->task))
+        return;
+    PathJob* job = pool_job;
+    int i = 0;
+    for (; i < job->found; i++)
+        record_path(i, &job->paths[i], NULL);
+    if (i < K_PATHS)
+        printf("No more paths found.\n");
+    printf("----------------------------------------\n");
+    printf("Path search complete.\n");
+    cancel_pool_paths();
+}
+
+// Creates the bound session's grid texture on first use
+bool create_grid_texture(SDL_Renderer* renderer) {
+    if (grid_texture)
+        return true;
+
+    grid_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, GRID_WIDTH, GRID_HEIGHT);
+    if (!grid_texture) {
+        fprintf(stderr, "Grid texture creation failed: %s\n", SDL_GetError());
+        return false;
+    }
+    // Nearest filtering keeps every cell a solid square at any zoom
+    SDL_SetTextureScaleMode(grid_texture, SDL_SCALEMODE_NEAREST);
+    mark_grid_dirty();
+    return true;
+}
+
+// Uploads each run of dirty rows with one lock. Locked texels are write-only,
+// so a lock never spans a clean row.
+void update_grid_texture() {
+    for (int y = 0; y < GRID_HEIGHT;) {
+        if (!grid_rows_dirty[y]) {
+            y++;
+            continue;
+        }
+        int rows = 1;
+        while (y + rows < GRID_HEIGHT && grid_rows_dirty[y + rows])
+            rows++;
+
+        SDL_Rect rect = { 0, y, GRID_WIDTH, rows };
+        void* pixels;
+        int pitch;
+        if (!SDL_LockTexture(grid_texture, &rect, &pixels, &pitch))
+            return;
+        for (int r = 0; r < rows; r++) {
+            Uint8 states[GRID_WIDTH];
+            for (int x = 0; x < GRID_WIDTH; x++)
+                states[x] = cell_state(grid[y + r][x], grid_path_type[y + r][x]);
+            palette_map_row(states, GRID_WIDTH, (Uint32*)((Uint8*)pixels + r * pitch));
+            grid_rows_dirty[y + r] = false;
+        }
+        SDL_UnlockTexture(grid_texture);
+        y += rows;
+    }
+}
+
+/**
+ * @brief Redraws the grid line texture if the viewport or window size changed.
+ * The lines are where SDL_RenderRect outlined each cell: the first and last
+ * pixel column and row of every cell.
+ * @return false if there is nothing to composite.
+ */
+bool update_grid_lines(SDL_Renderer* renderer) {
+    int width, height;
+    if (!SDL_GetRenderOutputSize(renderer, &width, &height) || width <= 0 || height <= 0)
+        return false;
+
+    if (!grid_lines.texture || grid_lines.width != width || grid_lines.height != height) {
+        SDL_DestroyTexture(grid_lines.texture);
+        grid_lines.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!grid_lines.texture)
+            return false;
+        SDL_SetTextureBlendMode(grid_lines.texture, SDL_BLENDMODE_BLEND);
+        grid_lines.width = width;
+        grid_lines.height = height;
+        grid_lines.view.cell_size = 0.0f;
+    }
+    if (grid_lines.view.cell_size == view.cell_size && grid_lines.view.offset_x == view.offset_x &&
+        grid_lines.view.offset_y == view.offset_y)
+        return true;
+
+    SDL_SetRenderTarget(renderer, grid_lines.texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    SDL_Color line_color = palette_active()->grid_line;
+    SDL_SetRenderDrawColor(renderer, line_color.r, line_color.g, line_color.b, line_color.a);
+    float left = view.offset_x, top = view.offset_y;
+    float right = left + GRID_WIDTH * view.cell_size - 1.0f;
+    float bottom = top + GRID_HEIGHT * view.cell_size - 1.0f;
+    for (int x = 0; x < GRID_WIDTH; x++) {
+        SDL_RenderLine(renderer, left + x * view.cell_size, top, left + x * view.cell_size, bottom);
+        SDL_RenderLine(renderer, left + (x + 1) * view.cell_size - 1.0f, top, left + (x + 1) * view.cell_size - 1.0f, bottom);
+    }
     for (int y = 0; y < GRID_HEIGHT; y++) {
-        for (int x = 0; x < GRID_WIDTH; x++) {
-            SDL_FRect cell_rect = { (float)x * CELL_SIZE, (float)y * CELL_SIZE, (float)CELL_SIZE, (float)CELL_SIZE };
+        SDL_RenderLine(renderer, left, top + y * view.cell_size, right, top + y * view.cell_size);
+        SDL_RenderLine(renderer, left, top + (y + 1) * view.cell_size - 1.0f, right, top + (y + 1) * view.cell_size - 1.0f);
+    }
+    SDL_SetRenderTarget(renderer, NULL);
+    grid_lines.view = view;
+    return true;
+}
 
-            // Default color for non-path cells
-            SDL_Color cell_color = { 200, 200, 200, 255 }; // Empty
+// Draw the grid: two draw calls whatever the number of cells
+void draw_grid(SDL_Renderer* renderer) {
+    if (!create_grid_texture(renderer))
+        return;
+    if (grid_palette_generation != palette_generation()) {
+        // Another palette was selected: every pixel is stale
+        grid_palette_generation = palette_generation();
+        mark_grid_dirty();
+        grid_lines.view.cell_size = 0.0f;
+    }
+    update_grid_texture();
 
-            switch (grid[y][x]) {
-            case CELL_EMPTY:
-                // Handled by default cell_color
-                break;
-            case CELL_WALL:
-                cell_color = (SDL_Color){ 50, 50, 50, 255 };
-                break;
-            case CELL_START:
-                cell_color = (SDL_Color){ 0, 255, 0, 255 }; // Green
-                break;
-            case CELL_END:
-                cell_color = (SDL_Color){ 255, 0, 0, 255 }; // Red
-                break;
-                // No default CELL_PATH here, rely on grid_path_type for paths
-            default: // Should not happen for grid[][] if only walls/empty/start/end
-                break;
-            }
+    SDL_FRect grid_rect = { view.offset_x, view.offset_y, GRID_WIDTH * view.cell_size, GRID_HEIGHT * view.cell_size };
+    SDL_RenderTexture(renderer, grid_texture, NULL, &grid_rect);
+    if (view.cell_size >= GRID_LINE_MIN_CELL_SIZE && update_grid_lines(renderer))
+        SDL_RenderTexture(renderer, grid_lines.texture, NULL, NULL);
+}
 
-            // Check the grid_path_type for path segments
-            // Colors are from the user-provided palette
-            // Shortest (Path 1) = Darkest Blue
-            // Longest (Path 5) = Lightest Blue
-            switch (grid_path_type[y][x]) {
-            case CELL_PATH_1: cell_color = (SDL_Color){ 2, 136, 209, 255 }; break;   // Darkest
-            case CELL_PATH_2: cell_color = (SDL_Color){ 41, 182, 246, 255 }; break;
-            case CELL_PATH_3: cell_color = (SDL_Color){ 129, 212, 250, 255 }; break;
-            case CELL_PATH_4: cell_color = (SDL_Color){ 179, 229, 252, 255 }; break;
-            case CELL_PATH_5: cell_color = (SDL_Color){ 224, 247, 250, 255 }; break; // Lightest
-            default: break; // No path segment or already handled by grid[][]
-            }
+/**
+ * @brief Earliest arrival from start to end through the timed doors, drawn
+ * like the first path and then played back step by step.
+ */
+void find_timed_path() {
+    int capacity = SCHEDULE_HORIZON + GRID_WIDTH * GRID_HEIGHT;
+    SippPath timed = { malloc(sizeof(TimedPoint) * capacity), capacity, 0, -1, 0 };
+    if (!timed.points)
+        return;
+
+    printf("Finding the earliest arrival through the timed doors...\n");
+    printf("----------------------------------------\n");
+    SearchStats stats;
+    if (!sipp_find_path(route_doors, start, end, 0, &timed, &stats)) {
+        free(timed.points);
+        printf("No more paths found.\n");
+        return;
+    }
+
+    // The cells walked through, without the waits
+    Path path;
+    path.length = 0;
+    for (int i = 0; i < timed.length && path.length < GRID_WIDTH * GRID_HEIGHT; i++) {
+        Point p = timed.points[i].point;
+        if (path.length == 0 || path.points[path.length - 1].x != p.x || path.points[path.length - 1].y != p.y)
+            path.points[path.length++] = p;
+    }
+    path.cost = path.length - 1;
+    record_path(0, &path, NULL);
+    printf("    Arrives at step %d after %d waits (%d safe intervals expanded)\n", timed.arrival, timed.waits, stats.expanded);
+    printf("----------------------------------------\n");
+
+    clear_schedule();
+    schedule_path = timed.points;
+    schedule_length = timed.length;
+    schedule_started = SDL_GetTicks();
+}
 
-            SDL_SetRenderDrawColor(renderer, cell_color.r, cell_color.g, cell_color.b, cell_color.a);
-            SDL_RenderFillRect(renderer, &cell_rect);
-            SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255); // Grid lines
-            SDL_RenderRect(renderer, &cell_rect);
+// Doors and the agent at the current step, on top of the grid. Without a
+// path the doors just cycle; with one its playback repeats after a pause.
+void draw_schedule(SDL_Renderer* renderer) {
+    if (!route_doors)
+        return;
+    Uint64 now = SDL_GetTicks();
+    int time;
+    int index = -1;
+    if (schedule_path) {
+        Uint64 step = (now - schedule_started) * SCHEDULE_STEPS_PER_SECOND / 1000;
+        index = (int)(step % (Uint64)(schedule_length + SCHEDULE_STEPS_PER_SECOND));
+        if (index >= schedule_length)
+            index = schedule_length - 1;
+        time = schedule_path[index].time;
+    }
+    else {
+        time = (int)(now * SCHEDULE_STEPS_PER_SECOND / 1000 % SCHEDULE_HORIZON);
+    }
+
+    static SDL_FRect closed[GRID_WIDTH * GRID_HEIGHT];
+    static SDL_FRect open[GRID_WIDTH * GRID_HEIGHT];
+    int closed_count = 0, open_count = 0;
+    float size = view.cell_size;
+    for (int i = 0; i < door_block_count; i++) {
+        Point cell = door_blocks[i].cell;
+        if (i > 0 && door_blocks[i - 1].cell.x == cell.x && door_blocks[i - 1].cell.y == cell.y)
+            continue; // Same door
+        if (grid[cell.y][cell.x] == CELL_WALL)
+            continue;
+        SDL_FRect rect = { view.offset_x + cell.x * size, view.offset_y + cell.y * size, size, size };
+        if (sipp_cell_free(route_doors, cell, time)) {
+            float inset = size * 0.15f;
+            open[open_count++] = (SDL_FRect){ rect.x + inset, rect.y + inset, size - 2 * inset, size - 2 * inset };
         }
+        else {
+            closed[closed_count++] = rect;
+        }
+    }
+
+    const Palette* palette = palette_active();
+    SDL_SetRenderDrawColor(renderer, palette->door.r, palette->door.g, palette->door.b, palette->door.a);
+    SDL_RenderFillRects(renderer, closed, closed_count);
+    SDL_RenderRects(renderer, open, open_count);
+    if (index >= 0) {
+        Point at = schedule_path[index].point;
+        float inset = size * 0.25f;
+        SDL_FRect agent = { view.offset_x + at.x * size + inset, view.offset_y + at.y * size + inset, size - 2 * inset, size - 2 * inset };
+        SDL_SetRenderDrawColor(renderer, palette->agent.r, palette->agent.g, palette->agent.b, palette->agent.a);
+        SDL_RenderFillRect(renderer, &agent);
     }
 }
 
+// Live preview: once the start is chosen, the shortest path to the cell under
+// the mouse. Motion events only note the cell; the main loop answers the
+// latest one once per frame, so a burst of events costs one query. Answers
+// come from the cached start tree, which is grown for at most HOVER_BUDGET_MS
+// a frame: the hovered cell first, then the rest of the map, so later hovers
+// (and the end click) are mostly path extractions.
+#define HOVER_BUDGET_MS 4.0
+Point hover_cell = { -1, -1 };
+Path hover_path; // length 0 while there is nothing to show
+
+void update_hover_preview(double budget_ms) {
+    hover_path.length = 0;
+    if (!start_selected || route_doors || hover_cell.x < 0 || (hover_cell.x == start.x && hover_cell.y == start.y) ||
+        (end_selected && hover_cell.x == end.x && hover_cell.y == end.y))
+        return;
+    SearchTree* tree = acquire_start_tree();
+    if (!tree)
+        return;
+
+    Uint64 begin = SDL_GetPerformanceCounter();
+    // Extracted again every frame, so it always matches the start and walls of the tree
+    if (search_tree_grow(tree, hover_cell, 0, budget_ms) == SEARCH_FOUND) {
+        PathBuffer buffer = path_buffer_for(&hover_path);
+        search_tree_path(tree, hover_cell, &buffer);
+        path_buffer_store(&buffer, &hover_path);
+    }
+    double left = budget_ms - (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+    if (left > 0.0)
+        search_tree_grow(tree, (Point){ -1, -1 }, 0, left);
+}
+
+// The preview path on top of the grid, with the hovered cell outlined
+void draw_hover_preview(SDL_Renderer* renderer) {
+    if (hover_path.length < 2)
+        return;
+    static SDL_FRect cells[GRID_WIDTH * GRID_HEIGHT];
+    float size = view.cell_size;
+    float inset = size * 0.35f;
+    int count = 0;
+    for (int i = 1; i < hover_path.length - 1; i++) {
+        Point p = hover_path.points[i];
+        cells[count++] = (SDL_FRect){ view.offset_x + p.x * size + inset, view.offset_y + p.y * size + inset, size - 2 * inset, size - 2 * inset };
+    }
+    Point last = hover_path.points[hover_path.length - 1];
+    SDL_FRect target = { view.offset_x + last.x * size + 1.0f, view.offset_y + last.y * size + 1.0f, size - 2.0f, size - 2.0f };
+
+    SDL_Color color = palette_active()->preview;
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderFillRects(renderer, cells, count);
+    SDL_RenderRect(renderer, &target);
+}
+
+// Erases one path cell of the query from the composite
+void clear_path_cell(void* context, int x, int y) {
+    (void)context;
+    grid_path_type[y][x] = CELL_EMPTY;
+    grid_rows_dirty[y] = true;
+}
+
+// Cancels the query's searches and erases its paths (only the cells they cover)
+void clear_query_paths() {
+    cancel_pending_paths();
+    clear_schedule();
+    if (query_overlay) {
+        block_overlay_visit(query_overlay, clear_path_cell, NULL);
+        block_overlay_clear(query_overlay);
+    }
+}
+
+/**
+ * @brief Path i of the inline K-loop, with the paths before it blocked in
+ * query_overlay. Path 1 comes from the preprocessed data or from the cached
+ * start tree (NULL if there is none), which pops in dijkstra_find_path()'s
+ * order. The later paths are a dijkstra_find_path() each: a repaired tree or
+ * another engine could pick a different path among equally short ones, and
+ * with it different paths after it.
+ * @param report Print whether the start tree had settled the end already.
+ */
+Path find_kloop_path(int i, SearchTree* cached, bool report) {
+    Path path;
+    if (i == 0 && route_ch_workspace) {
+        // Nothing is blocked yet, so the preprocessed hierarchy is still exact.
+        // Later paths depend on the cells blocked so far and need a full search.
+        PathBuffer buffer = path_buffer_for(&path);
+        ch_find_path(route_ch, route_ch_workspace, start, end, &buffer);
+        path_buffer_store(&buffer, &path);
+    }
+    else if (i == 0 && route_cpd) {
+        PathBuffer buffer = path_buffer_for(&path);
+        cpd_find_path(route_cpd, start, end, &buffer);
+        path_buffer_store(&buffer, &path);
+    }
+    else if (i == 0 && route_goal_bounds) {
+        path = goal_bounded_find_path();
+    }
+    else if (route_landmarks) {
+        path = alt_find_path();
+    }
+    else if (i == 0 && cached) {
+        bool settled = search_tree_distance(cached, end) >= 0;
+        int expanded = search_tree_stats(cached).expanded;
+        PathBuffer buffer = path_buffer_for(&path);
+        search_tree_grow(cached, end, 0, 0.0);
+        search_tree_path(cached, end, &buffer);
+        path_buffer_store(&buffer, &path);
+        if (report) {
+            printf("    Start tree: %s (%d cells expanded)\n",
+                settled ? "end settled already" : "frontier resumed", search_tree_stats(cached).expanded - expanded);
+        }
+    }
+    else {
+        path = dijkstra_find_path();
+    }
+    return path;
+}
+
 void handle_click(int x, int y) {
     Point grid_pos = screen_to_grid(x, y);
 
     if (grid_pos.x < 0 || grid_pos.x >= GRID_WIDTH || grid_pos.y < 0 || grid_pos.y >= GRID_HEIGHT)
         return;
 
-    // Prevent clicks if pathfinding is done. Must reset.
-    if (paths_found_and_drawn) {
-        printf("Paths already found. Press 'C' or 'R' to reset.\n");
-        return;
-    }
-
     // Special check: don't allow clicking on a wall
     if (grid[grid_pos.y][grid_pos.x] == CELL_WALL)
         return;
 
+    // Once the paths are drawn, a click moves the end and keeps the start
+    if (paths_found_and_drawn) {
+        if (grid_pos.x == start.x && grid_pos.y == start.y) {
+            printf("Paths already found. Click a new end, or press 'C' or 'R' to reset.\n");
+            return;
+        }
+        clear_query_paths();
+        if (end.x >= 0) {
+            grid[end.y][end.x] = CELL_EMPTY;
+            grid_path_type[end.y][end.x] = CELL_EMPTY;
+            grid_rows_dirty[end.y] = true;
+        }
+        end.x = end.y = -1;
+        end_selected = false;
+        paths_found_and_drawn = false;
+    }
+
     if (!start_selected) {
         start = grid_pos;
         grid[start.y][start.x] = CELL_START;
+        grid_rows_dirty[start.y] = true;
         start_selected = true;
         printf("Start set at (%d, %d)\n", start.x, start.y);
     }
@@ -303,49 +1096,44 @@ void handle_click(int x, int y) {
         if (!(grid_pos.x == start.x && grid_pos.y == start.y)) {
             end = grid_pos;
             grid[end.y][end.x] = CELL_END;
+            grid_rows_dirty[end.y] = true;
             end_selected = true;
             printf("End set at (%d, %d)\n", end.x, end.y);
 
             paths_found_and_drawn = true; // Mark that we are starting the process
 
+            if (route_components && !components_connected(route_components, start, end)) {
+                printf("End is not reachable from start (%d separate areas).\n", components_count(route_components));
+                printf("No more paths found.\n");
+                return;
+            }
+            if (route_doors) {
+                find_timed_path();
+                return;
+            }
+
             printf("Finding %d shortest disjoint paths...\n", K_PATHS);
             printf("----------------------------------------\n");
+            if (frame_budgeted_search) {
+                begin_budgeted_path(0); // Continued by the main loop
+                return;
+            }
+            if (session_count > 1 && submit_pool_paths())
+                return; // Collected by the main loop once the pool is done
 
+            SearchTree* cached = !route_landmarks ? acquire_start_tree() : NULL;
             for (int i = 0; i < K_PATHS; i++) {
-                Path path = dijkstra_find_path();
-
-                if (path.cost == -1) {
-                    printf("No more paths found.\n");
+                MemScope memory;
+                mem_scope_begin(&memory);
+                Path path = find_kloop_path(i, cached, true);
+                mem_scope_end(&memory);
+
+                bool found = record_path(i, &path, NULL);
+                printf("    Memory: peak %lld bytes, %llu allocations, %llu frees, %lld bytes kept\n",
+                    memory.peak_bytes, (unsigned long long)memory.allocations, (unsigned long long)memory.frees,
+                    memory.current_bytes);
+                if (!found)
                     break;
-                }
-
-                // Path found! Print cost.
-                printf("  Path %d Cost: %d\n", i + 1, path.cost);
-
-                // Assign the correct CELL_PATH_N type based on iteration
-                CellType current_path_type;
-                switch (i) {
-                case 0: current_path_type = CELL_PATH_1; break;
-                case 1: current_path_type = CELL_PATH_2; break;
-                case 2: current_path_type = CELL_PATH_3; break;
-                case 3: current_path_type = CELL_PATH_4; break;
-                case 4: current_path_type = CELL_PATH_5; break;
-                default: current_path_type = CELL_EMPTY; // Should not happen
-                }
-
-                // Iterate through path to color it AND turn nodes into "walls" for future searches
-                for (int p_idx = 0; p_idx < path.length; p_idx++) {
-                    Point p = path.points[p_idx];
-
-                    // Don't change start or end nodes
-                    if ((p.x == start.x && p.y == start.y) || (p.x == end.x && p.y == end.y))
-                        continue;
-
-                    // Set to current_path_type.
-                    // This colors it the correct shade of blue (via draw_grid)
-                    // AND makes it invalid for the next search (via is_valid_position)
-                    grid_path_type[p.y][p.x] = current_path_type;
-                }
             }
             printf("----------------------------------------\n");
             printf("Path search complete.\n");
@@ -354,14 +1142,17 @@ void handle_click(int x, int y) {
 }
 
 void reset_grid() {
-    for (int y = 0; y < GRID_HEIGHT; y++) {
-        for (int x = 0; x < GRID_WIDTH; x++) {
-            // Only reset non-wall cells on the main grid
-            if (grid[y][x] != CELL_WALL)
-                grid[y][x] = CELL_EMPTY;
-            // Always reset the path type grid
-            grid_path_type[y][x] = CELL_EMPTY;
-        }
+    // Only the cells the query touched: its paths and the endpoints
+    clear_query_paths();
+    const Point endpoints[2] = { start, end };
+    for (int i = 0; i < 2; i++) {
+        Point p = endpoints[i];
+        if (p.x < 0 || p.y < 0)
+            continue;
+        if (grid[p.y][p.x] != CELL_WALL)
+            grid[p.y][p.x] = CELL_EMPTY;
+        grid_path_type[p.y][p.x] = CELL_EMPTY;
+        grid_rows_dirty[p.y] = true;
     }
 
     start_selected = false;
@@ -371,44 +1162,564 @@ void reset_grid() {
     end.x = end.y = -1;
 }
 
-int main(int argc, char* argv[]) {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
-        return 1;
+// 'T': puts random timed doors on the walkable cells, or removes them
+void toggle_timed_doors() {
+    reset_grid(); // Paths found without the doors no longer apply
+    if (door_blocks) {
+        mem_free(door_blocks);
+        door_blocks = NULL;
+        door_block_count = 0;
+        rebuild_route_doors(NULL);
+        printf("Timed doors off.\n");
+        return;
+    }
+
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return;
+    door_blocks = sipp_random_doors(map, DOOR_PERCENT, SCHEDULE_HORIZON, (unsigned int)SDL_GetTicks() + 1, &door_block_count);
+    rebuild_route_doors(map);
+    gridmap_free(map);
+    if (route_doors) {
+        printf("Timed doors on: %d closed windows, %d safe intervals. Pick start and end for the earliest arrival.\n",
+            door_block_count, sipp_interval_count(route_doors));
+    }
+}
+
+/**
+ * @brief Applies a batch of wall edits to the bound session. Everything built
+ * on the walls is updated from the change set instead of being rebuilt.
+ * @return The number of cells that changed, -1 on failure.
+ */
+int apply_wall_edits(const MapEdit* edits, int count) {
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return -1;
+    MapChangeSet changes;
+    map_changes_init(&changes);
+    bool ok = map_edits_apply(map, edits, count, &changes);
+    int changed = changes.count;
+
+    if (changed > 0) {
+        // Paths and endpoints were chosen on the old walls
+        if (start_selected)
+            reset_grid();
+        for (int i = 0; i < changes.count; i++) {
+            int x = changes.cells[i] % GRID_WIDTH, y = changes.cells[i] / GRID_WIDTH;
+            grid[y][x] = map->walls[changes.cells[i]] ? CELL_WALL : CELL_EMPTY;
+            grid_rows_dirty[y] = true;
+        }
+
+        // Only the tiles holding changed cells are copied
+        if (!route_walls || !map_edits_publish(route_walls, map, &changes))
+            publish_grid_walls();
+        int relabelled = 0;
+        if (route_components && !components_update(route_components, map, &changes, &relabelled)) {
+            components_free(route_components);
+            route_components = components_build(map);
+        }
+
+        // Hierarchy, database and goal bounds encode exact shortest paths, so
+        // any change makes them stale. Landmark distances stay lower bounds
+        // while walls are only added.
+        drop_route_hierarchy();
+        cpd_close(route_cpd);
+        route_cpd = NULL;
+        goal_bounds_free(route_goal_bounds);
+        route_goal_bounds = NULL;
+        if (changes.removed > 0) {
+            alt_free(route_landmarks);
+            route_landmarks = NULL;
+        }
+        if (door_blocks)
+            rebuild_route_doors(map);
+
+        printf("Wall edits: %d cells changed (%d walls added, %d removed), generation %llu, %d cells relabelled\n",
+            changed, changes.added, changes.removed, (unsigned long long)changes.generation, relabelled);
+    }
+
+    map_changes_free(&changes);
+    gridmap_free(map);
+    return ok ? changed : -1;
+}
+
+/**
+ * @brief Memory-maps the path database saved next to the map file, or (if
+ * build is set) builds it on all cores and saves map and database.
+ */
+void prepare_path_database(bool build) {
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return;
+
+    char cpd_path[1024];
+    SDL_snprintf(cpd_path, sizeof(cpd_path), "%s.cpd", map_path);
+
+    cpd_close(route_cpd);
+    route_cpd = cpd_open(cpd_path, map);
+    if (route_cpd) {
+        printf("Mapped path database %s\n", cpd_path);
+    }
+    else if (build) {
+        CpdBuildStats stats;
+        if (gridmap_save(map, map_path) && cpd_build_file(map, cpd_path, 0, &stats)) {
+            printf("Built path database in %.1f ms on %d threads (%llu runs), saved %s\n",
+                stats.build_ms, stats.thread_count, (unsigned long long)stats.run_count, cpd_path);
+            route_cpd = cpd_open(cpd_path, map);
+        }
+    }
+    gridmap_free(map);
+}
+
+/**
+ * @brief Loads the goal bounds saved next to the map file, or (if build is
+ * set) computes them on all cores and saves map and bounds.
+ */
+void prepare_goal_bounds(bool build) {
+    GridMap* map = gridmap_from_grid();
+    if (!map)
+        return;
+
+    char gb_path[1024];
+    SDL_snprintf(gb_path, sizeof(gb_path), "%s.gb", map_path);
+
+    goal_bounds_free(route_goal_bounds);
+    route_goal_bounds = goal_bounds_load(gb_path, map);
+    if (route_goal_bounds) {
+        printf("Loaded goal bounds from %s\n", gb_path);
+    }
+    else if (build) {
+        GoalBoundsBuildStats stats;
+        route_goal_bounds = goal_bounds_build(map, 0, &stats);
+        if (route_goal_bounds) {
+            printf("Built goal bounds in %.1f ms on %d threads (%zu bytes)\n", stats.build_ms, stats.thread_count, stats.bytes);
+            if (gridmap_save(map, map_path) && goal_bounds_save(route_goal_bounds, gb_path))
+                printf("Saved %s and %s\n", map_path, gb_path);
+        }
+    }
+    gridmap_free(map);
+}
+
+bool load_map_into_grid(const char* path) {
+    GridMap* map = gridmap_load(path);
+    if (!map)
+        return false;
+    if (map->width != GRID_WIDTH || map->height != GRID_HEIGHT) {
+        fprintf(stderr, "%s is %dx%d, the visualizer needs %dx%d.\n", path, map->width, map->height, GRID_WIDTH, GRID_HEIGHT);
+        gridmap_free(map);
+        return false;
     }
 
-    SDL_Window* window = SDL_CreateWindow(
-        "SDL3 K-Shortest Paths Visualizer (Dijkstra)",
-        GRID_WIDTH * CELL_SIZE,
-        GRID_HEIGHT * CELL_SIZE,
-        0
-    );
+    // One masked edit, so only what differs from the current walls is redone
+    reset_grid();
+    MapEdit edit = { MAP_EDIT_ASSIGN, 0, 0, GRID_WIDTH, GRID_HEIGHT, map->walls };
+    apply_wall_edits(&edit, 1);
+    gridmap_free(map);
+    map_path = path;
+    prepare_route_hierarchy(false);
+    prepare_path_database(false);
+    prepare_goal_bounds(false);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Map sessions: one window, map and set of search structures each
+// ----------------------------------------------------------------------------
+
+#define MAX_SESSIONS 16
+#define WINDOW_TITLE "SDL3 K-Shortest Paths Visualizer (Dijkstra)"
+
+// Per-map state besides the grids. The visualizer code above works on the
+// globals; session_bind() loads a session into them and session_unbind()
+// stores them back, so exactly one session is bound while it is handled.
+#define SESSION_STATE(X) \
+    X(Point, start) X(Point, end) \
+    X(bool, start_selected) X(bool, end_selected) X(bool, paths_found_and_drawn) \
+    X(const char*, map_path) \
+    X(ContractionHierarchy*, route_ch) X(ChWorkspace*, route_ch_workspace) \
+    X(CompressedPathDb*, route_cpd) X(GoalBounds*, route_goal_bounds) X(AltLandmarks*, route_landmarks) \
+    X(MapStore*, route_walls) X(int, route_walls_reader) X(MapComponents*, route_components) \
+    X(SippBlock*, door_blocks) X(int, door_block_count) X(SippMap*, route_doors) \
+    X(TimedPoint*, schedule_path) X(int, schedule_length) X(Uint64, schedule_started) \
+    X(GridSearch*, budgeted_search) X(const MapSnapshot*, budgeted_snapshot) X(int, budgeted_path_index) \
+    X(PathJob*, pool_job) X(int, pool_queue) X(BlockOverlay*, query_overlay) \
+    X(SearchTree*, start_tree) X(const MapSnapshot*, start_tree_snapshot) X(Point, hover_cell) X(Path, hover_path) \
+    X(Viewport, view) X(SDL_Texture*, grid_texture) X(GridLineCache, grid_lines) \
+    X(unsigned int, grid_palette_generation)
+
+typedef struct {
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    SDL_WindowID window_id;
+
+    CellType grid[GRID_HEIGHT][GRID_WIDTH];
+    CellType grid_path_type[GRID_HEIGHT][GRID_WIDTH];
+    bool grid_rows_dirty[GRID_HEIGHT];
+#define SESSION_FIELD(type, name) type name;
+    SESSION_STATE(SESSION_FIELD)
+#undef SESSION_FIELD
+} MapSession;
+
+MapSession* sessions[MAX_SESSIONS];
+
+void session_bind(const MapSession* session) {
+    memcpy(grid, session->grid, sizeof(grid));
+    memcpy(grid_path_type, session->grid_path_type, sizeof(grid_path_type));
+    memcpy(grid_rows_dirty, session->grid_rows_dirty, sizeof(grid_rows_dirty));
+#define SESSION_LOAD(type, name) name = session->name;
+    SESSION_STATE(SESSION_LOAD)
+#undef SESSION_LOAD
+}
+
+void session_unbind(MapSession* session) {
+    memcpy(session->grid, grid, sizeof(grid));
+    memcpy(session->grid_path_type, grid_path_type, sizeof(grid_path_type));
+    memcpy(session->grid_rows_dirty, grid_rows_dirty, sizeof(grid_rows_dirty));
+#define SESSION_STORE(type, name) session->name = name;
+    SESSION_STATE(SESSION_STORE)
+#undef SESSION_STORE
+}
+
+/**
+ * @brief Opens a window with a random grid, or with the map in map_file.
+ * No session may be bound while this is called.
+ */
+MapSession* session_open(const char* map_file) {
+    if (session_count == MAX_SESSIONS)
+        return NULL;
+    MapSession* session = calloc(1, sizeof(MapSession));
+    if (!session)
+        return NULL;
+
+    // From the second window on, K-loops run on a shared pool, one fair queue per session
+    if (session_count > 0 && !search_pool) {
+        search_pool = task_pool_create(0, 2.0);
+        for (int i = 0; search_pool && i < session_count; i++)
+            sessions[i]->pool_queue = task_pool_add_queue(search_pool);
+    }
 
-    if (!window) {
+    char title[256];
+    if (map_file)
+        SDL_snprintf(title, sizeof(title), "%s - %s", WINDOW_TITLE, map_file);
+    else
+        SDL_snprintf(title, sizeof(title), "%s", WINDOW_TITLE);
+    session->window = SDL_CreateWindow(title, GRID_WIDTH * CELL_SIZE, GRID_HEIGHT * CELL_SIZE, 0);
+    if (!session->window) {
         fprintf(stderr, "Window creation failed: %s\n", SDL_GetError());
-        SDL_Quit();
+        free(session);
+        return NULL;
+    }
+    session->renderer = SDL_CreateRenderer(session->window, NULL);
+    if (!session->renderer) {
+        fprintf(stderr, "Renderer creation failed: %s\n", SDL_GetError());
+        SDL_DestroyWindow(session->window);
+        free(session);
+        return NULL;
+    }
+    session->window_id = SDL_GetWindowID(session->window);
+    session->query_overlay = block_overlay_create(GRID_WIDTH, GRID_HEIGHT);
+    if (!session->query_overlay) {
+        fprintf(stderr, "Out of memory for the query overlay.\n");
+        SDL_DestroyRenderer(session->renderer);
+        SDL_DestroyWindow(session->window);
+        free(session);
+        return NULL;
+    }
+
+    session->start = session->end = session->hover_cell = (Point){ -1, -1 };
+    session->map_path = "grid.map";
+    session->route_walls_reader = -1;
+    session->pool_queue = search_pool ? task_pool_add_queue(search_pool) : -1;
+    session->view = (Viewport){ CELL_SIZE, 0.0f, 0.0f };
+
+    session_bind(session);
+    initialize_grid();
+    if (map_file)
+        load_map_into_grid(map_file);
+    session_unbind(session);
+
+    sessions[session_count++] = session;
+    return session;
+}
+
+// Frees everything the session owns. No session may be bound while this is called.
+void session_close(MapSession* session) {
+    session_bind(session);
+    cancel_pending_paths();
+    drop_start_tree();
+    drop_route_hierarchy();
+    alt_free(route_landmarks);
+    cpd_close(route_cpd);
+    goal_bounds_free(route_goal_bounds);
+    map_store_unregister_reader(route_walls, route_walls_reader);
+    map_store_destroy(route_walls);
+    components_free(route_components);
+    route_components = NULL;
+    sipp_free(route_doors);
+    mem_free(door_blocks);
+    clear_schedule();
+    route_doors = NULL;
+    door_blocks = NULL;
+    route_landmarks = NULL;
+    route_cpd = NULL;
+    route_goal_bounds = NULL;
+    route_walls = NULL;
+    block_overlay_free(query_overlay);
+    query_overlay = NULL;
+    session_unbind(session);
+
+    SDL_DestroyTexture(session->grid_texture);
+    SDL_DestroyTexture(session->grid_lines.texture);
+    SDL_DestroyRenderer(session->renderer);
+    SDL_DestroyWindow(session->window);
+    for (int i = 0; i < session_count; i++) {
+        if (sessions[i] == session) {
+            sessions[i] = sessions[--session_count];
+            break;
+        }
+    }
+    free(session);
+}
+
+MapSession* session_for_window(SDL_WindowID window_id) {
+    for (int i = 0; i < session_count; i++) {
+        if (sessions[i]->window_id == window_id)
+            return sessions[i];
+    }
+    return NULL;
+}
+
+// Window an input event belongs to, 0 for events without one
+SDL_WindowID event_window(const SDL_Event* event) {
+    switch (event->type) {
+    case SDL_EVENT_MOUSE_BUTTON_DOWN: return event->button.windowID;
+    case SDL_EVENT_MOUSE_MOTION: return event->motion.windowID;
+    case SDL_EVENT_MOUSE_WHEEL: return event->wheel.windowID;
+    case SDL_EVENT_KEY_DOWN: return event->key.windowID;
+    case SDL_EVENT_WINDOW_CLOSE_REQUESTED: return event->window.windowID;
+    case SDL_EVENT_WINDOW_MOUSE_LEAVE: return event->window.windowID;
+    case SDL_EVENT_RENDER_TARGETS_RESET: return event->render.windowID;
+    case SDL_EVENT_RENDER_DEVICE_RESET: return event->render.windowID;
+    default: return 0;
+    }
+}
+
+// Zooms the bound session's view by factor, keeping the point under the cursor in place
+void zoom_view(float factor, float mouse_x, float mouse_y) {
+    float cell_size = SDL_clamp(view.cell_size * factor, 4.0f, 160.0f);
+    view.offset_x = mouse_x - (mouse_x - view.offset_x) * cell_size / view.cell_size;
+    view.offset_y = mouse_y - (mouse_y - view.offset_y) * cell_size / view.cell_size;
+    view.cell_size = cell_size;
+}
+
+// A walkable cell of the grid picked with rand(), { -1, -1 } if none turns up
+Point random_open_cell() {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        Point p = { rand() % GRID_WIDTH, rand() % GRID_HEIGHT };
+        if (grid[p.y][p.x] != CELL_WALL)
+            return p;
+    }
+    return (Point){ -1, -1 };
+}
+
+/**
+ * @brief --check-kloop [seeds]: the inline K-loop against the loop it
+ * replaced, K dijkstra_find_path() calls, on seeded random walls. Each start
+ * is kept for several ends, so the cached tree is both resumed and rooted
+ * again. Path counts, costs and cells must all match.
+ * @return 0 if every K-loop matched.
+ */
+int run_kloop_check_tool(int seeds) {
+    if (seeds <= 0)
+        seeds = 100;
+    query_overlay = block_overlay_create(GRID_WIDTH, GRID_HEIGHT);
+    if (!query_overlay)
+        return 1;
+
+    static Path expected[K_PATHS];
+    int loops = 0, mismatches = 0;
+    for (int seed = 1; seed <= seeds; seed++) {
+        srand((unsigned int)seed);
+        int wall_percent = 10 + seed % 4 * 10;
+        for (int y = 0; y < GRID_HEIGHT; y++) {
+            for (int x = 0; x < GRID_WIDTH; x++)
+                grid[y][x] = rand() % 100 < wall_percent ? CELL_WALL : CELL_EMPTY;
+        }
+        publish_grid_walls();
+
+        for (int s = 0; s < 8; s++) {
+            Point from = random_open_cell();
+            for (int e = 0; from.x >= 0 && e < 8; e++) {
+                Point to = random_open_cell();
+                if (to.x < 0 || (to.x == from.x && to.y == from.y))
+                    continue;
+                start = from;
+                end = to;
+
+                block_overlay_clear(query_overlay);
+                int expected_count = 0;
+                while (expected_count < K_PATHS) {
+                    Path* path = &expected[expected_count];
+                    *path = dijkstra_find_path();
+                    if (path->cost == -1)
+                        break;
+                    block_overlay_add_path_inner(query_overlay, path->points, path->length);
+                    expected_count++;
+                }
+
+                block_overlay_clear(query_overlay);
+                SearchTree* cached = acquire_start_tree();
+                int count = 0;
+                int differs_at = -1; // First path that is not the old one
+                while (count < K_PATHS) {
+                    Path path = find_kloop_path(count, cached, false);
+                    if (path.cost == -1)
+                        break;
+                    const Path* old = &expected[count];
+                    if (differs_at < 0 && (count >= expected_count || path.cost != old->cost || path.length != old->length ||
+                        memcmp(path.points, old->points, sizeof(Point) * path.length) != 0))
+                        differs_at = count;
+                    block_overlay_add_path_inner(query_overlay, path.points, path.length);
+                    count++;
+                }
+                loops++;
+                if (differs_at < 0 && count == expected_count)
+                    continue;
+                if (++mismatches <= 5) {
+                    printf("  Seed %d, (%d, %d) to (%d, %d): path %d differs, %d paths, expected %d\n", seed, from.x, from.y,
+                        to.x, to.y, (differs_at < 0 ? count : differs_at) + 1, count, expected_count);
+                }
+            }
+        }
+    }
+
+    drop_start_tree();
+    map_store_unregister_reader(route_walls, route_walls_reader);
+    map_store_destroy(route_walls);
+    route_walls = NULL;
+    components_free(route_components);
+    route_components = NULL;
+    block_overlay_free(query_overlay);
+    query_overlay = NULL;
+    printf("%d K-loops on %d seeded %dx%d grids, %d differ from K dijkstra_find_path() calls\n", loops, seeds,
+        GRID_WIDTH, GRID_HEIGHT, mismatches);
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Offline preprocessing, no window needed
+    if (argc > 2 && strcmp(argv[1], "--preprocess-ch") == 0)
+        return ch_run_preprocess_tool(argv[2]);
+    if (argc > 2 && strcmp(argv[1], "--build-cpd") == 0)
+        return cpd_run_build_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--build-goal-bounds") == 0)
+        return goal_bounds_run_build_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--bench-alt") == 0)
+        return alt_run_benchmark_tool(argv[2], argc > 3 ? atoi(argv[3]) : ALT_DEFAULT_LANDMARKS);
+    if (argc > 1 && strcmp(argv[1], "--bench-shm-ring") == 0)
+        return shm_ring_run_benchmark_tool(argc > 2 ? atoi(argv[2]) : 0, argc > 3 ? atoi(argv[3]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--serve") == 0)
+        return query_server_run_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0);
+    if (argc > 3 && strcmp(argv[1], "--query-client") == 0)
+        return query_client_run_tool(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 0,
+            argc > 5 ? atoi(argv[5]) : 16, argc > 6 ? atoi(argv[6]) : 1);
+    if (argc > 2 && strcmp(argv[1], "--bench-path-code") == 0)
+        return path_code_run_benchmark_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--bench-sipp") == 0)
+        return sipp_run_benchmark_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atoi(argv[4]) : 0);
+    if (argc > 1 && strcmp(argv[1], "--check-kloop") == 0)
+        return run_kloop_check_tool(argc > 2 ? atoi(argv[2]) : 0);
+    if (argc > 1 && strcmp(argv[1], "--bench-kloop") == 0)
+        return stress_run_kloop_tool(argc > 2 ? atoi(argv[2]) : 0, argc > 3 ? atoi(argv[3]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--bench-repair") == 0)
+        return search_tree_run_benchmark_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atoi(argv[4]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--bench-retarget") == 0)
+        return search_tree_run_retarget_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atoi(argv[4]) : 0);
+    if (argc > 2 && strcmp(argv[1], "--bench-hover") == 0)
+        return search_tree_run_hover_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atof(argv[4]) : 0.0);
+    if (argc > 2 && strcmp(argv[1], "--bench-speculative") == 0)
+        return speculative_run_benchmark_tool(argv[2], argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atoi(argv[4]) : 0);
+    if (argc > 1 && strcmp(argv[1], "--bench-small-map") == 0)
+        return fixed_grid_run_benchmark_tool(argc > 2 ? atoi(argv[2]) : 0);
+    if (argc > 3 && strcmp(argv[1], "--export-image") == 0)
+        return raster_run_export_tool(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 1, argc > 5 ? atoi(argv[5]) : -1);
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
         return 1;
     }
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, NULL);
-    if (!renderer) {
-        fprintf(stderr, "Renderer creation failed: %s\n", SDL_GetError());
-        SDL_DestroyWindow(window);
+    // One window per --map argument, or a single random grid
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--map") == 0) {
+            session_open(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--palette") == 0) {
+            int palette = palette_find(argv[++i]);
+            if (palette < 0)
+                fprintf(stderr, "Unknown palette %s.\n", argv[i]);
+            palette_select(palette);
+        }
+    }
+    if (session_count == 0 && !session_open(NULL)) {
         SDL_Quit();
         return 1;
     }
 
-    initialize_grid();
-
     bool running = true;
-    while (running) {
+    while (running && session_count > 0) {
+        Uint64 frame_start = SDL_GetPerformanceCounter();
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_EVENT_QUIT) {
+                running = false;
+                continue;
+            }
+            MapSession* session = session_for_window(event_window(&event));
+            if (!session)
+                continue;
+
+            bool close_session = false;
+            bool open_session = false;
+            session_bind(session);
             switch (event.type) {
-            case SDL_EVENT_QUIT: running = false; break;
+            case SDL_EVENT_WINDOW_CLOSE_REQUESTED: close_session = true; break;
+            case SDL_EVENT_RENDER_TARGETS_RESET:
+                grid_lines.view.cell_size = 0.0f; // Its contents were lost
+                break;
+            case SDL_EVENT_RENDER_DEVICE_RESET:
+                // Every texture has to be created again
+                SDL_DestroyTexture(grid_texture);
+                SDL_DestroyTexture(grid_lines.texture);
+                grid_texture = grid_lines.texture = NULL;
+                break;
             case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                if (event.button.button == SDL_BUTTON_LEFT)
+                if (event.button.button == SDL_BUTTON_LEFT) {
                     handle_click(event.button.x, event.button.y);
+                }
+                else if (event.button.button == SDL_BUTTON_MIDDLE) {
+                    // Middle click toggles a wall
+                    Point cell = screen_to_grid(event.button.x, event.button.y);
+                    MapEdit edit = { MAP_EDIT_TOGGLE, cell.x, cell.y, 1, 1, NULL };
+                    apply_wall_edits(&edit, 1);
+                }
+                break;
+            case SDL_EVENT_MOUSE_MOTION:
+                if (event.motion.state & SDL_BUTTON_RMASK) {
+                    // Right-drag pans the view
+                    view.offset_x += event.motion.xrel;
+                    view.offset_y += event.motion.yrel;
+                }
+                // Only noted here; update_hover_preview() answers the latest cell once per frame
+                hover_cell = screen_to_grid(event.motion.x, event.motion.y);
+                if (hover_cell.x < 0 || hover_cell.x >= GRID_WIDTH || hover_cell.y < 0 || hover_cell.y >= GRID_HEIGHT)
+                    hover_cell = (Point){ -1, -1 };
+                break;
+            case SDL_EVENT_WINDOW_MOUSE_LEAVE:
+                hover_cell = (Point){ -1, -1 };
+                break;
+            case SDL_EVENT_MOUSE_WHEEL:
+                zoom_view(event.wheel.y > 0 ? 1.25f : 0.8f, event.wheel.mouse_x, event.wheel.mouse_y);
                 break;
             case SDL_EVENT_KEY_DOWN:
                 if (event.key.key == SDLK_R) {
@@ -419,21 +1730,86 @@ int main(int argc, char* argv[]) {
                     reset_grid();
                     printf("Grid cleared for new pathfinding.\n");
                 }
+                else if (event.key.key == SDLK_H) {
+                    prepare_route_hierarchy(true);
+                }
+                else if (event.key.key == SDLK_P) {
+                    prepare_path_database(true);
+                }
+                else if (event.key.key == SDLK_G) {
+                    prepare_goal_bounds(true);
+                }
+                else if (event.key.key == SDLK_L) {
+                    prepare_route_landmarks();
+                }
+                else if (event.key.key == SDLK_B) {
+                    frame_budgeted_search = !frame_budgeted_search;
+                    printf("Frame-budgeted search %s.\n", frame_budgeted_search ? "on" : "off");
+                }
+                else if (event.key.key == SDLK_V) {
+                    // Every window picks the new palette up when it next draws
+                    palette_select((palette_active_index() + 1) % palette_count());
+                    printf("Palette: %s\n", palette_active()->name);
+                }
+                else if (event.key.key == SDLK_E) {
+                    export_grid_image();
+                }
+                else if (event.key.key == SDLK_T) {
+                    toggle_timed_doors();
+                }
+                else if (event.key.key == SDLK_N) {
+                    open_session = true;
+                }
                 break;
             }
+            session_unbind(session);
+
+            if (close_session)
+                session_close(session);
+            if (open_session)
+                session_open(NULL);
+        }
+
+        bool budgeted_pending = false;
+        for (int i = 0; i < session_count; i++) {
+            MapSession* session = sessions[i];
+            session_bind(session);
+            collect_pool_paths();
+            update_hover_preview(HOVER_BUDGET_MS);
+            SDL_SetRenderDrawColor(session->renderer, 255, 255, 255, 255);
+            SDL_RenderClear(session->renderer);
+            draw_grid(session->renderer);
+            draw_schedule(session->renderer);
+            draw_hover_preview(session->renderer);
+            SDL_RenderPresent(session->renderer);
+            budgeted_pending = budgeted_pending || budgeted_search;
+            session_unbind(session);
         }
 
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        SDL_RenderClear(renderer);
-        draw_grid(renderer);
-        SDL_RenderPresent(renderer);
-        SDL_Delay(16);
+        if (budgeted_pending) {
+            // Spend what is left of the frame on the pending paths instead of sleeping,
+            // split evenly between the sessions that have some
+            double elapsed = (double)(SDL_GetPerformanceCounter() - frame_start) * 1000.0 / SDL_GetPerformanceFrequency();
+            int pending = 0;
+            for (int i = 0; i < session_count; i++)
+                pending += sessions[i]->budgeted_search != NULL;
+            for (int i = 0; i < session_count; i++) {
+                if (!sessions[i]->budgeted_search)
+                    continue;
+                session_bind(sessions[i]);
+                run_budgeted_paths((FRAME_TIME_MS - elapsed) / pending);
+                session_unbind(sessions[i]);
+            }
+        }
+        else {
+            SDL_Delay(FRAME_TIME_MS);
+        }
     }
 
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
+    while (session_count > 0)
+        session_close(sessions[0]);
+    task_pool_destroy(search_pool);
     SDL_Quit();
 
     return 0;
 }
-
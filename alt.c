@@ -0,0 +1,298 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alt.h"
+#include "grid_search.h"
+#include "mem_track.h"
+
+#define ALT_UNREACHABLE_16 0xFFFFu
+#define ALT_UNREACHABLE_32 0xFFFFFFFFu
+
+struct AltLandmarks {
+    int width, height;
+    uint64_t map_hash;
+    int count;
+    int* landmark_cell;
+    bool wide;          // planes are uint32 instead of uint16
+    uint16_t* planes16; // count planes of width * height distances
+    uint32_t* planes32;
+};
+
+// Breadth-first distances from source; ALT_UNREACHABLE_32 where there is no path.
+static void bfs_distances(const GridMap* map, int source, uint32_t* dist, int* queue) {
+    int cells = map->width * map->height;
+    for (int i = 0; i < cells; i++)
+        dist[i] = ALT_UNREACHABLE_32;
+
+    int head = 0, tail = 0;
+    dist[source] = 0;
+    queue[tail++] = source;
+    while (head < tail) {
+        int current = queue[head++];
+        int cx = current % map->width;
+        int cy = current / map->width;
+        for (int i = 0; i < 4; i++) {
+            int nx = cx + grid_dx[i];
+            int ny = cy + grid_dy[i];
+            if (!gridmap_walkable(map, nx, ny))
+                continue;
+            int neighbor = gridmap_index(map, nx, ny);
+            if (dist[neighbor] == ALT_UNREACHABLE_32) {
+                dist[neighbor] = dist[current] + 1;
+                queue[tail++] = neighbor;
+            }
+        }
+    }
+}
+
+// Any cell of the largest connected area, so landmarks are not wasted on small pockets.
+static int largest_component_cell(const GridMap* map, int* queue) {
+    int cells = map->width * map->height;
+    unsigned char* seen = mem_calloc(cells, 1);
+    if (!seen)
+        return -1;
+
+    int best_cell = -1, best_size = 0;
+    for (int i = 0; i < cells; i++) {
+        if (gridmap_is_wall(map, i) || seen[i])
+            continue;
+
+        // Flood fill; the queue length at the end is the size of the area
+        int head = 0, tail = 0;
+        seen[i] = 1;
+        queue[tail++] = i;
+        while (head < tail) {
+            int current = queue[head++];
+            int cx = current % map->width;
+            int cy = current / map->width;
+            for (int d = 0; d < 4; d++) {
+                int nx = cx + grid_dx[d];
+                int ny = cy + grid_dy[d];
+                if (gridmap_walkable(map, nx, ny) && !seen[gridmap_index(map, nx, ny)]) {
+                    seen[gridmap_index(map, nx, ny)] = 1;
+                    queue[tail++] = gridmap_index(map, nx, ny);
+                }
+            }
+        }
+        if (tail > best_size) {
+            best_size = tail;
+            best_cell = i;
+        }
+    }
+    mem_free(seen);
+    return best_cell;
+}
+
+AltLandmarks* alt_build(const GridMap* map, int landmark_count) {
+    int cells = map->width * map->height;
+    if (landmark_count < 1)
+        landmark_count = 1;
+
+    AltLandmarks* alt = mem_calloc(1, sizeof(AltLandmarks));
+    uint32_t* dist = mem_alloc(sizeof(uint32_t) * cells);
+    uint32_t* min_dist = mem_alloc(sizeof(uint32_t) * cells);
+    int* queue = mem_alloc(sizeof(int) * cells);
+    if (!alt || !dist || !min_dist || !queue)
+        goto fail;
+
+    int walkable = 0;
+    for (int i = 0; i < cells; i++)
+        walkable += !gridmap_is_wall(map, i);
+
+    alt->width = map->width;
+    alt->height = map->height;
+    alt->map_hash = gridmap_hash(map);
+    // A distance can never exceed walkable - 1, so small maps fit in 16 bits
+    alt->wide = walkable >= (int)ALT_UNREACHABLE_16;
+    alt->landmark_cell = mem_alloc(sizeof(int) * landmark_count);
+    if (alt->wide)
+        alt->planes32 = mem_alloc(sizeof(uint32_t) * (size_t)cells * landmark_count);
+    else
+        alt->planes16 = mem_alloc(sizeof(uint16_t) * (size_t)cells * landmark_count);
+    if (!alt->landmark_cell || (!alt->planes16 && !alt->planes32))
+        goto fail;
+
+    int seed = largest_component_cell(map, queue);
+    if (seed < 0)
+        goto fail;
+
+    // Farthest-point selection: the first landmark is the cell farthest from
+    // the seed, every next one the cell farthest from all landmarks so far.
+    bfs_distances(map, seed, dist, queue);
+    for (int i = 0; i < cells; i++)
+        min_dist[i] = dist[i];
+
+    for (int l = 0; l < landmark_count; l++) {
+        int farthest = seed;
+        for (int i = 0; i < cells; i++) {
+            if (min_dist[i] != ALT_UNREACHABLE_32 && min_dist[i] > min_dist[farthest])
+                farthest = i;
+        }
+        if (l > 0 && min_dist[farthest] == 0)
+            break; // Every reachable cell is already a landmark
+
+        alt->landmark_cell[l] = farthest;
+        alt->count++;
+        bfs_distances(map, farthest, dist, queue);
+
+        if (alt->wide) {
+            memcpy(alt->planes32 + (size_t)l * cells, dist, sizeof(uint32_t) * cells);
+        }
+        else {
+            uint16_t* plane = alt->planes16 + (size_t)l * cells;
+            for (int i = 0; i < cells; i++)
+                plane[i] = dist[i] == ALT_UNREACHABLE_32 ? ALT_UNREACHABLE_16 : (uint16_t)dist[i];
+        }
+
+        for (int i = 0; i < cells; i++) {
+            if (l == 0 || dist[i] < min_dist[i])
+                min_dist[i] = dist[i];
+        }
+    }
+
+    mem_free(dist);
+    mem_free(min_dist);
+    mem_free(queue);
+    return alt;
+
+fail:
+    mem_free(dist);
+    mem_free(min_dist);
+    mem_free(queue);
+    alt_free(alt);
+    return NULL;
+}
+
+void alt_free(AltLandmarks* alt) {
+    if (!alt)
+        return;
+    mem_free(alt->landmark_cell);
+    mem_free(alt->planes16);
+    mem_free(alt->planes32);
+    mem_free(alt);
+}
+
+bool alt_matches(const AltLandmarks* alt, const GridMap* map) {
+    return alt->width == map->width && alt->height == map->height && alt->map_hash == gridmap_hash(map);
+}
+
+int alt_landmark_count(const AltLandmarks* alt) {
+    return alt->count;
+}
+
+Point alt_landmark(const AltLandmarks* alt, int index) {
+    int cell = alt->landmark_cell[index];
+    return (Point){ cell % alt->width, cell / alt->width };
+}
+
+size_t alt_bytes_per_landmark(const AltLandmarks* alt) {
+    return (size_t)alt->width * alt->height * (alt->wide ? sizeof(uint32_t) : sizeof(uint16_t));
+}
+
+int alt_heuristic(const void* context, int cell, int target) {
+    const AltLandmarks* alt = context;
+    size_t cells = (size_t)alt->width * alt->height;
+
+    // Manhattan distance is a valid bound too; never do worse than it
+    int best = abs(cell % alt->width - target % alt->width) + abs(cell / alt->width - target / alt->width);
+
+    // max over landmarks of |d(L, target) - d(L, cell)|
+    if (alt->wide) {
+        for (int l = 0; l < alt->count; l++) {
+            const uint32_t* plane = alt->planes32 + l * cells;
+            if (plane[cell] == ALT_UNREACHABLE_32 || plane[target] == ALT_UNREACHABLE_32)
+                continue;
+            int bound = abs((int)plane[target] - (int)plane[cell]);
+            if (bound > best)
+                best = bound;
+        }
+    }
+    else {
+        for (int l = 0; l < alt->count; l++) {
+            const uint16_t* plane = alt->planes16 + l * cells;
+            if (plane[cell] == ALT_UNREACHABLE_16 || plane[target] == ALT_UNREACHABLE_16)
+                continue;
+            int bound = abs((int)plane[target] - (int)plane[cell]);
+            if (bound > best)
+                best = bound;
+        }
+    }
+    return best;
+}
+
+int alt_run_benchmark_tool(const char* map_path, int landmark_count) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    AltLandmarks* alt = alt_build(map, landmark_count);
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    if (!alt) {
+        fprintf(stderr, "Landmark selection failed (out of memory or no walkable cells).\n");
+        gridmap_free(map);
+        return 1;
+    }
+
+    printf("Map %s: %dx%d, %d landmarks\n", map_path, map->width, map->height, alt_landmark_count(alt));
+    printf("  Build time:      %.1f ms\n", (double)(t1 - t0) * 1000.0 / freq);
+    printf("  Memory/landmark: %.1f KiB (%s planes), total %.1f KiB\n",
+        alt_bytes_per_landmark(alt) / 1024.0, alt->wide ? "uint32" : "uint16",
+        alt_bytes_per_landmark(alt) * alt_landmark_count(alt) / 1024.0);
+
+    // Same random queries for every engine
+    enum { ENGINE_DIJKSTRA, ENGINE_MANHATTAN, ENGINE_ALT, ENGINE_COUNT };
+    const char* engine_names[ENGINE_COUNT] = { "Dijkstra", "A* Manhattan", "A* ALT" };
+    SearchOptions options[ENGINE_COUNT] = {
+        { NULL, NULL, NULL, NULL, NULL },
+        { NULL, grid_manhattan_heuristic, map, NULL, NULL },
+        { NULL, alt_heuristic, alt, NULL, NULL },
+    };
+    long long expanded[ENGINE_COUNT] = { 0 };
+    Uint64 ticks[ENGINE_COUNT] = { 0 };
+
+    int cells = map->width * map->height;
+    PathBuffer buffer = { mem_alloc(sizeof(Point) * cells), cells, 0, -1 };
+    int queries = 0, mismatches = 0;
+    srand(12345);
+    for (int attempt = 0; buffer.points && attempt < 100000 && queries < 200; attempt++) {
+        Point a = { rand() % map->width, rand() % map->height };
+        Point b = { rand() % map->width, rand() % map->height };
+        if (!gridmap_walkable(map, a.x, a.y) || !gridmap_walkable(map, b.x, b.y))
+            continue;
+
+        int reference_cost = 0;
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            SearchStats stats;
+            Uint64 q0 = SDL_GetPerformanceCounter();
+            grid_astar(map, a, b, &options[e], &buffer, &stats);
+            ticks[e] += SDL_GetPerformanceCounter() - q0;
+            expanded[e] += stats.expanded;
+            if (e == ENGINE_DIJKSTRA)
+                reference_cost = buffer.cost;
+            else if (buffer.cost != reference_cost)
+                mismatches++;
+        }
+        queries++;
+    }
+
+    if (queries > 0) {
+        printf("  %-14s %14s %12s %10s\n", "Engine", "Expanded/query", "vs Dijkstra", "us/query");
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            printf("  %-14s %14.0f %11.1f%% %10.1f\n", engine_names[e], (double)expanded[e] / queries,
+                100.0 * expanded[e] / (expanded[ENGINE_DIJKSTRA] ? expanded[ENGINE_DIJKSTRA] : 1),
+                (double)ticks[e] * 1e6 / freq / queries);
+        }
+        printf("  ALT expands %.1f%% of what A* Manhattan does (%d queries, %d cost mismatches)\n",
+            100.0 * expanded[ENGINE_ALT] / (expanded[ENGINE_MANHATTAN] ? expanded[ENGINE_MANHATTAN] : 1),
+            queries, mismatches);
+    }
+
+    mem_free(buffer.points);
+    alt_free(alt);
+    gridmap_free(map);
+    return 0;
+}
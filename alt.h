@@ -0,0 +1,40 @@
+#ifndef ALT_H
+#define ALT_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+
+#define ALT_DEFAULT_LANDMARKS 8
+
+// ALT ("A*, Landmarks, Triangle inequality") lower bounds for a static map.
+// Each landmark stores the BFS distance to every cell in one plane, as uint16
+// when the map is small enough and uint32 otherwise.
+typedef struct AltLandmarks AltLandmarks;
+
+/**
+ * @brief Picks landmark_count landmarks by farthest-point selection and runs
+ * one BFS per landmark.
+ */
+AltLandmarks* alt_build(const GridMap* map, int landmark_count);
+void alt_free(AltLandmarks* alt);
+
+bool alt_matches(const AltLandmarks* alt, const GridMap* map);
+int alt_landmark_count(const AltLandmarks* alt);
+Point alt_landmark(const AltLandmarks* alt, int index);
+// Bytes of one distance plane (what each extra landmark costs)
+size_t alt_bytes_per_landmark(const AltLandmarks* alt);
+
+// SearchHeuristic for grid_astar(); context is the AltLandmarks. Returns the
+// larger of the landmark bound and the Manhattan distance.
+// Blocking extra cells only makes paths longer, so the bound stays admissible.
+int alt_heuristic(const void* context, int cell, int target);
+
+/**
+ * @brief Offline measurement: expansions and time of Dijkstra, A* (Manhattan)
+ * and A* (ALT) over random queries, plus landmark memory.
+ * @return Process exit code.
+ */
+int alt_run_benchmark_tool(const char* map_path, int landmark_count);
+
+#endif // ALT_H
@@ -0,0 +1,91 @@
+#include <SDL3/SDL.h>
+#include <string.h>
+
+#include "block_overlay.h"
+#include "mem_track.h"
+
+BlockOverlay* block_overlay_create(int width, int height) {
+    if (width <= 0 || height <= 0)
+        return NULL;
+    BlockOverlay* overlay = mem_calloc(1, sizeof(BlockOverlay));
+    if (!overlay)
+        return NULL;
+    overlay->width = width;
+    overlay->height = height;
+    overlay->tiles_x = (width + MAP_TILE_SIZE - 1) >> MAP_TILE_SHIFT;
+    overlay->tiles_y = (height + MAP_TILE_SIZE - 1) >> MAP_TILE_SHIFT;
+    int tile_count = overlay->tiles_x * overlay->tiles_y;
+    overlay->tiles = mem_calloc(tile_count, sizeof(uint64_t*));
+    overlay->used_tiles = mem_alloc(sizeof(int) * tile_count);
+    if (!overlay->tiles || !overlay->used_tiles) {
+        block_overlay_free(overlay);
+        return NULL;
+    }
+    return overlay;
+}
+
+void block_overlay_free(BlockOverlay* overlay) {
+    if (!overlay)
+        return;
+    if (overlay->tiles) {
+        for (int i = 0; i < overlay->used_count; i++)
+            mem_free(overlay->tiles[overlay->used_tiles[i]]);
+    }
+    mem_free(overlay->tiles);
+    mem_free(overlay->used_tiles);
+    mem_free(overlay);
+}
+
+void block_overlay_clear(BlockOverlay* overlay) {
+    // Tiles are zeroed and kept: the next query tends to block the same area
+    for (int i = 0; i < overlay->used_count; i++)
+        memset(overlay->tiles[overlay->used_tiles[i]], 0, sizeof(uint64_t) * BLOCK_OVERLAY_TILE_WORDS);
+    overlay->count = 0;
+}
+
+bool block_overlay_add(BlockOverlay* overlay, int x, int y) {
+    if (x < 0 || x >= overlay->width || y < 0 || y >= overlay->height)
+        return true;
+    int t = (y >> MAP_TILE_SHIFT) * overlay->tiles_x + (x >> MAP_TILE_SHIFT);
+    uint64_t* tile = overlay->tiles[t];
+    if (!tile) {
+        tile = mem_calloc(BLOCK_OVERLAY_TILE_WORDS, sizeof(uint64_t));
+        if (!tile)
+            return false;
+        overlay->tiles[t] = tile;
+        overlay->used_tiles[overlay->used_count++] = t;
+    }
+    int bit = ((y & (MAP_TILE_SIZE - 1)) << MAP_TILE_SHIFT) | (x & (MAP_TILE_SIZE - 1));
+    uint64_t mask = (uint64_t)1 << (bit & 63);
+    if (!(tile[bit >> 6] & mask)) {
+        tile[bit >> 6] |= mask;
+        overlay->count++;
+    }
+    return true;
+}
+
+bool block_overlay_add_path_inner(BlockOverlay* overlay, const Point* points, int count) {
+    for (int i = 1; i < count - 1; i++) {
+        if (!block_overlay_add(overlay, points[i].x, points[i].y))
+            return false;
+    }
+    return true;
+}
+
+void block_overlay_visit(const BlockOverlay* overlay, void (*visit)(void* context, int x, int y), void* context) {
+    for (int i = 0; i < overlay->used_count; i++) {
+        int t = overlay->used_tiles[i];
+        const uint64_t* tile = overlay->tiles[t];
+        int base_x = (t % overlay->tiles_x) << MAP_TILE_SHIFT;
+        int base_y = (t / overlay->tiles_x) << MAP_TILE_SHIFT;
+        for (int w = 0; w < BLOCK_OVERLAY_TILE_WORDS; w++) {
+            uint64_t bits = tile[w];
+            for (int b = 0; bits; b++, bits >>= 1) {
+                if (bits & 1) {
+                    int bit = w * 64 + b;
+                    visit(context, base_x + (bit & (MAP_TILE_SIZE - 1)), base_y + (bit >> MAP_TILE_SHIFT));
+                }
+            }
+        }
+    }
+}
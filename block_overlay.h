@@ -0,0 +1,50 @@
+#ifndef BLOCK_OVERLAY_H
+#define BLOCK_OVERLAY_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Cells one query blocks on top of the walls, e.g. the cells of the paths it
+// has found so far. Each K-path query owns one, so queries never write to
+// shared state and any number of them can search one immutable map at once.
+//
+// A sparse bitset: one bit per cell, in MAP_TILE_SIZE x MAP_TILE_SIZE tiles
+// that are only allocated once a cell in them is blocked. A query that blocks
+// a few hundred cells of a huge map touches a few tiles, and clearing it only
+// visits those.
+typedef struct BlockOverlay {
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+    uint64_t** tiles; // tiles_x * tiles_y, NULL while nothing in the tile is blocked
+    int* used_tiles;  // Indices of the allocated tiles, in allocation order
+    int used_count;
+    int count; // Blocked cells
+} BlockOverlay;
+
+#define BLOCK_OVERLAY_TILE_WORDS (MAP_TILE_SIZE * MAP_TILE_SIZE / 64)
+
+BlockOverlay* block_overlay_create(int width, int height);
+void block_overlay_free(BlockOverlay* overlay);
+// Unblocks everything, touching only the tiles in use
+void block_overlay_clear(BlockOverlay* overlay);
+
+// Returns false if the cell's tile could not be allocated
+bool block_overlay_add(BlockOverlay* overlay, int x, int y);
+// Blocks the points between the first and last (the endpoints stay open)
+bool block_overlay_add_path_inner(BlockOverlay* overlay, const Point* points, int count);
+
+static inline bool block_overlay_test(const BlockOverlay* overlay, int x, int y) {
+    const uint64_t* tile = overlay->tiles[(y >> MAP_TILE_SHIFT) * overlay->tiles_x + (x >> MAP_TILE_SHIFT)];
+    if (!tile)
+        return false;
+    int bit = ((y & (MAP_TILE_SIZE - 1)) << MAP_TILE_SHIFT) | (x & (MAP_TILE_SIZE - 1));
+    return (tile[bit >> 6] >> (bit & 63)) & 1;
+}
+
+// Calls visit for every blocked cell, tile by tile
+void block_overlay_visit(const BlockOverlay* overlay, void (*visit)(void* context, int x, int y), void* context);
+
+#endif // BLOCK_OVERLAY_H
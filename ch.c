@@ -0,0 +1,721 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "ch.h"
+#include "grid_search.h"
+#include "min_heap.h"
+#include "mem_track.h"
+
+#define CH_MAGIC "SPCH"
+#define CH_VERSION 1u
+// Witness searches give up after settling this many nodes (a missed witness
+// only adds a redundant shortcut, it never makes a query wrong).
+#define CH_WITNESS_SETTLE_LIMIT 64
+
+struct ContractionHierarchy {
+    int width, height;
+    uint64_t map_hash;
+    int node_count;
+    int edge_count;
+    int shortcut_count;
+    int* node_of_cell; // -1 for walls
+    int* cell_of_node;
+    // Upward graph in CSR form: edges of node n are first_edge[n] .. first_edge[n + 1] - 1
+    // and always lead to a node contracted later (higher rank).
+    int* first_edge;
+    int* edge_target;
+    int* edge_weight;
+    int* edge_middle; // Contracted node a shortcut bypasses, -1 for a grid step
+};
+
+struct ChWorkspace {
+    int node_count;
+    unsigned int round;
+    unsigned int* seen[2]; // dist/parent of a node are valid only when seen == round
+    int* dist[2];
+    int* parent[2];
+    MinHeap queue[2];
+    int* chain; // Node sequence of the current result before unpacking
+};
+
+// ----------------------------------------------------------------------------
+// Preprocessing
+// ----------------------------------------------------------------------------
+
+// Adjacency list of one node while the graph is being contracted
+typedef struct {
+    int* target;
+    int* weight;
+    int* middle;
+    int count;
+    int capacity;
+} ChAdjacency;
+
+typedef struct {
+    int node_count;
+    ChAdjacency* adj;
+    ChAdjacency* up; // Final upward edges, filled in as nodes are contracted
+    bool* contracted;
+    int* deleted_neighbors;
+    int* level;
+
+    // Witness search state
+    unsigned int witness_round;
+    unsigned int* witness_seen;
+    int* witness_dist;
+    MinHeap witness_queue;
+
+    // Scratch for the neighbours of the node being contracted
+    int* neighbor;
+    int* neighbor_weight;
+    int* neighbor_middle;
+} ChBuilder;
+
+static bool adjacency_add(ChAdjacency* adj, int target, int weight, int middle) {
+    // Keep a single edge per neighbour, with the lowest weight
+    for (int i = 0; i < adj->count; i++) {
+        if (adj->target[i] == target) {
+            if (weight < adj->weight[i]) {
+                adj->weight[i] = weight;
+                adj->middle[i] = middle;
+            }
+            return true;
+        }
+    }
+
+    if (adj->count == adj->capacity) {
+        int new_capacity = adj->capacity ? adj->capacity * 2 : 4;
+        int* t = mem_realloc(adj->target, sizeof(int) * new_capacity);
+        if (!t)
+            return false;
+        adj->target = t;
+        int* w = mem_realloc(adj->weight, sizeof(int) * new_capacity);
+        if (!w)
+            return false;
+        adj->weight = w;
+        int* m = mem_realloc(adj->middle, sizeof(int) * new_capacity);
+        if (!m)
+            return false;
+        adj->middle = m;
+        adj->capacity = new_capacity;
+    }
+    adj->target[adj->count] = target;
+    adj->weight[adj->count] = weight;
+    adj->middle[adj->count] = middle;
+    adj->count++;
+    return true;
+}
+
+static void adjacency_free(ChAdjacency* adj) {
+    mem_free(adj->target);
+    mem_free(adj->weight);
+    mem_free(adj->middle);
+}
+
+// Dijkstra from source over uncontracted nodes, never passing through skip.
+static void witness_search(ChBuilder* b, int source, int skip, int max_dist) {
+    b->witness_round++;
+    heap_clear(&b->witness_queue);
+    b->witness_seen[source] = b->witness_round;
+    b->witness_dist[source] = 0;
+    heap_push(&b->witness_queue, 0, source);
+
+    int settled = 0;
+    while (!heap_empty(&b->witness_queue) && settled < CH_WITNESS_SETTLE_LIMIT) {
+        HeapItem item = heap_pop(&b->witness_queue);
+        int u = item.value;
+        if (item.key > b->witness_dist[u])
+            continue;
+        if (item.key > max_dist)
+            break;
+        settled++;
+
+        ChAdjacency* adj = &b->adj[u];
+        for (int i = 0; i < adj->count; i++) {
+            int w = adj->target[i];
+            if (w == skip || b->contracted[w])
+                continue;
+            int d = item.key + adj->weight[i];
+            if (b->witness_seen[w] != b->witness_round || d < b->witness_dist[w]) {
+                b->witness_seen[w] = b->witness_round;
+                b->witness_dist[w] = d;
+                heap_push(&b->witness_queue, d, w);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Contracts v (or only counts the shortcuts it would need when simulate is set).
+ * @return Number of shortcuts, or -1 on allocation failure.
+ */
+static int contract_node(ChBuilder* b, int v, bool simulate) {
+    ChAdjacency* adj = &b->adj[v];
+    int count = 0;
+    int max_weight = 0;
+    for (int i = 0; i < adj->count; i++) {
+        if (b->contracted[adj->target[i]])
+            continue;
+        b->neighbor[count] = adj->target[i];
+        b->neighbor_weight[count] = adj->weight[i];
+        b->neighbor_middle[count] = adj->middle[i];
+        if (adj->weight[i] > max_weight)
+            max_weight = adj->weight[i];
+        count++;
+    }
+
+    int shortcuts = 0;
+    for (int i = 0; i < count; i++) {
+        int u = b->neighbor[i];
+        witness_search(b, u, v, b->neighbor_weight[i] + max_weight);
+
+        for (int j = i + 1; j < count; j++) {
+            int w = b->neighbor[j];
+            int via_v = b->neighbor_weight[i] + b->neighbor_weight[j];
+            if (b->witness_seen[w] == b->witness_round && b->witness_dist[w] <= via_v)
+                continue; // Witness found, no shortcut needed
+
+            shortcuts++;
+            if (!simulate) {
+                if (!adjacency_add(&b->adj[u], w, via_v, v) || !adjacency_add(&b->adj[w], u, via_v, v))
+                    return -1;
+            }
+        }
+    }
+
+    if (!simulate) {
+        // Remaining edges of v all lead to higher-ranked nodes
+        for (int i = 0; i < count; i++) {
+            int u = b->neighbor[i];
+            if (!adjacency_add(&b->up[v], u, b->neighbor_weight[i], b->neighbor_middle[i]))
+                return -1;
+            b->deleted_neighbors[u]++;
+            if (b->level[u] < b->level[v] + 1)
+                b->level[u] = b->level[v] + 1;
+        }
+        b->contracted[v] = true;
+    }
+    return shortcuts;
+}
+
+static int node_priority(ChBuilder* b, int v) {
+    int degree = 0;
+    for (int i = 0; i < b->adj[v].count; i++) {
+        if (!b->contracted[b->adj[v].target[i]])
+            degree++;
+    }
+    int shortcuts = contract_node(b, v, true);
+    // Edge difference, plus terms that spread contraction evenly over the map
+    return 2 * (shortcuts - degree) + b->deleted_neighbors[v] + b->level[v];
+}
+
+static void builder_free(ChBuilder* b) {
+    if (b->adj) {
+        for (int i = 0; i < b->node_count; i++)
+            adjacency_free(&b->adj[i]);
+    }
+    if (b->up) {
+        for (int i = 0; i < b->node_count; i++)
+            adjacency_free(&b->up[i]);
+    }
+    mem_free(b->adj);
+    mem_free(b->up);
+    mem_free(b->contracted);
+    mem_free(b->deleted_neighbors);
+    mem_free(b->level);
+    mem_free(b->witness_seen);
+    mem_free(b->witness_dist);
+    mem_free(b->neighbor);
+    mem_free(b->neighbor_weight);
+    mem_free(b->neighbor_middle);
+    heap_free(&b->witness_queue);
+}
+
+static ContractionHierarchy* ch_alloc(int width, int height, int node_count, int edge_count) {
+    ContractionHierarchy* ch = mem_calloc(1, sizeof(ContractionHierarchy));
+    if (!ch)
+        return NULL;
+    ch->width = width;
+    ch->height = height;
+    ch->node_count = node_count;
+    ch->edge_count = edge_count;
+    ch->node_of_cell = mem_alloc(sizeof(int) * width * height);
+    ch->cell_of_node = mem_alloc(sizeof(int) * (node_count + 1));
+    ch->first_edge = mem_alloc(sizeof(int) * (node_count + 1));
+    ch->edge_target = mem_alloc(sizeof(int) * (edge_count + 1));
+    ch->edge_weight = mem_alloc(sizeof(int) * (edge_count + 1));
+    ch->edge_middle = mem_alloc(sizeof(int) * (edge_count + 1));
+    if (!ch->node_of_cell || !ch->cell_of_node || !ch->first_edge ||
+        !ch->edge_target || !ch->edge_weight || !ch->edge_middle) {
+        ch_free(ch);
+        return NULL;
+    }
+    return ch;
+}
+
+ContractionHierarchy* ch_build(const GridMap* map) {
+    int cells = map->width * map->height;
+    int* node_of_cell = mem_alloc(sizeof(int) * cells);
+    if (!node_of_cell)
+        return NULL;
+
+    int node_count = 0;
+    for (int i = 0; i < cells; i++)
+        node_of_cell[i] = gridmap_is_wall(map, i) ? -1 : node_count++;
+
+    ChBuilder b = { 0 };
+    b.node_count = node_count;
+    b.adj = mem_calloc(node_count + 1, sizeof(ChAdjacency));
+    b.up = mem_calloc(node_count + 1, sizeof(ChAdjacency));
+    b.contracted = mem_calloc(node_count + 1, sizeof(bool));
+    b.deleted_neighbors = mem_calloc(node_count + 1, sizeof(int));
+    b.level = mem_calloc(node_count + 1, sizeof(int));
+    b.witness_seen = mem_calloc(node_count + 1, sizeof(unsigned int));
+    b.witness_dist = mem_alloc(sizeof(int) * (node_count + 1));
+    b.neighbor = mem_alloc(sizeof(int) * (node_count + 1));
+    b.neighbor_weight = mem_alloc(sizeof(int) * (node_count + 1));
+    b.neighbor_middle = mem_alloc(sizeof(int) * (node_count + 1));
+    heap_init(&b.witness_queue, 256);
+
+    bool ok = b.adj && b.up && b.contracted && b.deleted_neighbors && b.level &&
+        b.witness_seen && b.witness_dist && b.neighbor && b.neighbor_weight && b.neighbor_middle;
+
+    // Original grid edges (unit cost, both directions)
+    for (int y = 0; ok && y < map->height; y++) {
+        for (int x = 0; ok && x < map->width; x++) {
+            int u = node_of_cell[gridmap_index(map, x, y)];
+            if (u < 0)
+                continue;
+            for (int i = 0; i < 4; i++) {
+                int nx = x + grid_dx[i];
+                int ny = y + grid_dy[i];
+                if (gridmap_walkable(map, nx, ny))
+                    ok = adjacency_add(&b.adj[u], node_of_cell[gridmap_index(map, nx, ny)], 1, -1);
+            }
+        }
+    }
+
+    // Contract in order of priority, re-checking the popped node lazily
+    MinHeap order;
+    heap_init(&order, node_count);
+    for (int v = 0; ok && v < node_count; v++)
+        heap_push(&order, node_priority(&b, v), v);
+
+    while (ok && !heap_empty(&order)) {
+        HeapItem item = heap_pop(&order);
+        int priority = node_priority(&b, item.value);
+        if (!heap_empty(&order) && priority > heap_min_key(&order)) {
+            heap_push(&order, priority, item.value);
+            continue;
+        }
+        if (contract_node(&b, item.value, false) < 0)
+            ok = false;
+    }
+    heap_free(&order);
+
+    ContractionHierarchy* ch = NULL;
+    if (ok) {
+        int edge_count = 0;
+        for (int v = 0; v < node_count; v++)
+            edge_count += b.up[v].count;
+
+        ch = ch_alloc(map->width, map->height, node_count, edge_count);
+        if (ch) {
+            ch->map_hash = gridmap_hash(map);
+            memcpy(ch->node_of_cell, node_of_cell, sizeof(int) * cells);
+            for (int i = 0; i < cells; i++) {
+                if (node_of_cell[i] >= 0)
+                    ch->cell_of_node[node_of_cell[i]] = i;
+            }
+
+            int e = 0;
+            for (int v = 0; v < node_count; v++) {
+                ch->first_edge[v] = e;
+                for (int i = 0; i < b.up[v].count; i++, e++) {
+                    ch->edge_target[e] = b.up[v].target[i];
+                    ch->edge_weight[e] = b.up[v].weight[i];
+                    ch->edge_middle[e] = b.up[v].middle[i];
+                    if (b.up[v].middle[i] >= 0)
+                        ch->shortcut_count++;
+                }
+            }
+            ch->first_edge[node_count] = e;
+        }
+    }
+
+    builder_free(&b);
+    mem_free(node_of_cell);
+    return ch;
+}
+
+void ch_free(ContractionHierarchy* ch) {
+    if (!ch)
+        return;
+    mem_free(ch->node_of_cell);
+    mem_free(ch->cell_of_node);
+    mem_free(ch->first_edge);
+    mem_free(ch->edge_target);
+    mem_free(ch->edge_weight);
+    mem_free(ch->edge_middle);
+    mem_free(ch);
+}
+
+int ch_node_count(const ContractionHierarchy* ch) {
+    return ch->node_count;
+}
+
+int ch_shortcut_count(const ContractionHierarchy* ch) {
+    return ch->shortcut_count;
+}
+
+size_t ch_memory_bytes(const ContractionHierarchy* ch) {
+    return sizeof(ContractionHierarchy) +
+        sizeof(int) * ((size_t)ch->width * ch->height + 2 * ((size_t)ch->node_count + 1)) +
+        sizeof(int) * 3 * ((size_t)ch->edge_count + 1);
+}
+
+bool ch_matches(const ContractionHierarchy* ch, const GridMap* map) {
+    return ch->width == map->width && ch->height == map->height && ch->map_hash == gridmap_hash(map);
+}
+
+// ----------------------------------------------------------------------------
+// Persistence
+// ----------------------------------------------------------------------------
+
+bool ch_save(const ContractionHierarchy* ch, const char* path) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        fprintf(stderr, "Could not open %s for writing: %s\n", path, SDL_GetError());
+        return false;
+    }
+
+    uint32_t header[5] = { CH_VERSION, (uint32_t)ch->width, (uint32_t)ch->height,
+        (uint32_t)ch->node_count, (uint32_t)ch->edge_count };
+    size_t cells = (size_t)ch->width * ch->height;
+    size_t edges = sizeof(int) * (size_t)ch->edge_count;
+    bool ok = SDL_WriteIO(io, CH_MAGIC, 4) == 4 &&
+        SDL_WriteIO(io, header, sizeof(header)) == sizeof(header) &&
+        SDL_WriteIO(io, &ch->map_hash, sizeof(ch->map_hash)) == sizeof(ch->map_hash) &&
+        SDL_WriteIO(io, ch->node_of_cell, sizeof(int) * cells) == sizeof(int) * cells &&
+        SDL_WriteIO(io, ch->first_edge, sizeof(int) * ((size_t)ch->node_count + 1)) == sizeof(int) * ((size_t)ch->node_count + 1) &&
+        SDL_WriteIO(io, ch->edge_target, edges) == edges &&
+        SDL_WriteIO(io, ch->edge_weight, edges) == edges &&
+        SDL_WriteIO(io, ch->edge_middle, edges) == edges;
+
+    SDL_CloseIO(io);
+    return ok;
+}
+
+ContractionHierarchy* ch_load(const char* path, const GridMap* map) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+    if (!io)
+        return NULL;
+
+    char magic[4];
+    uint32_t header[5];
+    uint64_t map_hash;
+    ContractionHierarchy* ch = NULL;
+    if (SDL_ReadIO(io, magic, 4) == 4 && memcmp(magic, CH_MAGIC, 4) == 0 &&
+        SDL_ReadIO(io, header, sizeof(header)) == sizeof(header) &&
+        SDL_ReadIO(io, &map_hash, sizeof(map_hash)) == sizeof(map_hash) &&
+        header[0] == CH_VERSION && (int)header[1] == map->width && (int)header[2] == map->height &&
+        map_hash == gridmap_hash(map)) {
+        ch = ch_alloc(map->width, map->height, (int)header[3], (int)header[4]);
+    }
+
+    if (ch) {
+        ch->map_hash = map_hash;
+        size_t cells = (size_t)ch->width * ch->height;
+        size_t edges = sizeof(int) * (size_t)ch->edge_count;
+        bool ok = SDL_ReadIO(io, ch->node_of_cell, sizeof(int) * cells) == sizeof(int) * cells &&
+            SDL_ReadIO(io, ch->first_edge, sizeof(int) * ((size_t)ch->node_count + 1)) == sizeof(int) * ((size_t)ch->node_count + 1) &&
+            SDL_ReadIO(io, ch->edge_target, edges) == edges &&
+            SDL_ReadIO(io, ch->edge_weight, edges) == edges &&
+            SDL_ReadIO(io, ch->edge_middle, edges) == edges;
+
+        for (size_t i = 0; ok && i < cells; i++) {
+            int node = ch->node_of_cell[i];
+            if (node >= ch->node_count)
+                ok = false;
+            else if (node >= 0)
+                ch->cell_of_node[node] = (int)i;
+        }
+        for (int e = 0; ok && e < ch->edge_count; e++) {
+            if (ch->edge_target[e] < 0 || ch->edge_target[e] >= ch->node_count)
+                ok = false;
+            else if (ch->edge_middle[e] >= 0)
+                ch->shortcut_count++;
+        }
+        if (!ok) {
+            fprintf(stderr, "%s is corrupt, ignoring it.\n", path);
+            ch_free(ch);
+            ch = NULL;
+        }
+    }
+
+    SDL_CloseIO(io);
+    return ch;
+}
+
+// ----------------------------------------------------------------------------
+// Queries
+// ----------------------------------------------------------------------------
+
+ChWorkspace* ch_workspace_create(const ContractionHierarchy* ch) {
+    ChWorkspace* ws = mem_calloc(1, sizeof(ChWorkspace));
+    if (!ws)
+        return NULL;
+    ws->node_count = ch->node_count;
+    bool ok = true;
+    for (int d = 0; d < 2; d++) {
+        ws->seen[d] = mem_calloc(ch->node_count + 1, sizeof(unsigned int));
+        ws->dist[d] = mem_alloc(sizeof(int) * (ch->node_count + 1));
+        ws->parent[d] = mem_alloc(sizeof(int) * (ch->node_count + 1));
+        heap_init(&ws->queue[d], 64);
+        ok = ok && ws->seen[d] && ws->dist[d] && ws->parent[d];
+    }
+    ws->chain = mem_alloc(sizeof(int) * (ch->node_count + 1));
+    if (!ok || !ws->chain) {
+        ch_workspace_free(ws);
+        return NULL;
+    }
+    return ws;
+}
+
+void ch_workspace_free(ChWorkspace* ws) {
+    if (!ws)
+        return;
+    for (int d = 0; d < 2; d++) {
+        mem_free(ws->seen[d]);
+        mem_free(ws->dist[d]);
+        mem_free(ws->parent[d]);
+        heap_free(&ws->queue[d]);
+    }
+    mem_free(ws->chain);
+    mem_free(ws);
+}
+
+static int find_edge(const ContractionHierarchy* ch, int from, int to) {
+    for (int e = ch->first_edge[from]; e < ch->first_edge[from + 1]; e++) {
+        if (ch->edge_target[e] == to)
+            return e;
+    }
+    return -1;
+}
+
+// Appends the grid cells of edge a-b to out (excluding a, including b).
+static bool unpack_edge(const ContractionHierarchy* ch, int a, int b, PathBuffer* out) {
+    // Explicit stack of (from, to) pairs still to expand, in path order
+    int stack_from[256], stack_to[256];
+    int top = 0;
+    stack_from[top] = a;
+    stack_to[top] = b;
+    top++;
+
+    while (top > 0) {
+        top--;
+        int from = stack_from[top];
+        int to = stack_to[top];
+
+        // The edge is stored at whichever endpoint was contracted first
+        int e = find_edge(ch, from, to);
+        if (e < 0)
+            e = find_edge(ch, to, from);
+        if (e < 0)
+            return false;
+
+        int middle = ch->edge_middle[e];
+        if (middle < 0) {
+            if (out->length >= out->capacity)
+                return false;
+            int cell = ch->cell_of_node[to];
+            out->points[out->length++] = (Point){ cell % ch->width, cell / ch->width };
+        }
+        else {
+            if (top + 2 > (int)SDL_arraysize(stack_from))
+                return false;
+            stack_from[top] = middle; // Second half, expanded after the first
+            stack_to[top] = to;
+            top++;
+            stack_from[top] = from;
+            stack_to[top] = middle;
+            top++;
+        }
+    }
+    return true;
+}
+
+bool ch_find_path(const ContractionHierarchy* ch, ChWorkspace* ws, Point from, Point to, PathBuffer* out) {
+    out->length = 0;
+    out->cost = -1;
+
+    if (from.x < 0 || from.x >= ch->width || from.y < 0 || from.y >= ch->height ||
+        to.x < 0 || to.x >= ch->width || to.y < 0 || to.y >= ch->height)
+        return false;
+    int source = ch->node_of_cell[from.y * ch->width + from.x];
+    int target = ch->node_of_cell[to.y * ch->width + to.x];
+    if (source < 0 || target < 0)
+        return false;
+
+    unsigned int round = ++ws->round;
+    int endpoint[2] = { source, target };
+    for (int d = 0; d < 2; d++) {
+        heap_clear(&ws->queue[d]);
+        ws->seen[d][endpoint[d]] = round;
+        ws->dist[d][endpoint[d]] = 0;
+        ws->parent[d][endpoint[d]] = -1;
+        heap_push(&ws->queue[d], 0, endpoint[d]);
+    }
+
+    int best = INT_MAX;
+    int meet = -1;
+    int dir = 0;
+    for (;;) {
+        // A direction is finished once its queue cannot improve on best
+        bool active[2];
+        for (int d = 0; d < 2; d++)
+            active[d] = !heap_empty(&ws->queue[d]) && heap_min_key(&ws->queue[d]) < best;
+        if (!active[0] && !active[1])
+            break;
+        if (!active[dir])
+            dir = 1 - dir;
+
+        HeapItem item = heap_pop(&ws->queue[dir]);
+        int u = item.value;
+        int other = 1 - dir;
+        if (item.key > ws->dist[dir][u]) {
+            dir = other;
+            continue;
+        }
+
+        // Stall-on-demand: u is reached more cheaply through a higher node
+        bool stalled = false;
+        for (int e = ch->first_edge[u]; e < ch->first_edge[u + 1]; e++) {
+            int w = ch->edge_target[e];
+            if (ws->seen[dir][w] == round && ws->dist[dir][w] + ch->edge_weight[e] < item.key) {
+                stalled = true;
+                break;
+            }
+        }
+
+        if (!stalled) {
+            if (ws->seen[other][u] == round && item.key + ws->dist[other][u] < best) {
+                best = item.key + ws->dist[other][u];
+                meet = u;
+            }
+
+            for (int e = ch->first_edge[u]; e < ch->first_edge[u + 1]; e++) {
+                int w = ch->edge_target[e];
+                int d = item.key + ch->edge_weight[e];
+                if (ws->seen[dir][w] != round || d < ws->dist[dir][w]) {
+                    ws->seen[dir][w] = round;
+                    ws->dist[dir][w] = d;
+                    ws->parent[dir][w] = u;
+                    heap_push(&ws->queue[dir], d, w);
+                }
+            }
+        }
+        dir = other;
+    }
+
+    if (meet < 0)
+        return false;
+
+    // Node chain source .. meet .. target, then unpack every edge into grid steps
+    int chain_length = 0;
+    for (int n = meet; n >= 0; n = ws->parent[0][n])
+        ws->chain[chain_length++] = n;
+    for (int i = 0; i < chain_length / 2; i++) {
+        int tmp = ws->chain[i];
+        ws->chain[i] = ws->chain[chain_length - 1 - i];
+        ws->chain[chain_length - 1 - i] = tmp;
+    }
+    for (int n = ws->parent[1][meet]; n >= 0; n = ws->parent[1][n])
+        ws->chain[chain_length++] = n;
+
+    if (out->capacity < 1)
+        return false;
+    out->points[out->length++] = from;
+    for (int i = 0; i + 1 < chain_length; i++) {
+        if (!unpack_edge(ch, ws->chain[i], ws->chain[i + 1], out)) {
+            out->length = 0;
+            return false;
+        }
+    }
+    out->cost = best;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Offline tool
+// ----------------------------------------------------------------------------
+
+int ch_run_preprocess_tool(const char* map_path) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    ContractionHierarchy* ch = ch_build(map);
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    if (!ch) {
+        fprintf(stderr, "Contraction failed (out of memory).\n");
+        gridmap_free(map);
+        return 1;
+    }
+
+    char ch_path[1024];
+    SDL_snprintf(ch_path, sizeof(ch_path), "%s.ch", map_path);
+    bool saved = ch_save(ch, ch_path);
+
+    printf("Map %s: %dx%d, %d walkable cells\n", map_path, map->width, map->height, ch_node_count(ch));
+    printf("  Build time:  %.1f ms\n", (double)(t1 - t0) * 1000.0 / freq);
+    printf("  Shortcuts:   %d\n", ch_shortcut_count(ch));
+    printf("  Memory:      %.1f KiB\n", ch_memory_bytes(ch) / 1024.0);
+    printf("  Saved to:    %s%s\n", ch_path, saved ? "" : " (FAILED)");
+
+    // Time random queries against plain Dijkstra and check the costs agree
+    int cells = map->width * map->height;
+    PathBuffer ch_path_buf = { mem_alloc(sizeof(Point) * cells), cells, 0, -1 };
+    PathBuffer ref_path_buf = { mem_alloc(sizeof(Point) * cells), cells, 0, -1 };
+    ChWorkspace* ws = ch_workspace_create(ch);
+    if (ws && ch_path_buf.points && ref_path_buf.points) {
+        srand(12345);
+        int queries = 0, mismatches = 0;
+        Uint64 ch_ticks = 0, ref_ticks = 0;
+        for (int attempt = 0; attempt < 10000 && queries < 200; attempt++) {
+            Point a = { rand() % map->width, rand() % map->height };
+            Point b = { rand() % map->width, rand() % map->height };
+            if (!gridmap_walkable(map, a.x, a.y) || !gridmap_walkable(map, b.x, b.y))
+                continue;
+
+            Uint64 q0 = SDL_GetPerformanceCounter();
+            ch_find_path(ch, ws, a, b, &ch_path_buf);
+            Uint64 q1 = SDL_GetPerformanceCounter();
+            grid_dijkstra(map, a, b, &ref_path_buf, NULL);
+            Uint64 q2 = SDL_GetPerformanceCounter();
+
+            ch_ticks += q1 - q0;
+            ref_ticks += q2 - q1;
+            if (ch_path_buf.cost != ref_path_buf.cost || (ch_path_buf.cost >= 0 && ch_path_buf.length != ch_path_buf.cost + 1))
+                mismatches++;
+            queries++;
+        }
+        if (queries > 0) {
+            printf("  Query time:  %.2f us (Dijkstra: %.2f us) over %d random queries\n",
+                (double)ch_ticks * 1e6 / freq / queries, (double)ref_ticks * 1e6 / freq / queries, queries);
+            printf("  Mismatches:  %d\n", mismatches);
+        }
+    }
+
+    ch_workspace_free(ws);
+    mem_free(ch_path_buf.points);
+    mem_free(ref_path_buf.points);
+    ch_free(ch);
+    gridmap_free(map);
+    return saved ? 0 : 1;
+}
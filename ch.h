@@ -0,0 +1,45 @@
+#ifndef CH_H
+#define CH_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Contraction hierarchy over the walkable cells of a static GridMap.
+// Built once offline (ch_build / --preprocess-ch) and saved next to the map;
+// queries are a bidirectional upward search plus shortcut unpacking.
+typedef struct ContractionHierarchy ContractionHierarchy;
+
+// Per-caller query state (distances, queues). One per thread.
+typedef struct ChWorkspace ChWorkspace;
+
+ContractionHierarchy* ch_build(const GridMap* map);
+void ch_free(ContractionHierarchy* ch);
+
+// File format: "SPCH", version, map size and hash, then the upward graph.
+bool ch_save(const ContractionHierarchy* ch, const char* path);
+// Returns NULL if the file is missing, corrupt or was built for a different map.
+ContractionHierarchy* ch_load(const char* path, const GridMap* map);
+bool ch_matches(const ContractionHierarchy* ch, const GridMap* map);
+
+int ch_node_count(const ContractionHierarchy* ch);
+int ch_shortcut_count(const ContractionHierarchy* ch);
+size_t ch_memory_bytes(const ContractionHierarchy* ch);
+
+ChWorkspace* ch_workspace_create(const ContractionHierarchy* ch);
+void ch_workspace_free(ChWorkspace* workspace);
+
+/**
+ * @brief Shortest path between two cells, unpacked into grid steps.
+ * @return true if a path was written to out (out->cost is -1 otherwise).
+ */
+bool ch_find_path(const ContractionHierarchy* ch, ChWorkspace* workspace, Point from, Point to, PathBuffer* out);
+
+/**
+ * @brief Offline tool: builds the hierarchy for a map file, writes <map>.ch
+ * and prints build time, size and query time against plain Dijkstra.
+ * @return Process exit code.
+ */
+int ch_run_preprocess_tool(const char* map_path);
+
+#endif // CH_H
@@ -0,0 +1,285 @@
+#include <SDL3/SDL.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "components.h"
+#include "mem_track.h"
+
+#define COMPONENT_UNASSIGNED -2 // Walkable, waiting to be flooded
+
+typedef struct {
+    int size; // 0 for a free label
+    int min_x, min_y, max_x, max_y;
+} ComponentInfo;
+
+struct MapComponents {
+    int width;
+    int height;
+    int* labels;
+    int* queue; // Flood queue, one slot per cell
+    ComponentInfo* info;
+    unsigned char* affected; // Per label, scratch of components_update()
+    int label_capacity;
+    int label_end;   // Labels in use are below this
+    int* free_labels; // Released labels below label_end
+    int free_count;
+    int count;
+};
+
+static int new_label(MapComponents* components) {
+    int label;
+    if (components->free_count > 0) {
+        label = components->free_labels[--components->free_count];
+    }
+    else {
+        if (components->label_end == components->label_capacity) {
+            int capacity = components->label_capacity ? components->label_capacity * 2 : 64;
+            ComponentInfo* info = mem_realloc(components->info, sizeof(ComponentInfo) * capacity);
+            if (!info)
+                return COMPONENT_NONE;
+            components->info = info;
+            unsigned char* affected = mem_realloc(components->affected, capacity);
+            if (!affected)
+                return COMPONENT_NONE;
+            components->affected = affected;
+            int* free_labels = mem_realloc(components->free_labels, sizeof(int) * capacity);
+            if (!free_labels)
+                return COMPONENT_NONE;
+            components->free_labels = free_labels;
+            components->label_capacity = capacity;
+        }
+        label = components->label_end++;
+    }
+    components->info[label] = (ComponentInfo){ 0, INT_MAX, INT_MAX, -1, -1 };
+    components->affected[label] = 0;
+    components->count++;
+    return label;
+}
+
+static void release_label(MapComponents* components, int label) {
+    components->info[label].size = 0;
+    components->free_labels[components->free_count++] = label;
+    components->count--;
+}
+
+static void include_cell(ComponentInfo* info, int x, int y) {
+    info->size++;
+    info->min_x = SDL_min(info->min_x, x);
+    info->max_x = SDL_max(info->max_x, x);
+    info->min_y = SDL_min(info->min_y, y);
+    info->max_y = SDL_max(info->max_y, y);
+}
+
+// Gives label to every unassigned cell reachable from cell; returns the cells labelled
+static int flood(MapComponents* components, int cell, int label) {
+    int width = components->width, height = components->height;
+    int* labels = components->labels;
+    int* queue = components->queue;
+    ComponentInfo* info = &components->info[label];
+    int head = 0, tail = 0;
+    labels[cell] = label;
+    queue[tail++] = cell;
+    while (head < tail) {
+        int current = queue[head++];
+        int x = current % width, y = current / width;
+        include_cell(info, x, y);
+        for (int d = 0; d < 4; d++) {
+            int nx = x + grid_dx[d], ny = y + grid_dy[d];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                continue;
+            int neighbor = ny * width + nx;
+            if (labels[neighbor] == COMPONENT_UNASSIGNED) {
+                labels[neighbor] = label;
+                queue[tail++] = neighbor;
+            }
+        }
+    }
+    return tail;
+}
+
+// Floods every unassigned cell of the rectangle with a fresh label
+static bool flood_rect(MapComponents* components, int min_x, int min_y, int max_x, int max_y, int* relabelled) {
+    for (int y = min_y; y <= max_y; y++) {
+        for (int x = min_x; x <= max_x; x++) {
+            int cell = y * components->width + x;
+            if (components->labels[cell] != COMPONENT_UNASSIGNED)
+                continue;
+            int label = new_label(components);
+            if (label == COMPONENT_NONE)
+                return false;
+            *relabelled += flood(components, cell, label);
+        }
+    }
+    return true;
+}
+
+MapComponents* components_build(const GridMap* map) {
+    MapComponents* components = mem_calloc(1, sizeof(MapComponents));
+    if (!components)
+        return NULL;
+    int cells = map->width * map->height;
+    components->width = map->width;
+    components->height = map->height;
+    components->labels = mem_alloc(sizeof(int) * cells);
+    components->queue = mem_alloc(sizeof(int) * cells);
+    if (!components->labels || !components->queue) {
+        components_free(components);
+        return NULL;
+    }
+
+    for (int i = 0; i < cells; i++)
+        components->labels[i] = gridmap_is_wall(map, i) ? COMPONENT_NONE : COMPONENT_UNASSIGNED;
+    int relabelled = 0;
+    if (!flood_rect(components, 0, 0, map->width - 1, map->height - 1, &relabelled)) {
+        components_free(components);
+        return NULL;
+    }
+    return components;
+}
+
+void components_free(MapComponents* components) {
+    if (!components)
+        return;
+    mem_free(components->labels);
+    mem_free(components->queue);
+    mem_free(components->info);
+    mem_free(components->affected);
+    mem_free(components->free_labels);
+    mem_free(components);
+}
+
+// Moves every cell of label from into label into (called with from the smaller)
+static int merge_into(MapComponents* components, int from, int into) {
+    ComponentInfo* source = &components->info[from];
+    ComponentInfo* target = &components->info[into];
+    int moved = 0;
+    for (int y = source->min_y; y <= source->max_y && moved < source->size; y++) {
+        int* row = components->labels + y * components->width;
+        for (int x = source->min_x; x <= source->max_x; x++) {
+            if (row[x] == from) {
+                row[x] = into;
+                moved++;
+            }
+        }
+    }
+    target->size += source->size;
+    target->min_x = SDL_min(target->min_x, source->min_x);
+    target->max_x = SDL_max(target->max_x, source->max_x);
+    target->min_y = SDL_min(target->min_y, source->min_y);
+    target->max_y = SDL_max(target->max_y, source->max_y);
+    release_label(components, from);
+    return moved;
+}
+
+// Only walls removed: each opened cell joins (and merges) the areas around it
+static bool open_cells(MapComponents* components, const MapChangeSet* changes, int* relabelled) {
+    int width = components->width, height = components->height;
+    int* labels = components->labels;
+    for (int i = 0; i < changes->count; i++) {
+        int cell = changes->cells[i];
+        int x = cell % width, y = cell / width;
+        int around[4];
+        int around_count = 0;
+        int largest = COMPONENT_NONE;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + grid_dx[d], ny = y + grid_dy[d];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                continue;
+            int label = labels[ny * width + nx];
+            if (label == COMPONENT_NONE)
+                continue;
+            bool seen = false;
+            for (int k = 0; k < around_count; k++)
+                seen = seen || around[k] == label;
+            if (seen)
+                continue;
+            around[around_count++] = label;
+            if (largest == COMPONENT_NONE || components->info[label].size > components->info[largest].size)
+                largest = label;
+        }
+
+        if (largest == COMPONENT_NONE) {
+            largest = new_label(components);
+            if (largest == COMPONENT_NONE)
+                return false;
+        }
+        for (int k = 0; k < around_count; k++) {
+            if (around[k] != largest)
+                *relabelled += merge_into(components, around[k], largest);
+        }
+        labels[cell] = largest;
+        include_cell(&components->info[largest], x, y);
+        (*relabelled)++;
+    }
+    return true;
+}
+
+bool components_update(MapComponents* components, const GridMap* map, const MapChangeSet* changes, int* relabelled) {
+    int local = 0;
+    if (!relabelled)
+        relabelled = &local;
+    *relabelled = 0;
+    if (changes->count == 0)
+        return true;
+    if (changes->added == 0)
+        return open_cells(components, changes, relabelled);
+
+    // Walls were added, so areas next to a change may have split: forget
+    // every such area and flood its bounds again
+    int width = components->width, height = components->height;
+    int* labels = components->labels;
+    int affected_count = 0;
+    for (int i = 0; i < changes->count; i++) {
+        int cell = changes->cells[i];
+        int x = cell % width, y = cell / width;
+        for (int d = -1; d < 4; d++) {
+            int nx = d < 0 ? x : x + grid_dx[d], ny = d < 0 ? y : y + grid_dy[d];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                continue;
+            int label = labels[ny * width + nx];
+            if (label >= 0 && !components->affected[label]) {
+                components->affected[label] = 1;
+                // The queue is free until the floods below; borrow it for the list
+                components->queue[affected_count++] = label;
+            }
+        }
+    }
+
+    // Bounds to flood again: every forgotten area plus the changed cells
+    int min_x = changes->min_x, min_y = changes->min_y, max_x = changes->max_x, max_y = changes->max_y;
+    for (int a = 0; a < affected_count; a++) {
+        int label = components->queue[a];
+        ComponentInfo* info = &components->info[label];
+        min_x = SDL_min(min_x, info->min_x);
+        min_y = SDL_min(min_y, info->min_y);
+        max_x = SDL_max(max_x, info->max_x);
+        max_y = SDL_max(max_y, info->max_y);
+    }
+    for (int y = min_y; y <= max_y; y++) {
+        int* row = labels + y * width;
+        for (int x = min_x; x <= max_x; x++) {
+            if (row[x] >= 0 && components->affected[row[x]])
+                row[x] = COMPONENT_UNASSIGNED;
+        }
+    }
+    for (int a = 0; a < affected_count; a++) {
+        components->affected[components->queue[a]] = 0;
+        release_label(components, components->queue[a]);
+    }
+    for (int i = 0; i < changes->count; i++) {
+        int cell = changes->cells[i];
+        labels[cell] = gridmap_is_wall(map, cell) ? COMPONENT_NONE : COMPONENT_UNASSIGNED;
+    }
+    return flood_rect(components, min_x, min_y, max_x, max_y, relabelled);
+}
+
+int components_count(const MapComponents* components) {
+    return components->count;
+}
+
+int components_label(const MapComponents* components, int x, int y) {
+    if (x < 0 || x >= components->width || y < 0 || y >= components->height)
+        return COMPONENT_NONE;
+    return components->labels[y * components->width + x];
+}
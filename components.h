@@ -0,0 +1,37 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "grid_map.h"
+#include "map_edit.h"
+
+#define COMPONENT_NONE -1 // Label of a wall
+
+// Connected areas of walkable cells, kept up to date from wall change sets.
+// Opening cells only merges areas, which is done by relabelling the smaller
+// ones; closing cells can split an area, so the areas next to a change are
+// flooded again within their bounds. Areas the batch does not touch are left
+// alone either way.
+typedef struct MapComponents MapComponents;
+
+MapComponents* components_build(const GridMap* map);
+void components_free(MapComponents* components);
+
+/**
+ * @brief Brings the labels in line with map, the walls after the batch
+ * described by changes (see map_edits_apply()).
+ * @param relabelled Optional: number of cells whose label was rewritten.
+ * @return false if memory ran out; call components_build() again then.
+ */
+bool components_update(MapComponents* components, const GridMap* map, const MapChangeSet* changes, int* relabelled);
+
+// Number of connected areas
+int components_count(const MapComponents* components);
+// Label of the area the cell belongs to, COMPONENT_NONE for a wall
+int components_label(const MapComponents* components, int x, int y);
+
+static inline bool components_connected(const MapComponents* components, Point a, Point b) {
+    int label = components_label(components, a.x, a.y);
+    return label != COMPONENT_NONE && label == components_label(components, b.x, b.y);
+}
+
+#endif // COMPONENTS_H
@@ -0,0 +1,524 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cpd.h"
+#include "grid_search.h"
+#include "mem_track.h"
+
+#define CPD_MAGIC "SPCP"
+#define CPD_VERSION 1u
+#define CPD_NO_RANK 0xFFFFFFFFu
+// A run is packed as (first target rank << 2) | move, move indexing grid_dx/grid_dy
+#define CPD_RUN(rank, move) (((uint32_t)(rank) << 2) | (uint32_t)(move))
+#define CPD_RUN_RANK(run) ((run) >> 2)
+#define CPD_RUN_MOVE(run) ((int)((run) & 3u))
+// Marks targets whose first move does not matter (the source itself and
+// unreachable cells); they join whatever run surrounds them.
+#define CPD_ANY_MOVE 0xFF
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height;
+    uint64_t map_hash;
+    uint32_t walkable;
+    uint32_t reserved;
+    uint64_t run_count;
+} CpdHeader;
+
+// File layout after the header:
+//   uint32 rank[cells]          position of each cell in the DFS order (CPD_NO_RANK for walls)
+//   uint32 component[cells]     connected area of each cell
+//   uint64 first_run[cells + 1] runs of source s are first_run[s] .. first_run[s + 1] - 1
+//   uint32 runs[run_count]
+struct CompressedPathDb {
+    int width, height;
+    const uint32_t* rank;
+    const uint32_t* component;
+    const uint64_t* first_run;
+    const uint32_t* runs;
+
+    void* view;
+    size_t view_bytes;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+// ----------------------------------------------------------------------------
+// Building
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    const GridMap* map;
+    const uint32_t* rank;
+    const int* order; // cells in rank order
+    int walkable;
+    SDL_AtomicInt next_source;
+
+    // Where each source's runs ended up: worker buffer, offset and count
+    int* source_worker;
+    uint64_t* source_offset;
+    int* source_count;
+} CpdBuildJob;
+
+typedef struct {
+    CpdBuildJob* job;
+    int index;
+    uint32_t* runs;
+    uint64_t run_count;
+    uint64_t run_capacity;
+    bool failed;
+} CpdWorker;
+
+static bool worker_emit(CpdWorker* w, uint32_t run) {
+    if (w->run_count == w->run_capacity) {
+        uint64_t new_capacity = w->run_capacity ? w->run_capacity * 2 : 4096;
+        uint32_t* grown = mem_realloc(w->runs, sizeof(uint32_t) * new_capacity);
+        if (!grown)
+            return false;
+        w->runs = grown;
+        w->run_capacity = new_capacity;
+    }
+    w->runs[w->run_count++] = run;
+    return true;
+}
+
+static int cpd_worker_main(void* data) {
+    CpdWorker* w = data;
+    CpdBuildJob* job = w->job;
+    const GridMap* map = job->map;
+    int cells = map->width * map->height;
+
+    unsigned char* first_move = mem_alloc(cells);
+    int* queue = mem_alloc(sizeof(int) * cells);
+    if (!first_move || !queue) {
+        w->failed = true;
+        mem_free(first_move);
+        mem_free(queue);
+        return 0;
+    }
+
+    for (;;) {
+        int source = SDL_AddAtomicInt(&job->next_source, 1);
+        if (source >= cells || w->failed)
+            break;
+        if (gridmap_is_wall(map, source))
+            continue;
+
+        // BFS from the source; every cell inherits the first move of its parent
+        memset(first_move, CPD_ANY_MOVE, cells);
+        int head = 0, tail = 0;
+        queue[tail++] = source;
+        int sx = source % map->width;
+        int sy = source / map->width;
+        for (int d = 0; d < 4; d++) {
+            int nx = sx + grid_dx[d];
+            int ny = sy + grid_dy[d];
+            if (gridmap_walkable(map, nx, ny)) {
+                first_move[gridmap_index(map, nx, ny)] = (unsigned char)d;
+                queue[tail++] = gridmap_index(map, nx, ny);
+            }
+        }
+        head = 1;
+        while (head < tail) {
+            int current = queue[head++];
+            int cx = current % map->width;
+            int cy = current / map->width;
+            for (int d = 0; d < 4; d++) {
+                int nx = cx + grid_dx[d];
+                int ny = cy + grid_dy[d];
+                if (!gridmap_walkable(map, nx, ny))
+                    continue;
+                int neighbor = gridmap_index(map, nx, ny);
+                if (first_move[neighbor] == CPD_ANY_MOVE && neighbor != source) {
+                    first_move[neighbor] = first_move[current];
+                    queue[tail++] = neighbor;
+                }
+            }
+        }
+
+        // Run-length encode the first moves in DFS order
+        uint64_t offset = w->run_count;
+        int current_move = -1;
+        for (int r = 0; r < job->walkable; r++) {
+            int move = first_move[job->order[r]];
+            if (move == CPD_ANY_MOVE || move == current_move)
+                continue;
+            // The first run always starts at rank 0 so every lookup finds one
+            if (!worker_emit(w, CPD_RUN(current_move < 0 ? 0 : r, move))) {
+                w->failed = true;
+                break;
+            }
+            current_move = move;
+        }
+        if (current_move < 0 && !worker_emit(w, CPD_RUN(0, 0)))
+            w->failed = true; // Isolated cell: a single dummy run
+
+        job->source_worker[source] = w->index;
+        job->source_offset[source] = offset;
+        job->source_count[source] = (int)(w->run_count - offset);
+    }
+
+    mem_free(first_move);
+    mem_free(queue);
+    return 0;
+}
+
+// Depth-first order of the walkable cells; neighbouring targets tend to share
+// their first move, which is what makes the runs long.
+static int dfs_order(const GridMap* map, uint32_t* rank, uint32_t* component, int* order) {
+    int cells = map->width * map->height;
+    int* stack = mem_alloc(sizeof(int) * (cells * 4 + 1));
+    if (!stack)
+        return -1;
+
+    for (int i = 0; i < cells; i++) {
+        rank[i] = CPD_NO_RANK;
+        component[i] = CPD_NO_RANK;
+    }
+
+    int count = 0;
+    uint32_t area = 0;
+    for (int root = 0; root < cells; root++) {
+        if (gridmap_is_wall(map, root) || rank[root] != CPD_NO_RANK)
+            continue;
+
+        int top = 0;
+        stack[top++] = root;
+        while (top > 0) {
+            int current = stack[--top];
+            if (rank[current] != CPD_NO_RANK)
+                continue;
+            rank[current] = (uint32_t)count;
+            component[current] = area;
+            order[count++] = current;
+
+            int cx = current % map->width;
+            int cy = current / map->width;
+            for (int d = 3; d >= 0; d--) {
+                int nx = cx + grid_dx[d];
+                int ny = cy + grid_dy[d];
+                if (gridmap_walkable(map, nx, ny) && rank[gridmap_index(map, nx, ny)] == CPD_NO_RANK)
+                    stack[top++] = gridmap_index(map, nx, ny);
+            }
+        }
+        area++;
+    }
+
+    mem_free(stack);
+    return count;
+}
+
+bool cpd_build_file(const GridMap* map, const char* path, int thread_count, CpdBuildStats* stats) {
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    int cells = map->width * map->height;
+    if (thread_count <= 0)
+        thread_count = SDL_GetNumLogicalCPUCores();
+    if (thread_count < 1)
+        thread_count = 1;
+
+    CpdBuildJob job;
+    memset(&job, 0, sizeof(job));
+    job.map = map;
+    uint32_t* rank = mem_alloc(sizeof(uint32_t) * cells);
+    uint32_t* component = mem_alloc(sizeof(uint32_t) * cells);
+    int* order = mem_alloc(sizeof(int) * cells);
+    job.source_worker = mem_calloc(cells, sizeof(int));
+    job.source_offset = mem_calloc(cells, sizeof(uint64_t));
+    job.source_count = mem_calloc(cells, sizeof(int));
+    CpdWorker* workers = mem_calloc(thread_count, sizeof(CpdWorker));
+    SDL_Thread** threads = mem_calloc(thread_count, sizeof(SDL_Thread*));
+
+    bool ok = rank && component && order && job.source_worker && job.source_offset &&
+        job.source_count && workers && threads;
+    if (ok) {
+        job.walkable = dfs_order(map, rank, component, order);
+        ok = job.walkable >= 0;
+    }
+    job.rank = rank;
+    job.order = order;
+    SDL_SetAtomicInt(&job.next_source, 0);
+
+    // Workers pull sources from a shared counter, so uneven areas balance out
+    for (int i = 0; ok && i < thread_count; i++) {
+        workers[i].job = &job;
+        workers[i].index = i;
+        threads[i] = SDL_CreateThread(cpd_worker_main, "cpd-build", &workers[i]);
+        if (!threads[i])
+            cpd_worker_main(&workers[i]); // No thread available: do the share here
+    }
+    for (int i = 0; ok && i < thread_count; i++) {
+        SDL_WaitThread(threads[i], NULL);
+        if (workers[i].failed)
+            ok = false;
+    }
+
+    uint64_t run_count = 0;
+    for (int i = 0; ok && i < thread_count; i++)
+        run_count += workers[i].run_count;
+
+    // Write header, lookup tables, and the runs of every source in cell order
+    SDL_IOStream* io = ok ? SDL_IOFromFile(path, "wb") : NULL;
+    if (ok && !io) {
+        fprintf(stderr, "Could not open %s for writing: %s\n", path, SDL_GetError());
+        ok = false;
+    }
+    if (ok) {
+        CpdHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CPD_MAGIC, 4);
+        header.version = CPD_VERSION;
+        header.width = (uint32_t)map->width;
+        header.height = (uint32_t)map->height;
+        header.map_hash = gridmap_hash(map);
+        header.walkable = (uint32_t)job.walkable;
+        header.run_count = run_count;
+
+        ok = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header) &&
+            SDL_WriteIO(io, rank, sizeof(uint32_t) * cells) == sizeof(uint32_t) * cells &&
+            SDL_WriteIO(io, component, sizeof(uint32_t) * cells) == sizeof(uint32_t) * cells;
+
+        uint64_t first = 0;
+        for (int s = 0; ok && s <= cells; s++) {
+            ok = SDL_WriteIO(io, &first, sizeof(first)) == sizeof(first);
+            if (s < cells)
+                first += job.source_count[s];
+        }
+        for (int s = 0; ok && s < cells; s++) {
+            size_t bytes = sizeof(uint32_t) * job.source_count[s];
+            const uint32_t* runs = workers[job.source_worker[s]].runs + job.source_offset[s];
+            ok = bytes == 0 || SDL_WriteIO(io, runs, bytes) == bytes;
+        }
+    }
+    if (io)
+        SDL_CloseIO(io);
+
+    if (stats) {
+        stats->thread_count = thread_count;
+        stats->build_ms = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / SDL_GetPerformanceFrequency();
+        stats->run_count = run_count;
+        stats->file_bytes = sizeof(CpdHeader) + (uint64_t)cells * (4 + 4 + 8) + 8 + run_count * 4;
+    }
+
+    for (int i = 0; workers && i < thread_count; i++)
+        mem_free(workers[i].runs);
+    mem_free(workers);
+    mem_free(threads);
+    mem_free(rank);
+    mem_free(component);
+    mem_free(order);
+    mem_free(job.source_worker);
+    mem_free(job.source_offset);
+    mem_free(job.source_count);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// Queries
+// ----------------------------------------------------------------------------
+
+CompressedPathDb* cpd_open(const char* path, const GridMap* map) {
+    CompressedPathDb* cpd = mem_calloc(1, sizeof(CompressedPathDb));
+    if (!cpd)
+        return NULL;
+
+#ifdef _WIN32
+    cpd->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (cpd->file == INVALID_HANDLE_VALUE) {
+        mem_free(cpd);
+        return NULL;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(cpd->file, &size);
+    cpd->view_bytes = (size_t)size.QuadPart;
+    cpd->mapping = CreateFileMappingA(cpd->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    cpd->view = cpd->mapping ? MapViewOfFile(cpd->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        mem_free(cpd);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        cpd->view_bytes = (size_t)st.st_size;
+        cpd->view = mmap(NULL, cpd->view_bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (cpd->view == MAP_FAILED)
+            cpd->view = NULL;
+    }
+    close(fd);
+#endif
+
+    // Validate the header and that every table fits in the file
+    const CpdHeader* header = cpd->view;
+    bool ok = cpd->view && cpd->view_bytes >= sizeof(CpdHeader) &&
+        memcmp(header->magic, CPD_MAGIC, 4) == 0 && header->version == CPD_VERSION &&
+        (int)header->width == map->width && (int)header->height == map->height &&
+        header->map_hash == gridmap_hash(map);
+    if (ok) {
+        uint64_t cells = (uint64_t)header->width * header->height;
+        uint64_t expected = sizeof(CpdHeader) + cells * (4 + 4 + 8) + 8 + header->run_count * 4;
+        ok = cpd->view_bytes >= expected;
+    }
+    if (ok) {
+        size_t cells = (size_t)header->width * header->height;
+        const unsigned char* bytes = cpd->view;
+        cpd->width = (int)header->width;
+        cpd->height = (int)header->height;
+        cpd->rank = (const uint32_t*)(bytes + sizeof(CpdHeader));
+        cpd->component = cpd->rank + cells;
+        cpd->first_run = (const uint64_t*)(cpd->component + cells);
+        cpd->runs = (const uint32_t*)(cpd->first_run + cells + 1);
+    }
+    else {
+        cpd_close(cpd);
+        cpd = NULL;
+    }
+    return cpd;
+}
+
+void cpd_close(CompressedPathDb* cpd) {
+    if (!cpd)
+        return;
+#ifdef _WIN32
+    if (cpd->view)
+        UnmapViewOfFile(cpd->view);
+    if (cpd->mapping)
+        CloseHandle(cpd->mapping);
+    if (cpd->file != INVALID_HANDLE_VALUE)
+        CloseHandle(cpd->file);
+#else
+    if (cpd->view)
+        munmap(cpd->view, cpd->view_bytes);
+#endif
+    mem_free(cpd);
+}
+
+// Binary search for the run covering the target's rank
+static int first_move(const CompressedPathDb* cpd, int source, uint32_t target_rank) {
+    uint64_t lo = cpd->first_run[source];
+    uint64_t hi = cpd->first_run[source + 1];
+    while (hi - lo > 1) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (CPD_RUN_RANK(cpd->runs[mid]) <= target_rank)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return CPD_RUN_MOVE(cpd->runs[lo]);
+}
+
+bool cpd_find_path(const CompressedPathDb* cpd, Point from, Point to, PathBuffer* out) {
+    out->length = 0;
+    out->cost = -1;
+
+    if (from.x < 0 || from.x >= cpd->width || from.y < 0 || from.y >= cpd->height ||
+        to.x < 0 || to.x >= cpd->width || to.y < 0 || to.y >= cpd->height)
+        return false;
+    int source = from.y * cpd->width + from.x;
+    int target = to.y * cpd->width + to.x;
+    if (cpd->rank[source] == CPD_NO_RANK || cpd->rank[target] == CPD_NO_RANK ||
+        cpd->component[source] != cpd->component[target] || out->capacity < 1)
+        return false;
+
+    uint32_t target_rank = cpd->rank[target];
+    Point at = from;
+    out->points[out->length++] = at;
+    for (int current = source; current != target; current = at.y * cpd->width + at.x) {
+        if (out->length >= out->capacity) {
+            out->length = 0;
+            return false;
+        }
+        int move = first_move(cpd, current, target_rank);
+        at.x += grid_dx[move];
+        at.y += grid_dy[move];
+        out->points[out->length++] = at;
+    }
+    out->cost = out->length - 1;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Offline tool
+// ----------------------------------------------------------------------------
+
+int cpd_run_build_tool(const char* map_path, int thread_count) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+
+    char cpd_path[1024];
+    SDL_snprintf(cpd_path, sizeof(cpd_path), "%s.cpd", map_path);
+
+    CpdBuildStats stats;
+    if (!cpd_build_file(map, cpd_path, thread_count, &stats)) {
+        fprintf(stderr, "Building %s failed.\n", cpd_path);
+        gridmap_free(map);
+        return 1;
+    }
+
+    int cells = map->width * map->height;
+    int walkable = 0;
+    for (int i = 0; i < cells; i++)
+        walkable += !gridmap_is_wall(map, i);
+
+    printf("Map %s: %dx%d, %d walkable cells\n", map_path, map->width, map->height, walkable);
+    printf("  Build time:  %.1f ms on %d threads\n", stats.build_ms, stats.thread_count);
+    printf("  Runs:        %llu (%.2f per source)\n", (unsigned long long)stats.run_count,
+        walkable ? (double)stats.run_count / walkable : 0.0);
+    printf("  File size:   %.1f KiB (uncompressed 2-bit table: %.1f KiB)\n", stats.file_bytes / 1024.0,
+        (double)walkable * walkable / 4.0 / 1024.0);
+    printf("  Saved to:    %s\n", cpd_path);
+
+    CompressedPathDb* cpd = cpd_open(cpd_path, map);
+    PathBuffer cpd_buffer = { mem_alloc(sizeof(Point) * cells), cells, 0, -1 };
+    PathBuffer ref_buffer = { mem_alloc(sizeof(Point) * cells), cells, 0, -1 };
+    if (cpd && cpd_buffer.points && ref_buffer.points) {
+        Uint64 freq = SDL_GetPerformanceFrequency();
+        Uint64 cpd_ticks = 0, ref_ticks = 0;
+        int queries = 0, mismatches = 0;
+        srand(12345);
+        for (int attempt = 0; attempt < 100000 && queries < 200; attempt++) {
+            Point a = { rand() % map->width, rand() % map->height };
+            Point b = { rand() % map->width, rand() % map->height };
+            if (!gridmap_walkable(map, a.x, a.y) || !gridmap_walkable(map, b.x, b.y))
+                continue;
+
+            Uint64 q0 = SDL_GetPerformanceCounter();
+            cpd_find_path(cpd, a, b, &cpd_buffer);
+            Uint64 q1 = SDL_GetPerformanceCounter();
+            grid_dijkstra(map, a, b, &ref_buffer, NULL);
+            Uint64 q2 = SDL_GetPerformanceCounter();
+            cpd_ticks += q1 - q0;
+            ref_ticks += q2 - q1;
+            if (cpd_buffer.cost != ref_buffer.cost)
+                mismatches++;
+            queries++;
+        }
+        if (queries > 0) {
+            printf("  Query time:  %.2f us (Dijkstra: %.2f us) over %d random queries\n",
+                (double)cpd_ticks * 1e6 / freq / queries, (double)ref_ticks * 1e6 / freq / queries, queries);
+            printf("  Mismatches:  %d\n", mismatches);
+        }
+    }
+
+    mem_free(cpd_buffer.points);
+    mem_free(ref_buffer.points);
+    cpd_close(cpd);
+    gridmap_free(map);
+    return 0;
+}
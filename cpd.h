@@ -0,0 +1,43 @@
+#ifndef CPD_H
+#define CPD_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Compressed path database: for every source cell, the first move of a
+// shortest path to every target, run-length compressed along a DFS order of
+// the cells. Queries need no search, they just follow first moves.
+typedef struct CompressedPathDb CompressedPathDb;
+
+typedef struct {
+    int thread_count;
+    double build_ms;
+    uint64_t run_count;
+    uint64_t file_bytes;
+} CpdBuildStats;
+
+/**
+ * @brief Builds the database for map on thread_count worker threads
+ * (0 = one per logical core) and writes it to path.
+ */
+bool cpd_build_file(const GridMap* map, const char* path, int thread_count, CpdBuildStats* stats);
+
+// Memory-maps a database file. Returns NULL if it is missing, corrupt or for another map.
+CompressedPathDb* cpd_open(const char* path, const GridMap* map);
+void cpd_close(CompressedPathDb* cpd);
+
+/**
+ * @brief Extracts the shortest path one move at a time.
+ * @return true if a path was written to out (out->cost is -1 otherwise).
+ */
+bool cpd_find_path(const CompressedPathDb* cpd, Point from, Point to, PathBuffer* out);
+
+/**
+ * @brief Offline tool: builds <map>.cpd and prints build time, size,
+ * compression and query time against plain Dijkstra.
+ * @return Process exit code.
+ */
+int cpd_run_build_tool(const char* map_path, int thread_count);
+
+#endif // CPD_H
@@ -0,0 +1,170 @@
+#include <SDL3/SDL.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_grid.h"
+#include "min_heap.h"
+
+#define FIXED_GRID_NAME fixed_astar_default
+#define FIXED_GRID_WIDTH GRID_WIDTH
+#define FIXED_GRID_HEIGHT GRID_HEIGHT
+#include "fixed_grid_template.h"
+
+#if GRID_WIDTH != 32 || GRID_HEIGHT != 32
+#define FIXED_GRID_32 1
+#define FIXED_GRID_NAME fixed_astar_32x32
+#define FIXED_GRID_WIDTH 32
+#define FIXED_GRID_HEIGHT 32
+#include "fixed_grid_template.h"
+#endif
+
+typedef bool (*FixedGridEngine)(const unsigned char* walls, int stride, const BlockOverlay* overlay, bool manhattan,
+    Point from, Point to, PathBuffer* out, SearchStats* stats);
+
+// The engine for the map's size, with the walls it reads and their row stride:
+// a flat map's array, or the only tile of a snapshot view no larger than one
+// tile (the visualizer's and most small maps the query server loads)
+static FixedGridEngine engine_for(const GridMap* map, const unsigned char** walls, int* stride) {
+    if (map->walls) {
+        *walls = map->walls;
+        *stride = map->width;
+    }
+    else if (map->tiles_x == 1 && map->height <= MAP_TILE_SIZE) {
+        *walls = map->tiles[0];
+        *stride = MAP_TILE_SIZE;
+    }
+    else {
+        return NULL; // Views over several tiles take the dynamic path
+    }
+    if (map->width == GRID_WIDTH && map->height == GRID_HEIGHT)
+        return fixed_astar_default;
+#ifdef FIXED_GRID_32
+    if (map->width == 32 && map->height == 32)
+        return fixed_astar_32x32;
+#endif
+    return NULL;
+}
+
+bool fixed_grid_supports(const GridMap* map, const SearchOptions* options) {
+    if (options && (options->edge_filter || (options->heuristic && options->heuristic != grid_manhattan_heuristic)))
+        return false;
+    const unsigned char* walls;
+    int stride;
+    return engine_for(map, &walls, &stride) != NULL;
+}
+
+bool fixed_grid_astar(const GridMap* map, Point from, Point to, const SearchOptions* options, PathBuffer* out, SearchStats* stats) {
+    if (!fixed_grid_supports(map, options))
+        return false;
+    SearchStats local;
+    const unsigned char* walls;
+    int stride;
+    engine_for(map, &walls, &stride)(walls, stride, options ? options->overlay : NULL, options && options->heuristic,
+        from, to, out, stats ? stats : &local);
+    return true;
+}
+
+int fixed_grid_run_benchmark_tool(int queries) {
+    if (queries <= 0)
+        queries = 2000;
+    const int sizes[][2] = { { GRID_WIDTH, GRID_HEIGHT }, { 32, 32 } };
+    int status = 0;
+
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        if (s > 0 && width == GRID_WIDTH && height == GRID_HEIGHT)
+            continue;
+        int cells = width * height;
+        Point* points = malloc(sizeof(Point) * cells);
+        Point* fixed_points = malloc(sizeof(Point) * cells);
+        BlockOverlay* overlay = block_overlay_create(width, height);
+        if (!points || !fixed_points || !overlay) {
+            free(points);
+            free(fixed_points);
+            block_overlay_free(overlay);
+            return 1;
+        }
+
+        // Dijkstra like the visualizer, and A* with Manhattan
+        for (int engine = 0; engine < 2; engine++) {
+            Uint64 dynamic_ticks = 0, fixed_ticks = 0;
+            int done = 0, mismatches = 0, paths = 0;
+            for (int m = 0; done < queries; m++) {
+                GridMap* map = gridmap_create_random(width, height, 25, 1000u + m);
+                GridSearch* search = map ? grid_search_create(map) : NULL;
+                if (!search) {
+                    gridmap_free(map);
+                    status = 1;
+                    break;
+                }
+                SearchOptions options = { overlay, engine ? grid_manhattan_heuristic : NULL, map, NULL, NULL };
+                uint32_t state = 77u + m;
+                for (int q = 0; q < 50 && done < queries; q++) {
+                    state = state * 1664525u + 1013904223u;
+                    Point from = { (int)(state >> 8) % width, (int)(state >> 20) % height };
+                    state = state * 1664525u + 1013904223u;
+                    Point to = { (int)(state >> 8) % width, (int)(state >> 20) % height };
+                    if (!gridmap_walkable(map, from.x, from.y) || !gridmap_walkable(map, to.x, to.y) ||
+                        (from.x == to.x && from.y == to.y))
+                        continue;
+                    done++;
+
+                    // The K-loop both ways: block each path's cells for the next search
+                    for (int pass = 0; pass < 2; pass++) {
+                        block_overlay_clear(overlay);
+                        Uint64 t0 = SDL_GetPerformanceCounter();
+                        for (int k = 0; k < K_PATHS; k++) {
+                            PathBuffer path = { pass ? fixed_points : points, cells, 0, -1 };
+                            if (pass) {
+                                SearchStats stats;
+                                fixed_grid_astar(map, from, to, &options, &path, &stats);
+                            }
+                            else {
+                                grid_search_begin(search, from, to, &options);
+                                grid_search_step(search, 0, 0.0);
+                                grid_search_path(search, &path);
+                            }
+                            if (path.cost < 0)
+                                break;
+                            block_overlay_add_path_inner(overlay, path.points, path.length);
+                            if (pass == 0)
+                                paths++;
+                        }
+                        Uint64 t1 = SDL_GetPerformanceCounter();
+                        if (pass)
+                            fixed_ticks += t1 - t0;
+                        else
+                            dynamic_ticks += t1 - t0;
+                    }
+                    // Same heap rules, so the last paths must match point for point
+                    PathBuffer a = { points, cells, 0, -1 }, b = { fixed_points, cells, 0, -1 };
+                    grid_search_begin(search, from, to, &options);
+                    grid_search_step(search, 0, 0.0);
+                    grid_search_path(search, &a);
+                    SearchStats stats;
+                    fixed_grid_astar(map, from, to, &options, &b, &stats);
+                    if (a.cost != b.cost || memcmp(a.points, b.points, sizeof(Point) * a.length) != 0)
+                        mismatches++;
+                }
+                grid_search_free(search);
+                gridmap_free(map);
+            }
+
+            double us = 1e6 / SDL_GetPerformanceFrequency();
+            printf("%dx%d, %s: %d K-loops (%d paths)\n", width, height, engine ? "A* Manhattan" : "Dijkstra", done, paths);
+            printf("  GridSearch:  %.2f us per K-loop\n", (double)dynamic_ticks * us / done);
+            printf("  Specialised: %.2f us per K-loop (%.2fx)\n", (double)fixed_ticks * us / done,
+                fixed_ticks ? (double)dynamic_ticks / fixed_ticks : 0.0);
+            if (mismatches) {
+                printf("  %d results differ!\n", mismatches);
+                status = 1;
+            }
+        }
+        free(points);
+        free(fixed_points);
+        block_overlay_free(overlay);
+    }
+    return status;
+}
@@ -0,0 +1,28 @@
+#ifndef FIXED_GRID_H
+#define FIXED_GRID_H
+
+#include "grid_search.h"
+
+// Search engines specialised at compile time for the map sizes listed in
+// fixed_grid.c: the visualizer's own GRID_WIDTH x GRID_HEIGHT and 32 x 32.
+// They keep the whole search on the stack and fold the strides into
+// constants. grid_astar() and grid_disjoint_paths() use them automatically, on
+// flat maps and on snapshot views that fit in one MAP_TILE_SIZE tile (which
+// covers the visualizer's walls). Any other size, larger views, edge filters
+// and heuristics other than none or Manhattan take the dynamic GridSearch path.
+
+// Whether map and options have a specialised engine
+bool fixed_grid_supports(const GridMap* map, const SearchOptions* options);
+
+/**
+ * @brief grid_astar() on a specialised engine.
+ * @return false, without touching out, if fixed_grid_supports() is false;
+ * otherwise true, with the result (or out->cost == -1) in out.
+ */
+bool fixed_grid_astar(const GridMap* map, Point from, Point to, const SearchOptions* options, PathBuffer* out, SearchStats* stats);
+
+// --bench-small-map tool: K-loop latency of the specialised engines against
+// GridSearch on random maps of each specialised size.
+int fixed_grid_run_benchmark_tool(int queries);
+
+#endif // FIXED_GRID_H
@@ -0,0 +1,119 @@
+// One instance of the fixed-size search engine (see fixed_grid.h). No include
+// guard: include it once per instance after defining
+//   FIXED_GRID_NAME    name of the generated function
+//   FIXED_GRID_WIDTH   map width, a compile-time constant
+//   FIXED_GRID_HEIGHT  map height, a compile-time constant
+// Needs <limits.h>, <stdlib.h>, grid_search.h and min_heap.h (for HeapItem).
+//
+// Same search as GridSearch (A* or Dijkstra, unit costs, lazy deletion) and
+// the same heap rules as min_heap.c, so results are identical move for move.
+// Everything lives on the stack: distances, parents and a frontier that can
+// hold every push a consistent heuristic allows (4 per cell plus the source).
+// Bounds and divisions by the width are constants the compiler folds. Only
+// the walls are read through a row stride, so a flat map (stride W) and a
+// single tile of a snapshot view (stride MAP_TILE_SIZE) share one instance.
+
+static bool FIXED_GRID_NAME(const unsigned char* walls, int stride, const BlockOverlay* overlay, bool manhattan,
+    Point from, Point to, PathBuffer* out, SearchStats* stats) {
+    enum { W = FIXED_GRID_WIDTH, H = FIXED_GRID_HEIGHT, CELLS = W * H };
+    int dist[CELLS];
+    int parent[CELLS];
+    HeapItem heap[4 * CELLS + 1];
+    int count = 0;
+
+    out->length = 0;
+    out->cost = -1;
+    stats->expanded = stats->pushed = 0;
+    if (from.x < 0 || from.x >= W || from.y < 0 || from.y >= H || walls[from.y * stride + from.x] ||
+        to.x < 0 || to.x >= W || to.y < 0 || to.y >= H || walls[to.y * stride + to.x])
+        return false;
+
+    for (int i = 0; i < CELLS; i++) {
+        dist[i] = INT_MAX;
+        parent[i] = -1;
+    }
+    const int source = from.y * W + from.x;
+    const int target = to.y * W + to.x;
+#define FIXED_HEURISTIC(cell) (manhattan ? abs((cell) % W - to.x) + abs((cell) / W - to.y) : 0)
+#define FIXED_PUSH(push_key, push_value) \
+    do { \
+        int i_ = count++; \
+        while (i_ > 0 && heap[(i_ - 1) / 2].key > (push_key)) { \
+            heap[i_] = heap[(i_ - 1) / 2]; \
+            i_ = (i_ - 1) / 2; \
+        } \
+        heap[i_] = (HeapItem){ (push_key), (push_value) }; \
+        stats->pushed++; \
+    } while (0)
+
+    dist[source] = 0;
+    FIXED_PUSH(FIXED_HEURISTIC(source), source);
+
+    bool found = false;
+    while (count > 0) {
+        // Pop, sifting down exactly like heap_pop()
+        HeapItem item = heap[0];
+        HeapItem last = heap[--count];
+        int i = 0;
+        for (;;) {
+            int child = 2 * i + 1;
+            if (child >= count)
+                break;
+            if (child + 1 < count && heap[child + 1].key < heap[child].key)
+                child++;
+            if (last.key <= heap[child].key)
+                break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        if (count > 0)
+            heap[i] = last;
+
+        int current = item.value;
+        if (item.key - FIXED_HEURISTIC(current) > dist[current])
+            continue; // Stale entry, already processed with a lower cost
+
+        stats->expanded++;
+        if (current == target) {
+            found = true;
+            break;
+        }
+
+        // Up, right, down, left, as grid_dx/grid_dy
+        int cx = current % W;
+        int cy = current / W;
+        const int neighbors[4] = { current - W, current + 1, current + W, current - 1 };
+        const int wall_cells[4] = { (cy - 1) * stride + cx, cy * stride + cx + 1, (cy + 1) * stride + cx, cy * stride + cx - 1 };
+        const bool inside[4] = { cy > 0, cx < W - 1, cy < H - 1, cx > 0 };
+        for (int d = 0; d < 4; d++) {
+            int neighbor = neighbors[d];
+            if (!inside[d] || walls[wall_cells[d]])
+                continue;
+            if (overlay && neighbor != target && block_overlay_test(overlay, neighbor % W, neighbor / W))
+                continue;
+            int new_cost = dist[current] + 1;
+            if (new_cost < dist[neighbor]) {
+                dist[neighbor] = new_cost;
+                parent[neighbor] = current;
+                FIXED_PUSH(new_cost + FIXED_HEURISTIC(neighbor), neighbor);
+            }
+        }
+    }
+#undef FIXED_PUSH
+#undef FIXED_HEURISTIC
+
+    if (!found || dist[target] >= out->capacity)
+        return false;
+    out->cost = dist[target];
+    out->length = out->cost + 1;
+    int at = target;
+    for (int i = out->length - 1; i >= 0; i--) {
+        out->points[i] = (Point){ at % W, at / W };
+        at = parent[at];
+    }
+    return true;
+}
+
+#undef FIXED_GRID_NAME
+#undef FIXED_GRID_WIDTH
+#undef FIXED_GRID_HEIGHT
@@ -0,0 +1,310 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "goal_bounds.h"
+#include "grid_search.h"
+#include "mem_track.h"
+
+#define GOAL_BOUNDS_MAGIC "SPGB"
+#define GOAL_BOUNDS_VERSION 1u
+#define GOAL_BOUNDS_MAX_SIDE 0xFFFF
+
+// Empty when min_x > max_x
+typedef struct {
+    uint16_t min_x, min_y, max_x, max_y;
+} GoalBox;
+
+struct GoalBounds {
+    int width, height;
+    uint64_t map_hash;
+    GoalBox* boxes; // 4 per cell, indexed cell * 4 + direction
+};
+
+typedef struct {
+    const GridMap* map;
+    GoalBounds* bounds;
+    SDL_AtomicInt next_source;
+    SDL_AtomicInt failed;
+} GoalBoundsJob;
+
+// One all-targets BFS per source; each source only writes its own 4 boxes,
+// so workers never touch the same memory.
+static int goal_bounds_worker(void* data) {
+    GoalBoundsJob* job = data;
+    const GridMap* map = job->map;
+    int cells = map->width * map->height;
+
+    int* dist = mem_alloc(sizeof(int) * cells);
+    unsigned char* moves = mem_alloc(cells); // Bit d set: a shortest path starts with move d
+    int* queue = mem_alloc(sizeof(int) * cells);
+    if (!dist || !moves || !queue) {
+        SDL_SetAtomicInt(&job->failed, 1);
+        mem_free(dist);
+        mem_free(moves);
+        mem_free(queue);
+        return 0;
+    }
+
+    for (;;) {
+        int source = SDL_AddAtomicInt(&job->next_source, 1);
+        if (source >= cells)
+            break;
+
+        GoalBox* box = job->bounds->boxes + (size_t)source * 4;
+        for (int d = 0; d < 4; d++)
+            box[d] = (GoalBox){ 1, 1, 0, 0 };
+        if (gridmap_is_wall(map, source))
+            continue;
+
+        for (int i = 0; i < cells; i++)
+            dist[i] = -1;
+        int head = 0, tail = 0;
+        dist[source] = 0;
+        moves[source] = 0;
+        queue[tail++] = source;
+        while (head < tail) {
+            int current = queue[head++];
+            int cx = current % map->width;
+            int cy = current / map->width;
+            for (int d = 0; d < 4; d++) {
+                int nx = cx + grid_dx[d];
+                int ny = cy + grid_dy[d];
+                if (!gridmap_walkable(map, nx, ny))
+                    continue;
+                int neighbor = gridmap_index(map, nx, ny);
+                unsigned char inherited = current == source ? (unsigned char)(1u << d) : moves[current];
+                if (dist[neighbor] < 0) {
+                    dist[neighbor] = dist[current] + 1;
+                    moves[neighbor] = inherited;
+                    queue[tail++] = neighbor;
+                }
+                else if (dist[neighbor] == dist[current] + 1) {
+                    moves[neighbor] |= inherited; // Another shortest path, via another first move
+                }
+            }
+        }
+
+        // Grow the box of every first move that reaches each target optimally
+        for (int i = 1; i < tail; i++) {
+            int target = queue[i];
+            uint16_t tx = (uint16_t)(target % map->width);
+            uint16_t ty = (uint16_t)(target / map->width);
+            for (int d = 0; d < 4; d++) {
+                if (!(moves[target] & (1u << d)))
+                    continue;
+                if (box[d].min_x > box[d].max_x) {
+                    box[d] = (GoalBox){ tx, ty, tx, ty };
+                    continue;
+                }
+                if (tx < box[d].min_x) box[d].min_x = tx;
+                if (tx > box[d].max_x) box[d].max_x = tx;
+                if (ty < box[d].min_y) box[d].min_y = ty;
+                if (ty > box[d].max_y) box[d].max_y = ty;
+            }
+        }
+    }
+
+    mem_free(dist);
+    mem_free(moves);
+    mem_free(queue);
+    return 0;
+}
+
+static GoalBounds* goal_bounds_alloc(int width, int height) {
+    if (width > GOAL_BOUNDS_MAX_SIDE || height > GOAL_BOUNDS_MAX_SIDE)
+        return NULL;
+    GoalBounds* bounds = mem_calloc(1, sizeof(GoalBounds));
+    if (!bounds)
+        return NULL;
+    bounds->width = width;
+    bounds->height = height;
+    bounds->boxes = mem_alloc(sizeof(GoalBox) * 4 * (size_t)width * height);
+    if (!bounds->boxes) {
+        mem_free(bounds);
+        return NULL;
+    }
+    return bounds;
+}
+
+GoalBounds* goal_bounds_build(const GridMap* map, int thread_count, GoalBoundsBuildStats* stats) {
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    if (thread_count <= 0)
+        thread_count = SDL_GetNumLogicalCPUCores();
+    if (thread_count < 1)
+        thread_count = 1;
+
+    GoalBounds* bounds = goal_bounds_alloc(map->width, map->height);
+    SDL_Thread** threads = mem_calloc(thread_count, sizeof(SDL_Thread*));
+    if (!bounds || !threads) {
+        goal_bounds_free(bounds);
+        mem_free(threads);
+        return NULL;
+    }
+    bounds->map_hash = gridmap_hash(map);
+
+    GoalBoundsJob job;
+    job.map = map;
+    job.bounds = bounds;
+    SDL_SetAtomicInt(&job.next_source, 0);
+    SDL_SetAtomicInt(&job.failed, 0);
+
+    // The calling thread is one of the workers (and covers failed thread creation)
+    for (int i = 1; i < thread_count; i++)
+        threads[i] = SDL_CreateThread(goal_bounds_worker, "goal-bounds", &job);
+    goal_bounds_worker(&job);
+    for (int i = 1; i < thread_count; i++)
+        SDL_WaitThread(threads[i], NULL);
+    mem_free(threads);
+
+    if (SDL_GetAtomicInt(&job.failed)) {
+        goal_bounds_free(bounds);
+        return NULL;
+    }
+
+    if (stats) {
+        stats->thread_count = thread_count;
+        stats->build_ms = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / SDL_GetPerformanceFrequency();
+        stats->bytes = sizeof(GoalBox) * 4 * (size_t)map->width * map->height;
+    }
+    return bounds;
+}
+
+void goal_bounds_free(GoalBounds* bounds) {
+    if (!bounds)
+        return;
+    mem_free(bounds->boxes);
+    mem_free(bounds);
+}
+
+bool goal_bounds_save(const GoalBounds* bounds, const char* path) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        fprintf(stderr, "Could not open %s for writing: %s\n", path, SDL_GetError());
+        return false;
+    }
+
+    uint32_t header[3] = { GOAL_BOUNDS_VERSION, (uint32_t)bounds->width, (uint32_t)bounds->height };
+    size_t bytes = sizeof(GoalBox) * 4 * (size_t)bounds->width * bounds->height;
+    bool ok = SDL_WriteIO(io, GOAL_BOUNDS_MAGIC, 4) == 4 &&
+        SDL_WriteIO(io, header, sizeof(header)) == sizeof(header) &&
+        SDL_WriteIO(io, &bounds->map_hash, sizeof(bounds->map_hash)) == sizeof(bounds->map_hash) &&
+        SDL_WriteIO(io, bounds->boxes, bytes) == bytes;
+
+    SDL_CloseIO(io);
+    return ok;
+}
+
+GoalBounds* goal_bounds_load(const char* path, const GridMap* map) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+    if (!io)
+        return NULL;
+
+    char magic[4];
+    uint32_t header[3];
+    uint64_t map_hash;
+    GoalBounds* bounds = NULL;
+    if (SDL_ReadIO(io, magic, 4) == 4 && memcmp(magic, GOAL_BOUNDS_MAGIC, 4) == 0 &&
+        SDL_ReadIO(io, header, sizeof(header)) == sizeof(header) &&
+        SDL_ReadIO(io, &map_hash, sizeof(map_hash)) == sizeof(map_hash) &&
+        header[0] == GOAL_BOUNDS_VERSION && (int)header[1] == map->width && (int)header[2] == map->height &&
+        map_hash == gridmap_hash(map)) {
+        bounds = goal_bounds_alloc(map->width, map->height);
+    }
+
+    if (bounds) {
+        bounds->map_hash = map_hash;
+        size_t bytes = sizeof(GoalBox) * 4 * (size_t)bounds->width * bounds->height;
+        if (SDL_ReadIO(io, bounds->boxes, bytes) != bytes) {
+            fprintf(stderr, "%s is corrupt, ignoring it.\n", path);
+            goal_bounds_free(bounds);
+            bounds = NULL;
+        }
+    }
+
+    SDL_CloseIO(io);
+    return bounds;
+}
+
+bool goal_bounds_allows(const void* context, int cell, int direction, int target) {
+    const GoalBounds* bounds = context;
+    const GoalBox* box = &bounds->boxes[(size_t)cell * 4 + direction];
+    int tx = target % bounds->width;
+    int ty = target / bounds->width;
+    return tx >= box->min_x && tx <= box->max_x && ty >= box->min_y && ty <= box->max_y;
+}
+
+int goal_bounds_run_build_tool(const char* map_path, int thread_count) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+
+    GoalBoundsBuildStats stats;
+    GoalBounds* bounds = goal_bounds_build(map, thread_count, &stats);
+    if (!bounds) {
+        fprintf(stderr, "Building goal bounds failed (out of memory or map too large).\n");
+        gridmap_free(map);
+        return 1;
+    }
+
+    char gb_path[1024];
+    SDL_snprintf(gb_path, sizeof(gb_path), "%s.gb", map_path);
+    bool saved = goal_bounds_save(bounds, gb_path);
+
+    printf("Map %s: %dx%d\n", map_path, map->width, map->height);
+    printf("  Build time:  %.1f ms on %d threads\n", stats.build_ms, stats.thread_count);
+    printf("  Memory:      %.1f KiB (%d bytes per cell)\n", stats.bytes / 1024.0, (int)(sizeof(GoalBox) * 4));
+    printf("  Saved to:    %s%s\n", gb_path, saved ? "" : " (FAILED)");
+
+    enum { ENGINE_DIJKSTRA, ENGINE_DIJKSTRA_GB, ENGINE_ASTAR, ENGINE_ASTAR_GB, ENGINE_COUNT };
+    const char* engine_names[ENGINE_COUNT] = { "Dijkstra", "Dijkstra + GB", "A* Manhattan", "A* + GB" };
+    SearchOptions options[ENGINE_COUNT] = {
+        { NULL, NULL, NULL, NULL, NULL },
+        { NULL, NULL, NULL, goal_bounds_allows, bounds },
+        { NULL, grid_manhattan_heuristic, map, NULL, NULL },
+        { NULL, grid_manhattan_heuristic, map, goal_bounds_allows, bounds },
+    };
+    long long expanded[ENGINE_COUNT] = { 0 };
+    Uint64 ticks[ENGINE_COUNT] = { 0 };
+
+    int cells = map->width * map->height;
+    PathBuffer buffer = { mem_alloc(sizeof(Point) * cells), cells, 0, -1 };
+    int queries = 0, mismatches = 0;
+    srand(12345);
+    for (int attempt = 0; buffer.points && attempt < 100000 && queries < 200; attempt++) {
+        Point a = { rand() % map->width, rand() % map->height };
+        Point b = { rand() % map->width, rand() % map->height };
+        if (!gridmap_walkable(map, a.x, a.y) || !gridmap_walkable(map, b.x, b.y))
+            continue;
+
+        int reference_cost = 0;
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            SearchStats search_stats;
+            Uint64 q0 = SDL_GetPerformanceCounter();
+            grid_astar(map, a, b, &options[e], &buffer, &search_stats);
+            ticks[e] += SDL_GetPerformanceCounter() - q0;
+            expanded[e] += search_stats.expanded;
+            if (e == ENGINE_DIJKSTRA)
+                reference_cost = buffer.cost;
+            else if (buffer.cost != reference_cost)
+                mismatches++;
+        }
+        queries++;
+    }
+
+    if (queries > 0) {
+        Uint64 freq = SDL_GetPerformanceFrequency();
+        printf("  %-14s %14s %10s %9s\n", "Engine", "Expanded/query", "us/query", "Speedup");
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            printf("  %-14s %14.0f %10.1f %8.1fx\n", engine_names[e], (double)expanded[e] / queries,
+                (double)ticks[e] * 1e6 / freq / queries, (double)ticks[ENGINE_DIJKSTRA] / (ticks[e] ? ticks[e] : 1));
+        }
+        printf("  %d queries, %d cost mismatches\n", queries, mismatches);
+    }
+
+    mem_free(buffer.points);
+    goal_bounds_free(bounds);
+    gridmap_free(map);
+    return saved ? 0 : 1;
+}
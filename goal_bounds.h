@@ -0,0 +1,38 @@
+#ifndef GOAL_BOUNDS_H
+#define GOAL_BOUNDS_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Goal bounding: for every cell and each of the 4 moves in grid_dx/grid_dy,
+// the bounding box of all targets that some shortest path reaches by taking
+// that move first. A search may skip a move whose box does not contain the
+// target without losing optimality (as long as no extra cells are blocked).
+typedef struct GoalBounds GoalBounds;
+
+typedef struct {
+    int thread_count;
+    double build_ms;
+    size_t bytes;
+} GoalBoundsBuildStats;
+
+// thread_count 0 = one worker per logical core
+GoalBounds* goal_bounds_build(const GridMap* map, int thread_count, GoalBoundsBuildStats* stats);
+void goal_bounds_free(GoalBounds* bounds);
+
+bool goal_bounds_save(const GoalBounds* bounds, const char* path);
+// Returns NULL if the file is missing, corrupt or was built for a different map.
+GoalBounds* goal_bounds_load(const char* path, const GridMap* map);
+
+// SearchEdgeFilter for grid_astar(); context is the GoalBounds.
+bool goal_bounds_allows(const void* context, int cell, int direction, int target);
+
+/**
+ * @brief Offline tool: builds <map>.gb and prints build time, memory and the
+ * speedup of Dijkstra and A* with pruning over random queries.
+ * @return Process exit code.
+ */
+int goal_bounds_run_build_tool(const char* map_path, int thread_count);
+
+#endif // GOAL_BOUNDS_H
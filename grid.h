@@ -0,0 +1,50 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdbool.h>
+
+#define GRID_WIDTH 20
+#define GRID_HEIGHT 15
+#define CELL_SIZE 40
+// K_PATHS is how many disjoint paths to find
+#define K_PATHS 5
+
+typedef enum {
+    CELL_EMPTY,
+    CELL_WALL,
+    CELL_START, // Will be Green
+    CELL_END,   // Will be Red
+    // Specific path types for different shades of blue
+    CELL_PATH_1,
+    CELL_PATH_2,
+    CELL_PATH_3,
+    CELL_PATH_4,
+    CELL_PATH_5
+} CellType;
+
+typedef struct {
+    int x, y;
+} Point;
+
+// Struct for Dijkstra's priority queue
+typedef struct Node {
+    Point pos;
+    int cost;
+} Node;
+
+// Struct to store a single complete path
+typedef struct {
+    Point points[GRID_WIDTH * GRID_HEIGHT]; // Max possible path length
+    int length;
+    int cost;
+} Path;
+
+extern CellType grid[GRID_HEIGHT][GRID_WIDTH]; // Main grid for walls, start, end
+extern CellType grid_path_type[GRID_HEIGHT][GRID_WIDTH]; // Stores which path type a cell is (CELL_PATH_1, etc.)
+extern Point start;
+extern Point end;
+
+bool is_valid_position(int x, int y);
+Path dijkstra_find_path(void);
+
+#endif // GRID_H
@@ -0,0 +1,139 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid_map.h"
+#include "mem_track.h"
+
+#define GRIDMAP_MAGIC "SPGM"
+#define GRIDMAP_VERSION 1u
+
+const int grid_dx[4] = { 0, 1, 0, -1 };
+const int grid_dy[4] = { -1, 0, 1, 0 };
+
+GridMap* gridmap_create(int width, int height) {
+    if (width <= 0 || height <= 0)
+        return NULL;
+
+    GridMap* map = mem_alloc(sizeof(GridMap));
+    if (!map)
+        return NULL;
+    map->width = width;
+    map->height = height;
+    map->tiles = NULL;
+    map->tiles_x = 0;
+    map->walls = mem_calloc((size_t)width * height, 1);
+    if (!map->walls) {
+        mem_free(map);
+        return NULL;
+    }
+    return map;
+}
+
+/**
+ * @brief Copies the walls of the global grid. Start, end and path cells count as walkable.
+ */
+GridMap* gridmap_from_grid(void) {
+    GridMap* map = gridmap_create(GRID_WIDTH, GRID_HEIGHT);
+    if (!map)
+        return NULL;
+
+    for (int y = 0; y < GRID_HEIGHT; y++) {
+        for (int x = 0; x < GRID_WIDTH; x++)
+            map->walls[y * GRID_WIDTH + x] = (grid[y][x] == CELL_WALL);
+    }
+    return map;
+}
+
+/**
+ * @brief Random map like initialize_grid(), but reproducible and of any size.
+ * Uses its own xorshift generator so it does not disturb rand().
+ */
+GridMap* gridmap_create_random(int width, int height, int wall_percent, unsigned int seed) {
+    GridMap* map = gridmap_create(width, height);
+    if (!map)
+        return NULL;
+
+    uint32_t state = seed ? seed : 0x9E3779B9u;
+    size_t cells = (size_t)width * height;
+    for (size_t i = 0; i < cells; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        map->walls[i] = (int)(state % 100) < wall_percent;
+    }
+    return map;
+}
+
+void gridmap_free(GridMap* map) {
+    if (!map)
+        return;
+    mem_free(map->walls);
+    mem_free(map);
+}
+
+bool gridmap_save(const GridMap* map, const char* path) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        fprintf(stderr, "Could not open %s for writing: %s\n", path, SDL_GetError());
+        return false;
+    }
+
+    uint32_t header[3] = { GRIDMAP_VERSION, (uint32_t)map->width, (uint32_t)map->height };
+    bool ok = SDL_WriteIO(io, GRIDMAP_MAGIC, 4) == 4 &&
+        SDL_WriteIO(io, header, sizeof(header)) == sizeof(header);
+
+    // Row by row, so tiled views can be saved as well
+    unsigned char* row = mem_alloc(map->width);
+    ok = ok && row;
+    for (int y = 0; ok && y < map->height; y++) {
+        for (int x = 0; x < map->width; x++)
+            row[x] = gridmap_wall_xy(map, x, y);
+        ok = SDL_WriteIO(io, row, map->width) == (size_t)map->width;
+    }
+    mem_free(row);
+
+    SDL_CloseIO(io);
+    return ok;
+}
+
+GridMap* gridmap_load(const char* path) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+    if (!io) {
+        fprintf(stderr, "Could not open %s: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    char magic[4];
+    uint32_t header[3];
+    GridMap* map = NULL;
+    if (SDL_ReadIO(io, magic, 4) == 4 && memcmp(magic, GRIDMAP_MAGIC, 4) == 0 &&
+        SDL_ReadIO(io, header, sizeof(header)) == sizeof(header) &&
+        header[0] == GRIDMAP_VERSION) {
+        map = gridmap_create((int)header[1], (int)header[2]);
+        size_t cells = (size_t)header[1] * header[2];
+        if (map && SDL_ReadIO(io, map->walls, cells) != cells) {
+            gridmap_free(map);
+            map = NULL;
+        }
+    }
+
+    if (!map)
+        fprintf(stderr, "%s is not a valid map file.\n", path);
+    SDL_CloseIO(io);
+    return map;
+}
+
+uint64_t gridmap_hash(const GridMap* map) {
+    uint64_t hash = 14695981039346656037ull;
+    uint32_t dims[2] = { (uint32_t)map->width, (uint32_t)map->height };
+    const unsigned char* bytes = (const unsigned char*)dims;
+    for (size_t i = 0; i < sizeof(dims); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+    size_t cells = (size_t)map->width * map->height;
+    for (size_t i = 0; i < cells; i++)
+        hash = (hash ^ gridmap_is_wall(map, (int)i)) * 1099511628211ull;
+    return hash;
+}
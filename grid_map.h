@@ -0,0 +1,85 @@
+#ifndef GRID_MAP_H
+#define GRID_MAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+// Side of the square tiles used by tiled map views (see map_snapshot.h)
+#define MAP_TILE_SHIFT 6
+#define MAP_TILE_SIZE (1 << MAP_TILE_SHIFT)
+
+// A static map of any size: just the walls, one byte per cell (1 = wall).
+// The preprocessing engines (and their offline tools) work on this instead of
+// the fixed-size global grid so they can be run on real floor plans.
+// Read cells through gridmap_is_wall()/gridmap_walkable(): a map is either a
+// flat array (walls) or a read-only view over shared tiles (tiles, walls NULL).
+typedef struct {
+    int width;
+    int height;
+    unsigned char* walls;
+    const unsigned char* const* tiles; // tiles_x * tiles_y tiles of MAP_TILE_SIZE^2 cells
+    int tiles_x;
+} GridMap;
+
+// Caller-owned output for engines that return a path on a GridMap. It is the
+// same list of points the renderer consumes through Path.points.
+typedef struct {
+    Point* points;
+    int capacity;
+    int length;
+    int cost; // -1 if no path was found
+} PathBuffer;
+
+// Neighbour order used everywhere: up, right, down, left (as in dijkstra_find_path)
+extern const int grid_dx[4];
+extern const int grid_dy[4];
+
+GridMap* gridmap_create(int width, int height);
+GridMap* gridmap_from_grid(void);
+GridMap* gridmap_create_random(int width, int height, int wall_percent, unsigned int seed);
+void gridmap_free(GridMap* map);
+
+// Binary map format: "SPGM", version, width, height, then one byte per cell.
+bool gridmap_save(const GridMap* map, const char* path);
+GridMap* gridmap_load(const char* path);
+
+// FNV-1a over the size and walls; preprocessed data stores it to detect a stale map.
+uint64_t gridmap_hash(const GridMap* map);
+
+static inline int gridmap_index(const GridMap* map, int x, int y) {
+    return y * map->width + x;
+}
+
+static inline bool gridmap_wall_xy(const GridMap* map, int x, int y) {
+    if (map->walls)
+        return map->walls[y * map->width + x] != 0;
+    return map->tiles[(y >> MAP_TILE_SHIFT) * map->tiles_x + (x >> MAP_TILE_SHIFT)]
+        [((y & (MAP_TILE_SIZE - 1)) << MAP_TILE_SHIFT) | (x & (MAP_TILE_SIZE - 1))] != 0;
+}
+
+static inline bool gridmap_is_wall(const GridMap* map, int index) {
+    if (map->walls)
+        return map->walls[index] != 0;
+    return gridmap_wall_xy(map, index % map->width, index / map->width);
+}
+
+static inline bool gridmap_walkable(const GridMap* map, int x, int y) {
+    return x >= 0 && x < map->width && y >= 0 && y < map->height &&
+        !gridmap_wall_xy(map, x, y);
+}
+
+// Wraps a Path so an engine can write straight into its points array.
+// Copy length and cost back with path_buffer_store() afterwards.
+static inline PathBuffer path_buffer_for(Path* path) {
+    PathBuffer buffer = { path->points, GRID_WIDTH * GRID_HEIGHT, 0, -1 };
+    return buffer;
+}
+
+static inline void path_buffer_store(const PathBuffer* buffer, Path* path) {
+    path->length = buffer->length;
+    path->cost = buffer->cost;
+}
+
+#endif // GRID_MAP_H
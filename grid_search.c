@@ -0,0 +1,304 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "grid_search.h"
+#include "min_heap.h"
+#include "fixed_grid.h"
+#include "mem_track.h"
+
+// Expansions between two reads of the performance counter in grid_search_step()
+#define SEARCH_CLOCK_INTERVAL 64
+
+struct GridSearch {
+    const GridMap* map;
+    int cells;
+    int* dist;
+    int* parent;
+    MinHeap heap;
+
+    SearchOptions options; // Copied; options.overlay must outlive the search
+    int source;
+    int target;
+    SearchStatus status;
+    SearchStats stats;
+};
+
+bool grid_dijkstra(const GridMap* map, Point from, Point to, PathBuffer* out, SearchStats* stats) {
+    return grid_astar(map, from, to, NULL, out, stats);
+}
+
+int grid_manhattan_heuristic(const void* context, int cell, int target) {
+    const GridMap* map = context;
+    return abs(cell % map->width - target % map->width) + abs(cell / map->width - target / map->width);
+}
+
+GridSearch* grid_search_create(const GridMap* map) {
+    GridSearch* search = mem_calloc(1, sizeof(GridSearch));
+    if (!search)
+        return NULL;
+    search->map = map;
+    search->cells = map->width * map->height;
+    search->dist = mem_alloc(sizeof(int) * search->cells);
+    search->parent = mem_alloc(sizeof(int) * search->cells);
+    if (!search->dist || !search->parent) {
+        grid_search_free(search);
+        return NULL;
+    }
+    heap_init(&search->heap, 256);
+    search->status = SEARCH_NO_PATH;
+    return search;
+}
+
+void grid_search_free(GridSearch* search) {
+    if (!search)
+        return;
+    heap_free(&search->heap);
+    mem_free(search->dist);
+    mem_free(search->parent);
+    mem_free(search);
+}
+
+static inline int search_heuristic(const GridSearch* search, int cell) {
+    return search->options.heuristic ?
+        search->options.heuristic(search->options.heuristic_context, cell, search->target) : 0;
+}
+
+SearchStatus grid_search_begin(GridSearch* search, Point from, Point to, const SearchOptions* options) {
+    static const SearchOptions no_options = { NULL, NULL, NULL, NULL, NULL };
+    search->options = options ? *options : no_options;
+    search->stats.expanded = search->stats.pushed = 0;
+    heap_clear(&search->heap);
+
+    const GridMap* map = search->map;
+    if (!gridmap_walkable(map, from.x, from.y) || !gridmap_walkable(map, to.x, to.y)) {
+        search->status = SEARCH_NO_PATH;
+        return search->status;
+    }
+
+    for (int i = 0; i < search->cells; i++) {
+        search->dist[i] = INT_MAX;
+        search->parent[i] = -1;
+    }
+    search->source = gridmap_index(map, from.x, from.y);
+    search->target = gridmap_index(map, to.x, to.y);
+    search->dist[search->source] = 0;
+    heap_push(&search->heap, search_heuristic(search, search->source), search->source);
+    search->stats.pushed++;
+    search->status = SEARCH_RUNNING;
+    return search->status;
+}
+
+SearchStatus grid_search_step(GridSearch* search, int max_expansions, double max_ms) {
+    if (search->status != SEARCH_RUNNING)
+        return search->status;
+
+    // Everything the loop needs is in the object, so resuming is just re-entering it
+    const GridMap* map = search->map;
+    int* dist = search->dist;
+    int* parent = search->parent;
+    const BlockOverlay* overlay = search->options.overlay;
+    SearchEdgeFilter edge_filter = search->options.edge_filter;
+    const void* edge_filter_context = search->options.edge_filter_context;
+    int target = search->target;
+
+    Uint64 deadline = 0;
+    if (max_ms > 0.0)
+        deadline = SDL_GetPerformanceCounter() + (Uint64)(max_ms * SDL_GetPerformanceFrequency() / 1000.0);
+    int expanded = 0;
+
+    while (!heap_empty(&search->heap)) {
+        if (max_expansions > 0 && expanded >= max_expansions)
+            return SEARCH_RUNNING;
+        if (deadline && expanded > 0 && expanded % SEARCH_CLOCK_INTERVAL == 0 &&
+            SDL_GetPerformanceCounter() >= deadline)
+            return SEARCH_RUNNING;
+
+        HeapItem item = heap_pop(&search->heap);
+        int current = item.value;
+        if (item.key - search_heuristic(search, current) > dist[current])
+            continue; // Stale entry, already processed with a lower cost
+
+        expanded++;
+        search->stats.expanded++;
+        if (current == target) {
+            search->status = SEARCH_FOUND;
+            return search->status;
+        }
+
+        int cx = current % map->width;
+        int cy = current / map->width;
+        for (int i = 0; i < 4; i++) {
+            int nx = cx + grid_dx[i];
+            int ny = cy + grid_dy[i];
+            if (!gridmap_walkable(map, nx, ny))
+                continue;
+            if (edge_filter && !edge_filter(edge_filter_context, current, i, target))
+                continue;
+
+            int neighbor = gridmap_index(map, nx, ny);
+            if (overlay && neighbor != target && block_overlay_test(overlay, nx, ny))
+                continue;
+
+            int new_cost = dist[current] + 1; // cost per move = 1
+            if (new_cost < dist[neighbor]) {
+                dist[neighbor] = new_cost;
+                parent[neighbor] = current;
+                heap_push(&search->heap, new_cost + search_heuristic(search, neighbor), neighbor);
+                search->stats.pushed++;
+            }
+        }
+    }
+
+    search->status = SEARCH_NO_PATH;
+    return search->status;
+}
+
+SearchStatus grid_search_status(const GridSearch* search) {
+    return search->status;
+}
+
+SearchStats grid_search_stats(const GridSearch* search) {
+    return search->stats;
+}
+
+bool grid_search_expanded(const GridSearch* search, int x, int y) {
+    const GridMap* map = search->map;
+    if (x < 0 || x >= map->width || y < 0 || y >= map->height)
+        return false;
+    int cell = gridmap_index(map, x, y);
+    if (search->dist[cell] == INT_MAX)
+        return false;
+    // Entries keyed below the target's are all popped before it
+    if (search->status == SEARCH_FOUND)
+        return search->dist[cell] + search_heuristic(search, cell) <=
+            search->dist[search->target] + search_heuristic(search, search->target);
+    return true;
+}
+
+bool grid_search_path(const GridSearch* search, PathBuffer* out) {
+    out->length = 0;
+    out->cost = -1;
+    if (search->status != SEARCH_FOUND || search->dist[search->target] >= out->capacity)
+        return false;
+
+    // --- Path Reconstruction ---
+    int width = search->map->width;
+    out->cost = search->dist[search->target];
+    out->length = out->cost + 1;
+    int at = search->target;
+    for (int i = out->length - 1; i >= 0; i--) {
+        out->points[i] = (Point){ at % width, at / width };
+        at = search->parent[at];
+    }
+    return true;
+}
+
+int grid_search_path_runs(const GridSearch* search, int first_cell, int last_cell, PathRun* runs, int capacity) {
+    if (search->status != SEARCH_FOUND)
+        return -1;
+    int cost = search->dist[search->target];
+    if (first_cell < 0)
+        first_cell = 0;
+    if (last_cell > cost)
+        last_cell = cost;
+    if (first_cell > last_cell)
+        return 0;
+
+    // Walk back from the target to the last wanted cell, then collect runs
+    // backwards and flip them at the end
+    int width = search->map->width;
+    const int* parent = search->parent;
+    int at = search->target;
+    for (int i = cost; i > last_cell; i--)
+        at = parent[at];
+
+    int found = 0;
+    int remaining = last_cell - first_cell + 1; // Cells still to put into runs
+    while (remaining > 0) {
+        if (found == capacity)
+            return -1;
+        // A run is the cell at, its predecessors entered by the same step, and
+        // the cell that step comes from
+        PathRun* run = &runs[found++];
+        int step = 0;
+        run->length = 1;
+        remaining--;
+        if (remaining > 0) {
+            step = at - parent[at];
+            while (remaining > 0 && at - parent[at] == step) {
+                at = parent[at];
+                run->length++;
+                remaining--;
+            }
+        }
+        run->start = (Point){ at % width, at / width };
+        run->direction = step == 1 ? 1 : step == -1 ? 3 : step == width ? 2 : 0;
+        if (remaining > 0)
+            at = parent[at];
+    }
+
+    for (int i = 0, j = found - 1; i < j; i++, j--) {
+        PathRun tmp = runs[i];
+        runs[i] = runs[j];
+        runs[j] = tmp;
+    }
+    return found;
+}
+
+int grid_disjoint_paths(GridSearch* search, Point from, Point to, int k, const SearchOptions* options,
+    BlockOverlay* overlay, Point* points, int capacity, PathBuffer* paths) {
+    const GridMap* map = search->map;
+    block_overlay_clear(overlay);
+    SearchOptions path_options = options ? *options : (SearchOptions){ NULL, NULL, NULL, NULL, NULL };
+    path_options.overlay = overlay;
+
+    // Small maps run on the engine specialised for their size
+    bool fixed = fixed_grid_supports(map, &path_options);
+    int found = 0;
+    int used = 0;
+    while (found < k) {
+        PathBuffer* path = &paths[found];
+        path->points = points + used;
+        path->capacity = capacity - used;
+        if (fixed) {
+            SearchStats stats;
+            fixed_grid_astar(map, from, to, &path_options, path, &stats);
+            if (path->cost < 0)
+                break;
+        }
+        else {
+            grid_search_begin(search, from, to, &path_options);
+            grid_search_step(search, 0, 0.0);
+            if (!grid_search_path(search, path))
+                break;
+        }
+
+        used += path->length;
+        found++;
+        if (!block_overlay_add_path_inner(overlay, path->points, path->length))
+            break;
+    }
+    return found;
+}
+
+bool grid_astar(const GridMap* map, Point from, Point to, const SearchOptions* options, PathBuffer* out, SearchStats* stats) {
+    out->length = 0;
+    out->cost = -1;
+    if (stats)
+        stats->expanded = stats->pushed = 0;
+    if (fixed_grid_astar(map, from, to, options, out, stats))
+        return out->cost != -1;
+
+    GridSearch* search = grid_search_create(map);
+    if (!search)
+        return false;
+    grid_search_begin(search, from, to, options);
+    grid_search_step(search, 0, 0.0);
+    grid_search_path(search, out);
+    if (stats)
+        *stats = search->stats;
+    grid_search_free(search);
+    return out->cost != -1;
+}
@@ -0,0 +1,108 @@
+#ifndef GRID_SEARCH_H
+#define GRID_SEARCH_H
+
+#include "block_overlay.h"
+#include "grid_map.h"
+#include "path_runs.h"
+
+// Counters filled in by the GridMap search routines.
+typedef struct {
+    int expanded; // nodes taken off the queue and expanded
+    int pushed;   // queue insertions
+} SearchStats;
+
+// Lower bound on the remaining cost from cell to target (both map indices).
+typedef int (*SearchHeuristic)(const void* context, int cell, int target);
+
+// Whether the move in direction (index into grid_dx/grid_dy) out of cell may be
+// taken on the way to target. Used by preprocessing that prunes whole subtrees.
+typedef bool (*SearchEdgeFilter)(const void* context, int cell, int direction, int target);
+
+typedef struct {
+    // Optional: cells that are temporarily blocked on top of the walls, e.g.
+    // the cells of paths already found. The target is always allowed. Only
+    // read, so one map can serve many queries with an overlay each.
+    const BlockOverlay* overlay;
+    // Optional: A* heuristic; Dijkstra when NULL
+    SearchHeuristic heuristic;
+    const void* heuristic_context;
+    // Optional: moves to skip
+    SearchEdgeFilter edge_filter;
+    const void* edge_filter_context;
+} SearchOptions;
+
+/**
+ * @brief A* (unit cost per move) on a GridMap using a binary heap.
+ * The heuristic must be admissible (never overestimate) for the result to be shortest.
+ * @return true if a path was written to out (out->cost is -1 otherwise).
+ */
+bool grid_astar(const GridMap* map, Point from, Point to, const SearchOptions* options, PathBuffer* out, SearchStats* stats);
+
+typedef enum {
+    SEARCH_RUNNING, // Budget used up; call grid_search_step() again
+    SEARCH_FOUND,
+    SEARCH_NO_PATH
+} SearchStatus;
+
+// A* that can be paused and resumed: the frontier, distances and parents all
+// live in the object, so the main loop can run it in the slack of each frame
+// without a thread. One object can be reused for any number of searches on
+// the same map.
+typedef struct GridSearch GridSearch;
+
+GridSearch* grid_search_create(const GridMap* map);
+void grid_search_free(GridSearch* search);
+
+// Starts a new search. options is copied, but options->overlay is only
+// referenced and must stay valid until the search is done.
+SearchStatus grid_search_begin(GridSearch* search, Point from, Point to, const SearchOptions* options);
+
+/**
+ * @brief Expands nodes until the search ends or a budget runs out.
+ * @param max_expansions Node budget, 0 for none.
+ * @param max_ms Time budget in milliseconds, 0 for none. The clock is read
+ * every few dozen expansions, so it may be overrun by a few microseconds.
+ */
+SearchStatus grid_search_step(GridSearch* search, int max_expansions, double max_ms);
+
+SearchStatus grid_search_status(const GridSearch* search);
+SearchStats grid_search_stats(const GridSearch* search);
+// Whether the last search may have expanded the cell, i.e. looked at its
+// neighbours. Exact but for cells whose key ties the target's, which count.
+bool grid_search_expanded(const GridSearch* search, int x, int y);
+// Writes the path once the status is SEARCH_FOUND.
+bool grid_search_path(const GridSearch* search, PathBuffer* out);
+
+/**
+ * @brief Writes the path once the status is SEARCH_FOUND as straight runs
+ * (path_runs.h), without going through one Point per cell.
+ * @param first_cell,last_cell Cells of the path to include, 0 to cost; e.g.
+ * 1 and cost - 1 for the cells between from and to.
+ * @return Number of runs, or -1 if there is no path or capacity is too small.
+ */
+int grid_search_path_runs(const GridSearch* search, int first_cell, int last_cell, PathRun* runs, int capacity);
+
+/**
+ * @brief The visualizer's greedy K-loop on a GridMap: after each path is found
+ * its cells (all but from and to) are blocked for the following searches.
+ * @param options Heuristic and edge filter to use; its overlay field is ignored.
+ * @param overlay The query's own overlay (map sized), cleared on entry; holds
+ * the cells of the paths found on return.
+ * @param points Storage the paths are written to one after another.
+ * @param paths Receives up to k paths pointing into points.
+ * @return Number of paths found.
+ */
+int grid_disjoint_paths(GridSearch* search, Point from, Point to, int k, const SearchOptions* options,
+    BlockOverlay* overlay, Point* points, int capacity, PathBuffer* paths);
+
+// Manhattan distance, the usual heuristic for 4-connected grids (context is the GridMap)
+int grid_manhattan_heuristic(const void* context, int cell, int target);
+
+/**
+ * @brief Plain Dijkstra (unit cost per move) on a GridMap using a binary heap.
+ * This is the reference the preprocessing engines are checked and timed against.
+ * @return true if a path was written to out (out->cost is -1 otherwise).
+ */
+bool grid_dijkstra(const GridMap* map, Point from, Point to, PathBuffer* out, SearchStats* stats);
+
+#endif // GRID_SEARCH_H
@@ -0,0 +1,124 @@
+#include <SDL3/SDL.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "map_edit.h"
+#include "mem_track.h"
+
+void map_changes_init(MapChangeSet* changes) {
+    memset(changes, 0, sizeof(*changes));
+}
+
+void map_changes_free(MapChangeSet* changes) {
+    mem_free(changes->cells);
+    map_changes_init(changes);
+}
+
+static bool record_flip(MapChangeSet* changes, int cell) {
+    if (changes->count == changes->capacity) {
+        int capacity = changes->capacity ? changes->capacity * 2 : 64;
+        int* grown = mem_realloc(changes->cells, sizeof(int) * capacity);
+        if (!grown)
+            return false;
+        changes->cells = grown;
+        changes->capacity = capacity;
+    }
+    changes->cells[changes->count++] = cell;
+    return true;
+}
+
+static int compare_cells(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Turns the list of flips into the net change: a cell flipped an even number
+// of times is back to what it was
+static void finish_changes(const GridMap* map, MapChangeSet* changes) {
+    if (changes->count > 1)
+        qsort(changes->cells, changes->count, sizeof(int), compare_cells);
+    int kept = 0;
+    for (int i = 0; i < changes->count;) {
+        int j = i + 1;
+        while (j < changes->count && changes->cells[j] == changes->cells[i])
+            j++;
+        if ((j - i) & 1)
+            changes->cells[kept++] = changes->cells[i];
+        i = j;
+    }
+    changes->count = kept;
+
+    changes->added = changes->removed = 0;
+    changes->min_x = changes->min_y = INT_MAX;
+    changes->max_x = changes->max_y = -1;
+    for (int i = 0; i < kept; i++) {
+        int cell = changes->cells[i];
+        int x = cell % map->width, y = cell / map->width;
+        if (map->walls[cell])
+            changes->added++;
+        else
+            changes->removed++;
+        changes->min_x = SDL_min(changes->min_x, x);
+        changes->max_x = SDL_max(changes->max_x, x);
+        changes->min_y = SDL_min(changes->min_y, y);
+        changes->max_y = SDL_max(changes->max_y, y);
+    }
+}
+
+bool map_edits_apply(GridMap* map, const MapEdit* edits, int count, MapChangeSet* changes) {
+    changes->count = 0;
+    if (!map->walls)
+        return false; // Tiled views are read-only
+
+    bool ok = true;
+    for (int e = 0; ok && e < count; e++) {
+        const MapEdit* edit = &edits[e];
+        int x0 = SDL_max(edit->x, 0), y0 = SDL_max(edit->y, 0);
+        int x1 = SDL_min(edit->x + edit->width, map->width), y1 = SDL_min(edit->y + edit->height, map->height);
+        if (edit->op == MAP_EDIT_ASSIGN && !edit->mask)
+            continue;
+
+        for (int y = y0; ok && y < y1; y++) {
+            unsigned char* row = map->walls + (size_t)y * map->width;
+            const uint8_t* mask = edit->mask ? edit->mask + (size_t)(y - edit->y) * edit->width : NULL;
+            for (int x = x0; x < x1; x++) {
+                unsigned char wall = row[x] != 0;
+                bool masked = mask && !mask[x - edit->x];
+                unsigned char next;
+                switch (edit->op) {
+                case MAP_EDIT_SET: next = masked ? wall : 1; break;
+                case MAP_EDIT_CLEAR: next = masked ? wall : 0; break;
+                case MAP_EDIT_TOGGLE: next = masked ? wall : !wall; break;
+                default: next = !masked; break;
+                }
+                if (next == wall)
+                    continue;
+                // Recorded before the write, so a failed batch still lists every flip
+                if (!record_flip(changes, y * map->width + x)) {
+                    ok = false;
+                    break;
+                }
+                row[x] = next;
+            }
+        }
+    }
+    finish_changes(map, changes);
+    return ok;
+}
+
+bool map_edits_publish(MapStore* store, const GridMap* map, MapChangeSet* changes) {
+    MapSnapshot* draft = map_store_begin_edit(store);
+    if (!draft)
+        return false;
+    for (int i = 0; i < changes->count; i++) {
+        int cell = changes->cells[i];
+        if (!map_snapshot_set_wall(draft, cell % map->width, cell / map->width, map->walls[cell] != 0)) {
+            map_store_discard(store, draft);
+            return false;
+        }
+    }
+    changes->generation = map_snapshot_generation(draft);
+    map_store_publish(store, draft);
+    return true;
+}
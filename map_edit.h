@@ -0,0 +1,56 @@
+#ifndef MAP_EDIT_H
+#define MAP_EDIT_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+#include "map_snapshot.h"
+
+// Batched wall edits. An editor or importer describes what it wants as a list
+// of rectangle (optionally masked) edits; applying them yields a change set
+// listing exactly which cells flipped, which the structures built on the walls
+// (snapshots, components, preprocessed routes, render textures) consume to
+// update only what the batch touched.
+typedef enum {
+    MAP_EDIT_SET,    // Make the cells walls
+    MAP_EDIT_CLEAR,  // Make the cells walkable
+    MAP_EDIT_TOGGLE, // Flip the cells
+    MAP_EDIT_ASSIGN  // Wall where the mask is nonzero, walkable elsewhere (needs a mask)
+} MapEditOp;
+
+typedef struct {
+    MapEditOp op;
+    int x, y, width, height; // Clipped to the map
+    // Optional: width * height bytes, row by row. Only cells with a nonzero
+    // byte take part, except for MAP_EDIT_ASSIGN where every cell does.
+    const uint8_t* mask;
+} MapEdit;
+
+typedef struct {
+    uint64_t generation; // Of the published walls, see map_edits_publish()
+    int count;   // Cells whose wall flag is different after the batch
+    int added;   // Of those, cells that became walls
+    int removed; // and cells that became walkable
+    int min_x, min_y, max_x, max_y; // Bounds of the changed cells (when count > 0)
+    int* cells;  // The changed cells' indices, ascending
+    int capacity;
+} MapChangeSet;
+
+void map_changes_init(MapChangeSet* changes);
+void map_changes_free(MapChangeSet* changes);
+
+/**
+ * @brief Applies edits in order to a flat map and records the net change in
+ * changes (a cell toggled twice is not changed).
+ * @return false if memory ran out; the map is then partly edited and changes
+ * still lists every cell that differs.
+ */
+bool map_edits_apply(GridMap* map, const MapEdit* edits, int count, MapChangeSet* changes);
+
+/**
+ * @brief Publishes the changed cells of map as a new version of store,
+ * copying only the tiles they fall in, and records its generation in changes.
+ */
+bool map_edits_publish(MapStore* store, const GridMap* map, MapChangeSet* changes);
+
+#endif // MAP_EDIT_H
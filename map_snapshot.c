@@ -0,0 +1,285 @@
+#include <SDL3/SDL.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "map_snapshot.h"
+#include "mem_track.h"
+
+#define MAP_TILE_CELLS (MAP_TILE_SIZE * MAP_TILE_SIZE)
+
+typedef struct {
+    SDL_AtomicInt refcount; // Number of versions using this tile
+    unsigned char cells[MAP_TILE_CELLS];
+} MapTile;
+
+struct MapSnapshot {
+    SDL_AtomicInt refcount; // The store's reference while current/retired, plus one per reader
+    uint64_t generation;
+    int tiles_x, tiles_y;
+    MapTile** tiles;
+    const unsigned char** tile_cells; // tiles[i]->cells, what view.tiles points at
+    GridMap view;
+};
+
+// A replaced version, kept until every reader has moved past retire_epoch
+typedef struct RetiredSnapshot {
+    MapSnapshot* snapshot;
+    int retire_epoch;
+    struct RetiredSnapshot* next;
+} RetiredSnapshot;
+
+struct MapStore {
+    void* current; // MapSnapshot*, only accessed through SDL atomic pointer calls
+    SDL_AtomicInt epoch;
+    // Epoch a reader pinned while taking a reference, 0 when not pinned
+    SDL_AtomicInt reader_epoch[MAP_STORE_MAX_READERS];
+    SDL_AtomicInt reader_used[MAP_STORE_MAX_READERS];
+
+    SDL_Mutex* writer_lock;   // Serialises writers; readers never touch it
+    RetiredSnapshot* retired; // Guarded by writer_lock
+};
+
+static MapTile* tile_create(void) {
+    MapTile* tile = mem_alloc(sizeof(MapTile));
+    if (!tile)
+        return NULL;
+    SDL_SetAtomicInt(&tile->refcount, 1);
+    memset(tile->cells, 1, sizeof(tile->cells)); // Padding outside the map reads as wall
+    return tile;
+}
+
+static void tile_release(MapTile* tile) {
+    if (tile && SDL_AtomicDecRef(&tile->refcount))
+        mem_free(tile);
+}
+
+static MapSnapshot* snapshot_alloc(int width, int height) {
+    MapSnapshot* snapshot = mem_calloc(1, sizeof(MapSnapshot));
+    if (!snapshot)
+        return NULL;
+    snapshot->tiles_x = (width + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
+    snapshot->tiles_y = (height + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
+    int tile_count = snapshot->tiles_x * snapshot->tiles_y;
+    snapshot->tiles = mem_calloc(tile_count, sizeof(MapTile*));
+    snapshot->tile_cells = mem_calloc(tile_count, sizeof(unsigned char*));
+    if (!snapshot->tiles || !snapshot->tile_cells) {
+        mem_free(snapshot->tiles);
+        mem_free(snapshot->tile_cells);
+        mem_free(snapshot);
+        return NULL;
+    }
+    SDL_SetAtomicInt(&snapshot->refcount, 1);
+    snapshot->view.width = width;
+    snapshot->view.height = height;
+    snapshot->view.walls = NULL;
+    snapshot->view.tiles = snapshot->tile_cells;
+    snapshot->view.tiles_x = snapshot->tiles_x;
+    return snapshot;
+}
+
+static void snapshot_destroy(MapSnapshot* snapshot) {
+    int tile_count = snapshot->tiles_x * snapshot->tiles_y;
+    for (int i = 0; i < tile_count; i++)
+        tile_release(snapshot->tiles[i]);
+    mem_free(snapshot->tiles);
+    mem_free(snapshot->tile_cells);
+    mem_free(snapshot);
+}
+
+void map_snapshot_release(const MapSnapshot* snapshot) {
+    MapSnapshot* owned = (MapSnapshot*)snapshot;
+    if (owned && SDL_AtomicDecRef(&owned->refcount))
+        snapshot_destroy(owned);
+}
+
+const GridMap* map_snapshot_map(const MapSnapshot* snapshot) {
+    return &snapshot->view;
+}
+
+uint64_t map_snapshot_generation(const MapSnapshot* snapshot) {
+    return snapshot->generation;
+}
+
+MapStore* map_store_create(const GridMap* initial) {
+    MapStore* store = mem_calloc(1, sizeof(MapStore));
+    MapSnapshot* first = snapshot_alloc(initial->width, initial->height);
+    if (store)
+        store->writer_lock = SDL_CreateMutex();
+    if (!store || !first || !store->writer_lock) {
+        if (first)
+            snapshot_destroy(first);
+        if (store)
+            SDL_DestroyMutex(store->writer_lock);
+        mem_free(store);
+        return NULL;
+    }
+
+    for (int ty = 0; ty < first->tiles_y; ty++) {
+        for (int tx = 0; tx < first->tiles_x; tx++) {
+            MapTile* tile = tile_create();
+            if (!tile) {
+                snapshot_destroy(first);
+                SDL_DestroyMutex(store->writer_lock);
+                mem_free(store);
+                return NULL;
+            }
+            for (int y = 0; y < MAP_TILE_SIZE; y++) {
+                for (int x = 0; x < MAP_TILE_SIZE; x++) {
+                    int mx = tx * MAP_TILE_SIZE + x;
+                    int my = ty * MAP_TILE_SIZE + y;
+                    if (mx < initial->width && my < initial->height)
+                        tile->cells[y * MAP_TILE_SIZE + x] = gridmap_wall_xy(initial, mx, my);
+                }
+            }
+            first->tiles[ty * first->tiles_x + tx] = tile;
+            first->tile_cells[ty * first->tiles_x + tx] = tile->cells;
+        }
+    }
+
+    SDL_SetAtomicInt(&store->epoch, 1);
+    SDL_SetAtomicPointer(&store->current, first);
+    return store;
+}
+
+void map_store_destroy(MapStore* store) {
+    if (!store)
+        return;
+    while (store->retired) {
+        RetiredSnapshot* r = store->retired;
+        store->retired = r->next;
+        map_snapshot_release(r->snapshot);
+        mem_free(r);
+    }
+    map_snapshot_release(SDL_GetAtomicPointer(&store->current));
+    SDL_DestroyMutex(store->writer_lock);
+    mem_free(store);
+}
+
+int map_store_register_reader(MapStore* store) {
+    for (int i = 0; i < MAP_STORE_MAX_READERS; i++) {
+        if (SDL_CompareAndSwapAtomicInt(&store->reader_used[i], 0, 1)) {
+            SDL_SetAtomicInt(&store->reader_epoch[i], 0);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void map_store_unregister_reader(MapStore* store, int reader) {
+    if (reader < 0 || reader >= MAP_STORE_MAX_READERS)
+        return;
+    SDL_SetAtomicInt(&store->reader_epoch[reader], 0);
+    SDL_SetAtomicInt(&store->reader_used[reader], 0);
+}
+
+const MapSnapshot* map_store_acquire(MapStore* store, int reader) {
+    // Pin: announce the epoch before looking at the pointer. A version retired
+    // at this epoch or later is not freed until the pin is dropped.
+    SDL_SetAtomicInt(&store->reader_epoch[reader], SDL_GetAtomicInt(&store->epoch));
+    MapSnapshot* snapshot = SDL_GetAtomicPointer(&store->current);
+    SDL_AtomicIncRef(&snapshot->refcount);
+    SDL_SetAtomicInt(&store->reader_epoch[reader], 0);
+    return snapshot;
+}
+
+MapSnapshot* map_store_begin_edit(MapStore* store) {
+    SDL_LockMutex(store->writer_lock);
+
+    // Only writers replace current, and we hold the writer lock
+    MapSnapshot* current = SDL_GetAtomicPointer(&store->current);
+    MapSnapshot* draft = snapshot_alloc(current->view.width, current->view.height);
+    if (!draft) {
+        SDL_UnlockMutex(store->writer_lock);
+        return NULL;
+    }
+    draft->generation = current->generation + 1;
+
+    // Share every tile; set_wall copies a tile on its first write
+    int tile_count = current->tiles_x * current->tiles_y;
+    for (int i = 0; i < tile_count; i++) {
+        draft->tiles[i] = current->tiles[i];
+        draft->tile_cells[i] = current->tile_cells[i];
+        SDL_AtomicIncRef(&current->tiles[i]->refcount);
+    }
+    return draft;
+}
+
+bool map_snapshot_set_wall(MapSnapshot* draft, int x, int y, bool wall) {
+    if (x < 0 || x >= draft->view.width || y < 0 || y >= draft->view.height)
+        return false;
+
+    int t = (y >> MAP_TILE_SHIFT) * draft->tiles_x + (x >> MAP_TILE_SHIFT);
+    int c = ((y & (MAP_TILE_SIZE - 1)) << MAP_TILE_SHIFT) | (x & (MAP_TILE_SIZE - 1));
+    MapTile* tile = draft->tiles[t];
+    if ((tile->cells[c] != 0) == wall)
+        return true; // No change, keep sharing the tile
+
+    if (SDL_GetAtomicInt(&tile->refcount) > 1) {
+        MapTile* copy = tile_create();
+        if (!copy)
+            return false;
+        memcpy(copy->cells, tile->cells, sizeof(copy->cells));
+        tile_release(tile);
+        draft->tiles[t] = tile = copy;
+        draft->tile_cells[t] = copy->cells;
+    }
+    tile->cells[c] = wall ? 1 : 0;
+    return true;
+}
+
+void map_store_discard(MapStore* store, MapSnapshot* draft) {
+    snapshot_destroy(draft);
+    SDL_UnlockMutex(store->writer_lock);
+}
+
+static void collect_locked(MapStore* store) {
+    // Oldest epoch any reader is still pinned at
+    int oldest = INT_MAX;
+    for (int i = 0; i < MAP_STORE_MAX_READERS; i++) {
+        int e = SDL_GetAtomicInt(&store->reader_epoch[i]);
+        if (e != 0 && e < oldest)
+            oldest = e;
+    }
+
+    RetiredSnapshot** link = &store->retired;
+    while (*link) {
+        RetiredSnapshot* r = *link;
+        if (r->retire_epoch < oldest) {
+            // Nobody can still be about to take a reference: drop the store's
+            // own. Readers that already hold one keep the version alive.
+            *link = r->next;
+            map_snapshot_release(r->snapshot);
+            mem_free(r);
+        }
+        else {
+            link = &r->next;
+        }
+    }
+}
+
+void map_store_publish(MapStore* store, MapSnapshot* draft) {
+    MapSnapshot* old = SDL_SetAtomicPointer(&store->current, draft);
+
+    RetiredSnapshot* r = mem_alloc(sizeof(RetiredSnapshot));
+    if (r) {
+        r->snapshot = old;
+        r->retire_epoch = SDL_GetAtomicInt(&store->epoch);
+        r->next = store->retired;
+        store->retired = r;
+    }
+    else {
+        // Out of memory: the safe fallback is to leak this version
+        SDL_SetAtomicInt(&old->refcount, INT_MAX / 2);
+    }
+    SDL_AddAtomicInt(&store->epoch, 1);
+
+    collect_locked(store);
+    SDL_UnlockMutex(store->writer_lock);
+}
+
+void map_store_collect(MapStore* store) {
+    SDL_LockMutex(store->writer_lock);
+    collect_locked(store);
+    SDL_UnlockMutex(store->writer_lock);
+}
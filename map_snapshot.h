@@ -0,0 +1,50 @@
+#ifndef MAP_SNAPSHOT_H
+#define MAP_SNAPSHOT_H
+
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Versioned walls shared between the UI thread (which edits them) and query
+// threads (which only read them).
+//
+// Every published version is an immutable, reference-counted MapSnapshot made
+// of MAP_TILE_SIZE x MAP_TILE_SIZE tiles. An edit copies only the tiles it
+// touches; the rest are shared with the previous version. Publishing swaps an
+// atomic pointer. Readers never lock: they pin an epoch just long enough to
+// take a reference, and the writer frees a replaced version only once no
+// reader can still be about to take a reference to it.
+typedef struct MapStore MapStore;
+typedef struct MapSnapshot MapSnapshot;
+
+#define MAP_STORE_MAX_READERS 64
+
+MapStore* map_store_create(const GridMap* initial);
+// All readers must have released their snapshots.
+void map_store_destroy(MapStore* store);
+
+// Each reading thread claims a slot once. Returns -1 if all slots are taken.
+int map_store_register_reader(MapStore* store);
+void map_store_unregister_reader(MapStore* store, int reader);
+
+// Current version with a reference held; give it back with map_snapshot_release().
+const MapSnapshot* map_store_acquire(MapStore* store, int reader);
+void map_snapshot_release(const MapSnapshot* snapshot);
+
+// Read-only GridMap view of the snapshot, usable with every GridMap engine.
+const GridMap* map_snapshot_map(const MapSnapshot* snapshot);
+uint64_t map_snapshot_generation(const MapSnapshot* snapshot);
+
+// --- Writer side (one writer at a time; other writers wait, readers never do) ---
+
+// Starts a new version from the current one. Must be followed by publish or discard.
+MapSnapshot* map_store_begin_edit(MapStore* store);
+// Copies the cell's tile first if it is still shared with another version.
+bool map_snapshot_set_wall(MapSnapshot* draft, int x, int y, bool wall);
+void map_store_publish(MapStore* store, MapSnapshot* draft);
+void map_store_discard(MapStore* store, MapSnapshot* draft);
+
+// Frees replaced versions no reader can reach any more (also done on publish).
+void map_store_collect(MapStore* store);
+
+#endif // MAP_SNAPSHOT_H
@@ -0,0 +1,116 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_track.h"
+
+// Each block is preceded by its size, padded so the block keeps malloc's alignment
+#define MEM_HEADER 16
+
+static void* default_alloc(void* context, size_t size) {
+    (void)context;
+    return malloc(size);
+}
+
+static void* default_resize(void* context, void* block, size_t size) {
+    (void)context;
+    return realloc(block, size);
+}
+
+static void default_release(void* context, void* block) {
+    (void)context;
+    free(block);
+}
+
+static Allocator backend = { default_alloc, default_resize, default_release, NULL };
+static SDL_TLSID scope_slot;
+
+void mem_set_allocator(const Allocator* allocator) {
+    if (allocator)
+        backend = *allocator;
+    else
+        backend = (Allocator){ default_alloc, default_resize, default_release, NULL };
+}
+
+static void add_bytes(MemScope* scope, long long bytes) {
+    scope->current_bytes += bytes;
+    if (scope->current_bytes > scope->peak_bytes)
+        scope->peak_bytes = scope->current_bytes;
+}
+
+void* mem_alloc(size_t size) {
+    if (size > SIZE_MAX - MEM_HEADER)
+        return NULL;
+    unsigned char* header = backend.alloc(backend.context, size + MEM_HEADER);
+    if (!header)
+        return NULL;
+    memcpy(header, &size, sizeof(size));
+    MemScope* scope = SDL_GetTLS(&scope_slot);
+    if (scope) {
+        scope->allocations++;
+        add_bytes(scope, (long long)size);
+    }
+    return header + MEM_HEADER;
+}
+
+void* mem_calloc(size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size)
+        return NULL;
+    void* block = mem_alloc(count * size);
+    if (block)
+        memset(block, 0, count * size);
+    return block;
+}
+
+void* mem_realloc(void* block, size_t size) {
+    if (!block)
+        return mem_alloc(size);
+    if (size > SIZE_MAX - MEM_HEADER)
+        return NULL;
+    unsigned char* header = (unsigned char*)block - MEM_HEADER;
+    size_t old_size;
+    memcpy(&old_size, header, sizeof(old_size));
+    header = backend.resize(backend.context, header, size + MEM_HEADER);
+    if (!header)
+        return NULL;
+    memcpy(header, &size, sizeof(size));
+    MemScope* scope = SDL_GetTLS(&scope_slot);
+    if (scope) {
+        scope->resizes++;
+        add_bytes(scope, (long long)size - (long long)old_size);
+    }
+    return header + MEM_HEADER;
+}
+
+void mem_free(void* block) {
+    if (!block)
+        return;
+    unsigned char* header = (unsigned char*)block - MEM_HEADER;
+    size_t size;
+    memcpy(&size, header, sizeof(size));
+    MemScope* scope = SDL_GetTLS(&scope_slot);
+    if (scope) {
+        scope->frees++;
+        add_bytes(scope, -(long long)size);
+    }
+    backend.release(backend.context, header);
+}
+
+void mem_scope_begin(MemScope* scope) {
+    memset(scope, 0, sizeof(*scope));
+    scope->outer = SDL_GetTLS(&scope_slot);
+    SDL_SetTLS(&scope_slot, scope, NULL);
+}
+
+void mem_scope_end(MemScope* scope) {
+    MemScope* outer = scope->outer;
+    SDL_SetTLS(&scope_slot, outer, NULL);
+    if (!outer)
+        return;
+    if (outer->current_bytes + scope->peak_bytes > outer->peak_bytes)
+        outer->peak_bytes = outer->current_bytes + scope->peak_bytes;
+    outer->current_bytes += scope->current_bytes;
+    outer->allocations += scope->allocations;
+    outer->resizes += scope->resizes;
+    outer->frees += scope->frees;
+}
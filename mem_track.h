@@ -0,0 +1,46 @@
+#ifndef MEM_TRACK_H
+#define MEM_TRACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Heap allocations of the search library (maps, searches, heaps) and of the
+// visualizer's own queries. Every block goes through mem_alloc() and friends,
+// which hand it to a pluggable Allocator (malloc by default) and account its
+// size to the calling thread's innermost MemScope, so the cost of one query
+// can be measured while other threads search.
+typedef struct {
+    void* (*alloc)(void* context, size_t size);               // Like malloc
+    void* (*resize)(void* context, void* block, size_t size); // Like realloc
+    void (*release)(void* context, void* block);              // Like free
+    void* context;
+} Allocator;
+
+/**
+ * @brief Replaces the backend (NULL restores malloc). Blocks must be freed by
+ * the backend that made them, so call this before anything is allocated.
+ */
+void mem_set_allocator(const Allocator* allocator);
+
+void* mem_alloc(size_t size);
+void* mem_calloc(size_t count, size_t size);
+void* mem_realloc(void* block, size_t size);
+void mem_free(void* block);
+
+// Allocations made by one thread between mem_scope_begin() and mem_scope_end().
+// Byte counts are relative to the start, so freeing older blocks makes
+// current_bytes negative. Scopes nest: a finished inner scope is folded into
+// the one around it.
+typedef struct MemScope {
+    long long current_bytes;
+    long long peak_bytes;  // Highest current_bytes seen
+    uint64_t allocations;  // mem_alloc, mem_calloc and mem_realloc of NULL
+    uint64_t resizes;
+    uint64_t frees;
+    struct MemScope* outer;
+} MemScope;
+
+void mem_scope_begin(MemScope* scope);
+void mem_scope_end(MemScope* scope);
+
+#endif // MEM_TRACK_H
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+
+#include "min_heap.h"
+#include "mem_track.h"
+
+void heap_init(MinHeap* heap, int initial_capacity) {
+    if (initial_capacity < 16)
+        initial_capacity = 16;
+    heap->items = mem_alloc(sizeof(HeapItem) * initial_capacity);
+    heap->count = 0;
+    heap->capacity = heap->items ? initial_capacity : 0;
+}
+
+void heap_free(MinHeap* heap) {
+    mem_free(heap->items);
+    heap->items = NULL;
+    heap->count = heap->capacity = 0;
+}
+
+void heap_clear(MinHeap* heap) {
+    heap->count = 0;
+}
+
+// Room for one more item
+static bool heap_reserve(MinHeap* heap) {
+    if (heap->count < heap->capacity)
+        return true;
+    int new_capacity = heap->capacity ? heap->capacity * 2 : 16;
+    HeapItem* grown = mem_realloc(heap->items, sizeof(HeapItem) * new_capacity);
+    if (!grown)
+        return false;
+    heap->items = grown;
+    heap->capacity = new_capacity;
+    return true;
+}
+
+bool heap_push(MinHeap* heap, int key, int value) {
+    if (!heap_reserve(heap))
+        return false;
+
+    // Sift up
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->items[parent].key <= key)
+            break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = (HeapItem){ key, value };
+    return true;
+}
+
+HeapItem heap_pop(MinHeap* heap) {
+    HeapItem top = heap->items[0];
+    HeapItem last = heap->items[--heap->count];
+
+    // Sift down
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count && heap->items[child + 1].key < heap->items[child].key)
+            child++;
+        if (last.key <= heap->items[child].key)
+            break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0)
+        heap->items[i] = last;
+    return top;
+}
+
+bool heap_append(MinHeap* heap, int key, int value) {
+    if (!heap_reserve(heap))
+        return false;
+    heap->items[heap->count++] = (HeapItem){ key, value };
+    return true;
+}
+
+HeapItem heap_pop_scan(MinHeap* heap) {
+    int min_index = 0;
+    for (int i = 1; i < heap->count; i++) {
+        if (heap->items[i].key < heap->items[min_index].key)
+            min_index = i;
+    }
+    HeapItem top = heap->items[min_index];
+    heap->items[min_index] = heap->items[--heap->count];
+    return top;
+}
@@ -0,0 +1,38 @@
+#ifndef MIN_HEAP_H
+#define MIN_HEAP_H
+
+#include <stdbool.h>
+
+// One queue entry: the priority and the node/cell index it belongs to.
+typedef struct {
+    int key;
+    int value;
+} HeapItem;
+
+// Growable binary min-heap used by the search engines that work on maps of
+// any size. Entries are never decreased in place; callers push duplicates and
+// skip stale ones when they are popped (same approach as dijkstra_find_path).
+typedef struct {
+    HeapItem* items;
+    int count;
+    int capacity;
+} MinHeap;
+
+void heap_init(MinHeap* heap, int initial_capacity);
+void heap_free(MinHeap* heap);
+void heap_clear(MinHeap* heap);
+bool heap_push(MinHeap* heap, int key, int value);
+HeapItem heap_pop(MinHeap* heap);
+
+// The same storage used as the unordered node list of dijkstra_find_path:
+// heap_append() adds at the end and heap_pop_scan() takes the first entry with
+// the smallest key, moving the last entry into its place. Pops are linear in
+// the count, so this is only for small queues whose ties must be broken the way
+// that function breaks them. Don't mix it with heap_push()/heap_pop() on one heap.
+bool heap_append(MinHeap* heap, int key, int value);
+HeapItem heap_pop_scan(MinHeap* heap);
+
+static inline bool heap_empty(const MinHeap* heap) { return heap->count == 0; }
+static inline int heap_min_key(const MinHeap* heap) { return heap->items[0].key; }
+
+#endif // MIN_HEAP_H
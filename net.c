@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "net.h"
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#define net_last_error_would_block() (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define net_last_error_would_block() (errno == EAGAIN || errno == EWOULDBLOCK)
+#endif
+
+bool net_startup(void) {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void net_shutdown(void) {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void net_close(NetSocket socket) {
+    if (socket == NET_INVALID_SOCKET)
+        return;
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+bool net_set_nonblocking(NetSocket socket) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(socket, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static void net_set_nodelay(NetSocket socket) {
+    // Responses are small and latency matters more than packet count
+    int on = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+}
+
+// Fills addr for "tcp:PORT" / "tcp:HOST:PORT"; returns false for other schemes
+static bool net_tcp_address(const char* address, struct sockaddr_in* addr) {
+    if (strncmp(address, "tcp:", 4) != 0)
+        return false;
+    const char* host = "127.0.0.1";
+    char host_buffer[64];
+    const char* port = address + 4;
+    const char* colon = strrchr(port, ':');
+    if (colon) {
+        size_t length = (size_t)(colon - port);
+        if (length >= sizeof(host_buffer))
+            return false;
+        memcpy(host_buffer, port, length);
+        host_buffer[length] = '\0';
+        host = strcmp(host_buffer, "localhost") == 0 ? "127.0.0.1" : host_buffer;
+        port = colon + 1;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons((unsigned short)atoi(port));
+    return inet_pton(AF_INET, host, &addr->sin_addr) == 1;
+}
+
+#ifndef _WIN32
+static bool net_unix_address(const char* address, struct sockaddr_un* addr) {
+    if (strncmp(address, "unix:", 5) != 0 || strlen(address + 5) >= sizeof(addr->sun_path))
+        return false;
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, address + 5);
+    return true;
+}
+#endif
+
+NetSocket net_listen(const char* address) {
+    NetSocket listener = NET_INVALID_SOCKET;
+    struct sockaddr_in tcp;
+    if (net_tcp_address(address, &tcp)) {
+        // Clients can make the server open files by path, so never listen beyond this machine
+        if ((ntohl(tcp.sin_addr.s_addr) >> 24) != 127) {
+            fprintf(stderr, "Refusing to listen on %s: only loopback addresses are allowed\n", address);
+            return NET_INVALID_SOCKET;
+        }
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+        if (listener != NET_INVALID_SOCKET && bind(listener, (struct sockaddr*)&tcp, sizeof(tcp)) != 0) {
+            net_close(listener);
+            listener = NET_INVALID_SOCKET;
+        }
+    }
+#ifndef _WIN32
+    struct sockaddr_un local;
+    if (net_unix_address(address, &local)) {
+        unlink(local.sun_path); // Left over from a previous run
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener != NET_INVALID_SOCKET && bind(listener, (struct sockaddr*)&local, sizeof(local)) != 0) {
+            net_close(listener);
+            listener = NET_INVALID_SOCKET;
+        }
+    }
+#endif
+
+    if (listener == NET_INVALID_SOCKET || listen(listener, 64) != 0 || !net_set_nonblocking(listener)) {
+        fprintf(stderr, "Could not listen on %s\n", address);
+        net_close(listener);
+        return NET_INVALID_SOCKET;
+    }
+    return listener;
+}
+
+NetSocket net_connect(const char* address) {
+    NetSocket connection = NET_INVALID_SOCKET;
+    bool connected = false;
+    struct sockaddr_in tcp;
+    if (net_tcp_address(address, &tcp)) {
+        connection = socket(AF_INET, SOCK_STREAM, 0);
+        connected = connection != NET_INVALID_SOCKET && connect(connection, (struct sockaddr*)&tcp, sizeof(tcp)) == 0;
+        if (connected)
+            net_set_nodelay(connection);
+    }
+#ifndef _WIN32
+    struct sockaddr_un local;
+    if (net_unix_address(address, &local)) {
+        connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        connected = connection != NET_INVALID_SOCKET && connect(connection, (struct sockaddr*)&local, sizeof(local)) == 0;
+    }
+#endif
+
+    if (!connected) {
+        fprintf(stderr, "Could not connect to %s\n", address);
+        net_close(connection);
+        return NET_INVALID_SOCKET;
+    }
+    return connection;
+}
+
+NetSocket net_accept(NetSocket listener) {
+    NetSocket connection = accept(listener, NULL, NULL);
+    if (connection == NET_INVALID_SOCKET)
+        return NET_INVALID_SOCKET;
+    net_set_nodelay(connection); // Fails harmlessly on Unix sockets
+    return connection;
+}
+
+int net_recv(NetSocket socket, void* buffer, int size) {
+    int n = (int)recv(socket, buffer, size, 0);
+    if (n < 0)
+        return net_last_error_would_block() ? NET_WOULD_BLOCK : -1;
+    return n;
+}
+
+int net_send(NetSocket socket, const void* buffer, int size) {
+#ifdef MSG_NOSIGNAL
+    int n = (int)send(socket, buffer, size, MSG_NOSIGNAL); // A closed peer must not kill the server
+#else
+    int n = (int)send(socket, buffer, size, 0);
+#endif
+    if (n < 0)
+        return net_last_error_would_block() ? NET_WOULD_BLOCK : -1;
+    return n;
+}
+
+bool net_send_all(NetSocket socket, const void* buffer, size_t size) {
+    const char* bytes = buffer;
+    while (size > 0) {
+        int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+        int n = net_send(socket, bytes, chunk);
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool net_wake_pair(NetSocket pair[2]) {
+#ifdef _WIN32
+    // No socketpair() on Windows: connect two loopback TCP sockets
+    NetSocket listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    int length = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    pair[0] = pair[1] = NET_INVALID_SOCKET;
+    if (listener != NET_INVALID_SOCKET && bind(listener, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+        getsockname(listener, (struct sockaddr*)&addr, &length) == 0 && listen(listener, 1) == 0) {
+        pair[1] = socket(AF_INET, SOCK_STREAM, 0);
+        if (pair[1] != NET_INVALID_SOCKET && connect(pair[1], (struct sockaddr*)&addr, sizeof(addr)) == 0)
+            pair[0] = accept(listener, NULL, NULL);
+    }
+    net_close(listener);
+    if (pair[0] == NET_INVALID_SOCKET) {
+        net_close(pair[1]);
+        return false;
+    }
+#else
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+        return false;
+#endif
+    net_set_nonblocking(pair[0]);
+    net_set_nonblocking(pair[1]);
+    return true;
+}
+
+int net_poll(NetPollFd* fds, int count, int timeout_ms) {
+#ifdef _WIN32
+    return WSAPoll(fds, (ULONG)count, timeout_ms);
+#else
+    return poll(fds, (nfds_t)count, timeout_ms);
+#endif
+}
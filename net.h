@@ -0,0 +1,71 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Minimal socket layer for the query server and its client: Winsock on
+// Windows, BSD sockets elsewhere. Readiness is polled with poll()/WSAPoll(),
+// which both platforms have (epoll/IOCP would need one backend each).
+//
+// Addresses are "tcp:PORT" (localhost), "tcp:HOST:PORT" or "unix:PATH"
+// (POSIX only). net_listen() refuses hosts outside the loopback range
+// 127.0.0.0/8; any host is fine for net_connect().
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET NetSocket;
+typedef WSAPOLLFD NetPollFd;
+#define NET_INVALID_SOCKET INVALID_SOCKET
+#else
+#include <poll.h>
+typedef int NetSocket;
+typedef struct pollfd NetPollFd;
+#define NET_INVALID_SOCKET (-1)
+#endif
+
+// net_recv()/net_send() result when a non-blocking socket has nothing to do
+#define NET_WOULD_BLOCK (-2)
+
+bool net_startup(void);
+void net_shutdown(void);
+
+NetSocket net_listen(const char* address);
+NetSocket net_connect(const char* address);
+// Non-blocking accept; NET_INVALID_SOCKET when there is no pending connection.
+NetSocket net_accept(NetSocket listener);
+void net_close(NetSocket socket);
+bool net_set_nonblocking(NetSocket socket);
+
+// Bytes transferred, 0 when the peer closed (recv only), NET_WOULD_BLOCK or -1 on error.
+int net_recv(NetSocket socket, void* buffer, int size);
+int net_send(NetSocket socket, const void* buffer, int size);
+// For blocking sockets: loops until everything is sent.
+bool net_send_all(NetSocket socket, const void* buffer, size_t size);
+
+// Connected pair used to wake a thread blocked in net_poll() from another thread.
+bool net_wake_pair(NetSocket pair[2]);
+
+int net_poll(NetPollFd* fds, int count, int timeout_ms);
+
+// Little-endian field helpers for the binary protocols
+static inline void net_put_u32(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static inline unsigned int net_get_u32(const unsigned char* p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static inline void net_put_u16(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static inline unsigned int net_get_u16(const unsigned char* p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+#endif // NET_H
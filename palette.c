@@ -0,0 +1,155 @@
+#include <SDL3/SDL.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "palette.h"
+
+static const Palette palettes[] = {
+    {
+        "default",
+        {
+            { 200, 200, 200, 255 }, // CELL_EMPTY
+            { 50, 50, 50, 255 },    // CELL_WALL
+            { 0, 255, 0, 255 },     // CELL_START: Green
+            { 255, 0, 0, 255 },     // CELL_END: Red
+            // Colors are from the user-provided palette
+            // Shortest (Path 1) = Darkest Blue
+            // Longest (Path 5) = Lightest Blue
+            { 2, 136, 209, 255 },   // CELL_PATH_1: Darkest
+            { 41, 182, 246, 255 },  // CELL_PATH_2
+            { 129, 212, 250, 255 }, // CELL_PATH_3
+            { 179, 229, 252, 255 }, // CELL_PATH_4
+            { 224, 247, 250, 255 }, // CELL_PATH_5: Lightest
+        },
+        { 100, 100, 100, 255 },
+        { 255, 152, 0, 255 },  // Door: Orange
+        { 156, 39, 176, 255 }, // Agent: Purple
+        { 233, 30, 99, 255 },  // Preview: Pink
+    },
+    {
+        // Okabe-Ito orange and purple for start/end, viridis for the paths:
+        // they stay apart for red-green colour blindness
+        "colorblind",
+        {
+            { 200, 200, 200, 255 },
+            { 50, 50, 50, 255 },
+            { 230, 159, 0, 255 },
+            { 204, 121, 167, 255 },
+            { 68, 1, 84, 255 },
+            { 59, 82, 139, 255 },
+            { 33, 145, 140, 255 },
+            { 94, 201, 98, 255 },
+            { 253, 231, 37, 255 },
+        },
+        { 100, 100, 100, 255 },
+        { 0, 114, 178, 255 },
+        { 213, 94, 0, 255 },
+        { 0, 158, 115, 255 },
+    },
+    {
+        // For print: paths from dark to light grey. Sorted by luminance, the
+        // cell types are at least 30 levels apart, so none can be mistaken
+        // for another.
+        "grayscale",
+        {
+            { 255, 255, 255, 255 },
+            { 135, 135, 135, 255 }, // Between paths 2 and 3
+            { 0, 0, 0, 255 },       // Start: darkest
+            { 40, 40, 40, 255 },    // End
+            { 75, 75, 75, 255 },
+            { 105, 105, 105, 255 },
+            { 165, 165, 165, 255 },
+            { 195, 195, 195, 255 },
+            { 225, 225, 225, 255 },
+        },
+        { 170, 170, 170, 255 },
+        { 80, 80, 80, 255 },
+        { 0, 0, 0, 255 },
+        { 0, 0, 0, 255 },
+    },
+};
+
+#define PALETTE_COUNT ((int)(sizeof(palettes) / sizeof(palettes[0])))
+
+static uint32_t lut[256];
+static int active_index = -1; // Table not built yet
+static unsigned int generation = 0;
+
+static uint32_t pack_color(SDL_Color color) {
+    uint8_t bytes[4] = { color.r, color.g, color.b, color.a };
+    uint32_t pixel;
+    memcpy(&pixel, bytes, 4);
+    return pixel;
+}
+
+int palette_count(void) {
+    return PALETTE_COUNT;
+}
+
+const Palette* palette_get(int index) {
+    return index >= 0 && index < PALETTE_COUNT ? &palettes[index] : NULL;
+}
+
+int palette_find(const char* name) {
+    for (int i = 0; i < PALETTE_COUNT; i++) {
+        if (SDL_strcasecmp(palettes[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+void palette_select(int index) {
+    if (index < 0 || index >= PALETTE_COUNT)
+        return;
+
+    // Bytes that are no valid CellType on either side draw as empty
+    const Palette* palette = &palettes[index];
+    for (int state = 0; state < 256; state++) {
+        CellType cell = (state & 15) < CELL_TYPE_COUNT ? (CellType)(state & 15) : CELL_EMPTY;
+        CellType path_type = (state >> 4) < CELL_TYPE_COUNT ? (CellType)(state >> 4) : CELL_EMPTY;
+        lut[state] = pack_color(palette->cells[visible_cell_type(cell, path_type)]);
+    }
+    active_index = index;
+    generation++;
+}
+
+static void ensure_table(void) {
+    if (active_index < 0)
+        palette_select(0);
+}
+
+const Palette* palette_active(void) {
+    ensure_table();
+    return &palettes[active_index];
+}
+
+int palette_active_index(void) {
+    ensure_table();
+    return active_index;
+}
+
+unsigned int palette_generation(void) {
+    ensure_table();
+    return generation;
+}
+
+const uint32_t* palette_table(void) {
+    ensure_table();
+    return lut;
+}
+
+void palette_map_row(const uint8_t* states, int count, uint32_t* out) {
+    ensure_table();
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(states + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_i32gather_epi32((const int*)lut, index, 4));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = lut[states[i]];
+}
@@ -0,0 +1,57 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <SDL3/SDL.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+#define CELL_TYPE_COUNT (CELL_PATH_5 + 1)
+
+// Colours of the visualizer. The active palette is expanded into a 256-entry
+// table indexed by a cell state byte (see cell_state()), so turning a row of
+// cells into pixels is one lookup per cell with no branches, and switching
+// palettes never touches the code that draws.
+typedef struct {
+    const char* name;
+    SDL_Color cells[CELL_TYPE_COUNT]; // Indexed by CellType
+    SDL_Color grid_line;
+    SDL_Color door;  // Timed doors, filled while closed and outlined while open
+    SDL_Color agent; // The agent walking a timed path
+    SDL_Color preview; // Path to the cell under the mouse, before it is clicked
+} Palette;
+
+// Both halves of a cell in one byte: the path plane (grid_path_type) in the
+// high nibble, the cell itself (grid) in the low one
+static inline uint8_t cell_state(CellType cell, CellType path_type) {
+    return (uint8_t)(path_type << 4 | cell);
+}
+
+// What a cell shows: a path segment wins over the cell itself
+static inline CellType visible_cell_type(CellType cell, CellType path_type) {
+    return path_type >= CELL_PATH_1 && path_type <= CELL_PATH_5 ? path_type : cell;
+}
+
+int palette_count(void);
+const Palette* palette_get(int index);
+// Index of the palette called name (case-insensitive), -1 if there is none
+int palette_find(const char* name);
+
+// Makes a palette the active one and rebuilds the lookup table (UI thread only)
+void palette_select(int index);
+const Palette* palette_active(void);
+int palette_active_index(void);
+// Changes on every palette_select(), so cached pixels can tell they are stale
+unsigned int palette_generation(void);
+
+// The active lookup table: the RGBA32 pixel (bytes r, g, b, a in memory) of
+// every cell state byte
+const uint32_t* palette_table(void);
+
+/**
+ * @brief Colours count cell states into out, one RGBA32 pixel each.
+ * Uses an AVX2 gather when the build targets it.
+ */
+void palette_map_row(const uint8_t* states, int count, uint32_t* out);
+
+#endif // PALETTE_H
@@ -0,0 +1,427 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "path_code.h"
+#include "grid_search.h"
+
+#define PATH_CODE_MAGIC "SPPC"
+#define PATH_CODE_VERSION 1u
+
+#define CODE_RUN_MAX 32       // Longest run in one 0DDLLLLL byte
+#define CODE_TRIPLE 0x80u     // 10AABBCC
+#define CODE_LONG_RUN 0xC0u   // 110000DD, then the length
+#define CODE_TAG_MASK 0xC0u
+
+// Direction index of the move from one point to the next, -1 if they are not neighbours
+static int move_direction(Point from, Point to) {
+    static const int directions[9] = { -1, 0, -1, 3, -1, 1, -1, 2, -1 };
+    unsigned int dx = (unsigned int)(to.x - from.x + 1);
+    unsigned int dy = (unsigned int)(to.y - from.y + 1);
+    return dx < 3 && dy < 3 ? directions[dy * 3 + dx] : -1;
+}
+
+static uint64_t code_hash(const PathCode* code) {
+    uint64_t hash = 14695981039346656037ull;
+    int32_t header[3] = { code->start.x, code->start.y, code->steps };
+    const uint8_t* bytes = (const uint8_t*)header;
+    for (size_t i = 0; i < sizeof(header); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    for (int i = 0; i < code->size; i++)
+        hash = (hash ^ code->bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+bool path_code_encode(const Point* points, int count, PathCode* code) {
+    code->start = points[0];
+    code->steps = count - 1;
+    code->size = 0;
+    code->hash = 0;
+    // Every byte covers at least one move, and a long run covers 33 with 6 bytes at most
+    code->bytes = malloc(code->steps > 0 ? code->steps : 1);
+    if (!code->bytes)
+        return false;
+
+    int i = 0; // Moves encoded so far
+    while (i < code->steps) {
+        int direction = move_direction(points[i], points[i + 1]);
+        if (direction < 0) {
+            path_code_free(code);
+            return false;
+        }
+        int run = 1;
+        while (i + run < code->steps && move_direction(points[i + run], points[i + run + 1]) == direction)
+            run++;
+
+        if (run < 3 && code->steps - i >= 3) {
+            // Staircase: pack the next three moves, whatever they are
+            uint8_t byte = CODE_TRIPLE;
+            for (int k = 0; k < 3; k++) {
+                int d = move_direction(points[i + k], points[i + k + 1]);
+                if (d < 0) {
+                    path_code_free(code);
+                    return false;
+                }
+                byte |= (uint8_t)(d << (4 - 2 * k));
+            }
+            code->bytes[code->size++] = byte;
+            i += 3;
+        }
+        else if (run <= CODE_RUN_MAX) {
+            code->bytes[code->size++] = (uint8_t)(direction << 5 | (run - 1));
+            i += run;
+        }
+        else {
+            code->bytes[code->size++] = (uint8_t)(CODE_LONG_RUN | direction);
+            for (unsigned int length = (unsigned int)run; ; length >>= 7) {
+                if (length < 0x80) {
+                    code->bytes[code->size++] = (uint8_t)length;
+                    break;
+                }
+                code->bytes[code->size++] = (uint8_t)(0x80 | (length & 0x7F));
+            }
+            i += run;
+        }
+    }
+
+    uint8_t* shrunk = realloc(code->bytes, code->size > 0 ? code->size : 1);
+    if (shrunk)
+        code->bytes = shrunk;
+    code->hash = code_hash(code);
+    return true;
+}
+
+void path_code_free(PathCode* code) {
+    free(code->bytes);
+    code->bytes = NULL;
+    code->size = 0;
+}
+
+void path_code_iter_init(PathCodeIter* it, const PathCode* code) {
+    it->code = code;
+    it->offset = 0;
+    it->at = code->start;
+    it->direction = 0;
+    it->run_left = 0;
+    it->triple = 0;
+    it->triple_left = 0;
+    it->started = false;
+}
+
+// Loads the next byte into run_left or triple; false when there is none
+static bool iter_fetch(PathCodeIter* it) {
+    const PathCode* code = it->code;
+    if (it->offset >= code->size)
+        return false;
+    uint8_t byte = code->bytes[it->offset++];
+    if ((byte & 0x80) == 0) {
+        it->direction = byte >> 5;
+        it->run_left = (byte & 0x1F) + 1;
+    }
+    else if ((byte & CODE_TAG_MASK) == CODE_TRIPLE) {
+        it->triple = (uint8_t)(byte << 2); // Next direction in the top two bits
+        it->triple_left = 3;
+    }
+    else {
+        it->direction = byte & 3;
+        unsigned int length = 0;
+        for (int shift = 0; it->offset < code->size && shift < 32; shift += 7) {
+            uint8_t part = code->bytes[it->offset++];
+            length |= (unsigned int)(part & 0x7F) << shift;
+            if (!(part & 0x80))
+                break;
+        }
+        it->run_left = (int)length;
+    }
+    return true;
+}
+
+bool path_code_iter_next(PathCodeIter* it, Point* point) {
+    if (!it->started) {
+        it->started = true;
+        *point = it->at;
+        return true;
+    }
+    while (it->run_left == 0 && it->triple_left == 0) {
+        if (!iter_fetch(it))
+            return false;
+    }
+
+    int direction;
+    if (it->triple_left > 0) {
+        direction = it->triple >> 6;
+        it->triple = (uint8_t)(it->triple << 2);
+        it->triple_left--;
+    }
+    else {
+        direction = it->direction;
+        it->run_left--;
+    }
+    it->at.x += grid_dx[direction];
+    it->at.y += grid_dy[direction];
+    *point = it->at;
+    return true;
+}
+
+int path_code_to_points(const PathCode* code, Point* points, int capacity) {
+    if (code->steps + 1 > capacity)
+        return -1;
+    PathCodeIter it;
+    path_code_iter_init(&it, code);
+    int count = 0;
+    while (count < capacity && path_code_iter_next(&it, &points[count]))
+        count++;
+    return count;
+}
+
+// Whether the bytes decode to exactly steps moves, all on the map
+static bool code_fits_map(const PathCode* code, const GridMap* map) {
+    PathCodeIter it;
+    path_code_iter_init(&it, code);
+    Point p;
+    int points = 0;
+    while (points <= code->steps + 1 && path_code_iter_next(&it, &p)) {
+        if (p.x < 0 || p.x >= map->width || p.y < 0 || p.y >= map->height)
+            return false;
+        points++;
+    }
+    return points == code->steps + 1;
+}
+
+bool path_codes_save(const char* path, const GridMap* map, const PathCode* codes, int count) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        fprintf(stderr, "Could not open %s for writing: %s\n", path, SDL_GetError());
+        return false;
+    }
+
+    uint32_t header[4] = { PATH_CODE_VERSION, (uint32_t)map->width, (uint32_t)map->height, (uint32_t)count };
+    uint64_t map_hash = gridmap_hash(map);
+    bool ok = SDL_WriteIO(io, PATH_CODE_MAGIC, 4) == 4 &&
+        SDL_WriteIO(io, header, sizeof(header)) == sizeof(header) &&
+        SDL_WriteIO(io, &map_hash, sizeof(map_hash)) == sizeof(map_hash);
+    for (int i = 0; ok && i < count; i++) {
+        int32_t fields[4] = { codes[i].start.x, codes[i].start.y, codes[i].steps, codes[i].size };
+        ok = SDL_WriteIO(io, fields, sizeof(fields)) == sizeof(fields) &&
+            SDL_WriteIO(io, codes[i].bytes, codes[i].size) == (size_t)codes[i].size;
+    }
+
+    SDL_CloseIO(io);
+    return ok;
+}
+
+PathCode* path_codes_load(const char* path, const GridMap* map, int* count) {
+    *count = 0;
+    SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+    if (!io)
+        return NULL;
+
+    char magic[4];
+    uint32_t header[4];
+    uint64_t map_hash;
+    PathCode* codes = NULL;
+    if (SDL_ReadIO(io, magic, 4) == 4 && memcmp(magic, PATH_CODE_MAGIC, 4) == 0 &&
+        SDL_ReadIO(io, header, sizeof(header)) == sizeof(header) &&
+        SDL_ReadIO(io, &map_hash, sizeof(map_hash)) == sizeof(map_hash) &&
+        header[0] == PATH_CODE_VERSION && (int)header[1] == map->width && (int)header[2] == map->height &&
+        map_hash == gridmap_hash(map)) {
+        codes = calloc(header[3] > 0 ? header[3] : 1, sizeof(PathCode));
+    }
+
+    int loaded = 0;
+    bool ok = codes != NULL;
+    for (uint32_t i = 0; ok && i < header[3]; i++) {
+        int32_t fields[4];
+        PathCode* code = &codes[loaded];
+        ok = SDL_ReadIO(io, fields, sizeof(fields)) == sizeof(fields) && fields[2] >= 0 &&
+            fields[3] >= 0 && fields[3] <= fields[2];
+        if (ok) {
+            code->start = (Point){ fields[0], fields[1] };
+            code->steps = fields[2];
+            code->size = fields[3];
+            code->bytes = malloc(code->size > 0 ? code->size : 1);
+            ok = code->bytes && SDL_ReadIO(io, code->bytes, code->size) == (size_t)code->size;
+            if (ok) {
+                code->hash = code_hash(code);
+                loaded++;
+                ok = code_fits_map(code, map);
+            }
+            else {
+                free(code->bytes);
+            }
+        }
+    }
+
+    if (codes && !ok) {
+        fprintf(stderr, "%s is corrupt, ignoring it.\n", path);
+        for (int i = 0; i < loaded; i++)
+            path_code_free(&codes[i]);
+        free(codes);
+        codes = NULL;
+        loaded = 0;
+    }
+    SDL_CloseIO(io);
+    *count = loaded;
+    return codes;
+}
+
+static uint64_t points_hash(const Point* points, int count) {
+    uint64_t hash = 14695981039346656037ull;
+    const uint8_t* bytes = (const uint8_t*)points;
+    for (size_t i = 0; i < sizeof(Point) * (size_t)count; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+int path_code_run_benchmark_tool(const char* map_path, int queries) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (queries <= 0)
+        queries = 200;
+
+    int cells = map->width * map->height;
+    int capacity = queries * K_PATHS;
+    GridSearch* search = grid_search_create(map);
+    Point* scratch = malloc(sizeof(Point) * cells);
+    BlockOverlay* overlay = block_overlay_create(map->width, map->height);
+    PathBuffer found_paths[K_PATHS];
+    Point** points = calloc(capacity, sizeof(Point*));
+    int* lengths = calloc(capacity, sizeof(int));
+    PathCode* codes = calloc(capacity, sizeof(PathCode));
+    if (!search || !scratch || !overlay || !points || !lengths || !codes) {
+        fprintf(stderr, "Out of memory.\n");
+        grid_search_free(search);
+        free(scratch);
+        block_overlay_free(overlay);
+        free(points);
+        free(lengths);
+        free(codes);
+        gridmap_free(map);
+        return 1;
+    }
+
+    // The visualizer's K-loop on random queries
+    SearchOptions options = { NULL, grid_manhattan_heuristic, map, NULL, NULL };
+    int count = 0;
+    srand(12345);
+    for (int attempt = 0; attempt < 100000 && count + K_PATHS <= capacity && attempt < queries * 50; attempt++) {
+        Point a = { rand() % map->width, rand() % map->height };
+        Point b = { rand() % map->width, rand() % map->height };
+        if (!gridmap_walkable(map, a.x, a.y) || !gridmap_walkable(map, b.x, b.y) || (a.x == b.x && a.y == b.y))
+            continue;
+        int found = grid_disjoint_paths(search, a, b, K_PATHS, &options, overlay, scratch, cells, found_paths);
+        for (int i = 0; i < found; i++) {
+            points[count] = malloc(sizeof(Point) * found_paths[i].length);
+            if (!points[count])
+                break;
+            memcpy(points[count], found_paths[i].points, sizeof(Point) * found_paths[i].length);
+            lengths[count++] = found_paths[i].length;
+        }
+        if (found > 0 && --queries == 0)
+            break;
+    }
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    long long point_bytes = 0, code_bytes = 0, moves = 0;
+    int errors = 0;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count; i++) {
+        if (!path_code_encode(points[i], lengths[i], &codes[i]))
+            errors++;
+    }
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count; i++) {
+        if (path_code_to_points(&codes[i], scratch, cells) != lengths[i])
+            errors++;
+    }
+    Uint64 t2 = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count; i++) {
+        path_code_to_points(&codes[i], scratch, cells);
+        if (memcmp(scratch, points[i], sizeof(Point) * lengths[i]) != 0)
+            errors++;
+        point_bytes += sizeof(Point) * (long long)lengths[i];
+        code_bytes += codes[i].size;
+        moves += lengths[i] - 1;
+    }
+
+    // Deduplication: hash every path, then compare each with a separate equal
+    // copy, the worst case for a comparison
+    Point** point_copies = calloc(count > 0 ? count : 1, sizeof(Point*));
+    PathCode* code_copies = calloc(count > 0 ? count : 1, sizeof(PathCode));
+    for (int i = 0; point_copies && code_copies && i < count; i++) {
+        point_copies[i] = malloc(sizeof(Point) * lengths[i]);
+        code_copies[i] = codes[i];
+        code_copies[i].bytes = malloc(codes[i].size > 0 ? codes[i].size : 1);
+        if (!point_copies[i] || !code_copies[i].bytes) {
+            errors++;
+            break;
+        }
+        memcpy(point_copies[i], points[i], sizeof(Point) * lengths[i]);
+        memcpy(code_copies[i].bytes, codes[i].bytes, codes[i].size);
+    }
+
+    uint64_t hash_sum = 0;
+    int equal_points = 0, equal_codes = 0;
+    Uint64 t3 = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count; i++)
+        hash_sum += points_hash(points[i], lengths[i]);
+    Uint64 t4 = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count; i++)
+        hash_sum += code_hash(&codes[i]);
+    Uint64 t5 = SDL_GetPerformanceCounter();
+    for (int i = 0; errors == 0 && i < count; i++)
+        equal_points += memcmp(point_copies[i], points[i], sizeof(Point) * lengths[i]) == 0;
+    Uint64 t6 = SDL_GetPerformanceCounter();
+    for (int i = 0; errors == 0 && i < count; i++)
+        equal_codes += path_code_equal(&code_copies[i], &codes[i]);
+    Uint64 t7 = SDL_GetPerformanceCounter();
+    for (int i = 0; point_copies && code_copies && i < count; i++) {
+        free(point_copies[i]);
+        free(code_copies[i].bytes);
+    }
+    free(point_copies);
+    free(code_copies);
+
+    char paths_file[1024];
+    SDL_snprintf(paths_file, sizeof(paths_file), "%s.paths", map_path);
+    int loaded_count = 0;
+    PathCode* loaded = NULL;
+    if (path_codes_save(paths_file, map, codes, count))
+        loaded = path_codes_load(paths_file, map, &loaded_count);
+    int reload_errors = loaded_count != count;
+    for (int i = 0; loaded && i < loaded_count && i < count; i++)
+        reload_errors += !path_code_equal(&loaded[i], &codes[i]);
+
+    double us = 1e6 / freq;
+    printf("Map %s: %dx%d, %d paths, %lld moves (%.1f per path)\n", map_path, map->width, map->height,
+        count, moves, count ? (double)moves / count : 0.0);
+    printf("  Memory:  %.1f KiB as Points, %.1f KiB as codes (%.1fx smaller, %.2f bytes per move)\n",
+        point_bytes / 1024.0, code_bytes / 1024.0, code_bytes ? (double)point_bytes / code_bytes : 0.0,
+        moves ? (double)code_bytes / moves : 0.0);
+    printf("  Encode:  %.2f ns per move\n", moves ? (double)(t1 - t0) * us * 1000.0 / moves : 0.0);
+    printf("  Decode:  %.2f ns per move\n", moves ? (double)(t2 - t1) * us * 1000.0 / moves : 0.0);
+    printf("  Hash:    %.0f us over Points, %.0f us over codes\n", (double)(t4 - t3) * us, (double)(t5 - t4) * us);
+    printf("  Compare: %.0f us over Points, %.0f us over codes (%d and %d of %d equal)\n",
+        (double)(t6 - t5) * us, (double)(t7 - t6) * us, equal_points, equal_codes, count);
+    printf("  Saved %s and read it back: %s\n", paths_file, reload_errors ? "MISMATCH" : "ok");
+    if (errors)
+        printf("  %d paths did not survive encoding (hash sum %llx)\n", errors, (unsigned long long)hash_sum);
+
+    for (int i = 0; loaded && i < loaded_count; i++)
+        path_code_free(&loaded[i]);
+    free(loaded);
+    for (int i = 0; i < count; i++) {
+        path_code_free(&codes[i]);
+        free(points[i]);
+    }
+    free(codes);
+    free(lengths);
+    free(points);
+    block_overlay_free(overlay);
+    free(scratch);
+    grid_search_free(search);
+    gridmap_free(map);
+    return errors || reload_errors ? 1 : 0;
+}
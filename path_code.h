@@ -0,0 +1,69 @@
+#ifndef PATH_CODE_H
+#define PATH_CODE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "grid_map.h"
+
+// Compact path: the start point plus the moves as a byte string, each byte
+// one of
+//   0DDLLLLL            a run of L + 1 (1 to 32) moves in direction D
+//   10AABBCC            three single moves A, B, C (for staircases)
+//   110000DD <varint>   a run of 33 or more moves, length as LEB128
+// where directions index grid_dx/grid_dy. A staircase costs a third of a byte
+// per move and a straight corridor far less, against 8 bytes per Point.
+// Encoding is canonical: equal paths give equal bytes, so comparing and
+// hashing work on the bytes.
+typedef struct {
+    Point start;
+    int steps; // Number of moves, i.e. the cost
+    int size;  // Bytes used
+    uint8_t* bytes;
+    uint64_t hash; // Over start, steps and bytes
+} PathCode;
+
+/**
+ * @brief Encodes count consecutive points (count >= 1).
+ * @return false if two points are not neighbours or memory ran out.
+ */
+bool path_code_encode(const Point* points, int count, PathCode* code);
+void path_code_free(PathCode* code);
+
+// Points of the path (steps + 1), or -1 if capacity is too small
+int path_code_to_points(const PathCode* code, Point* points, int capacity);
+
+static inline bool path_code_equal(const PathCode* a, const PathCode* b) {
+    return a->hash == b->hash && a->steps == b->steps && a->size == b->size &&
+        a->start.x == b->start.x && a->start.y == b->start.y && memcmp(a->bytes, b->bytes, a->size) == 0;
+}
+
+// Walks a path one point at a time without expanding it
+typedef struct {
+    const PathCode* code;
+    int offset;     // Next byte to decode
+    Point at;       // Last point returned
+    int direction;  // Of the moves still pending
+    int run_left;   // Moves left in the current run
+    uint8_t triple; // Directions of a packed byte, next one in the top bits
+    int triple_left;
+    bool started;
+} PathCodeIter;
+
+void path_code_iter_init(PathCodeIter* it, const PathCode* code);
+// Yields the start first, then every point after a move; false at the end.
+bool path_code_iter_next(PathCodeIter* it, Point* point);
+
+/**
+ * @brief Saves paths found on map, with its size and hash so stale paths are
+ * detected on load, in the style of the map and preprocessing files.
+ */
+bool path_codes_save(const char* path, const GridMap* map, const PathCode* codes, int count);
+// Returns a malloc'ed array (free each with path_code_free), NULL if missing, stale or corrupt
+PathCode* path_codes_load(const char* path, const GridMap* map, int* count);
+
+// --bench-path-code tool: encodes K-path results on a map and reports
+// memory, encode/decode speed and duplicate detection against Point arrays.
+int path_code_run_benchmark_tool(const char* map_path, int queries);
+
+#endif // PATH_CODE_H
@@ -0,0 +1,67 @@
+#include <SDL3/SDL.h>
+
+#include "path_runs.h"
+
+// Runs are filled with SDL_memset4, which needs 4-byte cells
+SDL_COMPILE_TIME_ASSERT(cell_type_size, sizeof(CellType) == 4);
+
+// Direction index of the step from one point to the next, -1 if they are not neighbours
+static inline int step_direction(Point from, Point to) {
+    // Indexed by (dy + 1) * 3 + (dx + 1)
+    static const int directions[9] = { -1, 0, -1, 3, -1, 1, -1, 2, -1 };
+    unsigned int dx = (unsigned int)(to.x - from.x + 1);
+    unsigned int dy = (unsigned int)(to.y - from.y + 1);
+    return dx < 3 && dy < 3 ? directions[dy * 3 + dx] : -1;
+}
+
+int path_runs_from_points(const Point* points, int count, PathRun* runs, int capacity) {
+    // Runs are taken from the last point backwards, the way grid_search_path_runs
+    // walks parents, then flipped
+    int found = 0;
+    int i = count - 1;
+    while (i >= 0) {
+        if (found == capacity)
+            return -1;
+        PathRun* run = &runs[found++];
+        int first = i;
+        run->direction = 0;
+        if (i > 0) {
+            run->direction = step_direction(points[i - 1], points[i]);
+            if (run->direction < 0)
+                return -1;
+            // Extend back while the steps keep the same direction
+            int dx = grid_dx[run->direction], dy = grid_dy[run->direction];
+            first = i - 1;
+            while (first > 0 && points[first].x - points[first - 1].x == dx && points[first].y - points[first - 1].y == dy)
+                first--;
+        }
+        run->start = points[first];
+        run->length = i - first + 1;
+        i = first - 1;
+    }
+
+    for (int a = 0, b = found - 1; a < b; a++, b--) {
+        PathRun tmp = runs[a];
+        runs[a] = runs[b];
+        runs[b] = tmp;
+    }
+    return found;
+}
+
+void path_runs_stamp(const PathRun* runs, int count, CellType* plane, int width, CellType value) {
+    for (int r = 0; r < count; r++) {
+        const PathRun* run = &runs[r];
+        int dx = grid_dx[run->direction];
+        int dy = grid_dy[run->direction];
+        if (dy == 0) {
+            int first = dx < 0 ? run->start.x - (run->length - 1) : run->start.x;
+            SDL_memset4(plane + (size_t)run->start.y * width + first, (Uint32)value, run->length);
+        }
+        else {
+            CellType* cell = plane + (size_t)run->start.y * width + run->start.x;
+            ptrdiff_t stride = dy * (ptrdiff_t)width;
+            for (int i = 0; i < run->length; i++, cell += stride)
+                *cell = value;
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PATH_RUNS_H
+#define PATH_RUNS_H
+
+#include "grid_map.h"
+
+// A path as straight runs: from start, length cells one after another in
+// direction (an index into grid_dx/grid_dy). A run of length 1 is a single
+// cell; its direction is 0.
+typedef struct {
+    Point start;
+    int direction;
+    int length;
+} PathRun;
+
+/**
+ * @brief Splits consecutive points into maximal horizontal and vertical runs.
+ * Every point belongs to exactly one run; a path of n points needs at most n runs.
+ * Runs are split from the last point back, so a search's path gives the same
+ * runs as grid_search_path_runs.
+ * @return Number of runs written, or -1 if capacity is too small or two points
+ * are not neighbours.
+ */
+int path_runs_from_points(const Point* points, int count, PathRun* runs, int capacity);
+
+/**
+ * @brief Writes value into every cell of the runs in a plane of width cells
+ * per row (e.g. &grid_path_type[0][0]). Horizontal runs are one fill each.
+ */
+void path_runs_stamp(const PathRun* runs, int count, CellType* plane, int width, CellType value);
+
+// Rows a run covers
+static inline int path_run_first_row(const PathRun* run) {
+    return grid_dy[run->direction] < 0 ? run->start.y - (run->length - 1) : run->start.y;
+}
+
+static inline int path_run_last_row(const PathRun* run) {
+    return grid_dy[run->direction] > 0 ? run->start.y + (run->length - 1) : run->start.y;
+}
+
+#endif // PATH_RUNS_H
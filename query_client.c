@@ -0,0 +1,184 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "net.h"
+#include "query_protocol.h"
+#include "query_server.h"
+#include "grid_map.h"
+
+#define QC_LOAD_ID 0xFFFFFFFFu
+
+typedef struct {
+    NetSocket socket;
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+} FrameReader;
+
+// Blocks until one whole frame is buffered; returns its length (after the length field) or 0 on error.
+static unsigned int read_frame(FrameReader* reader) {
+    for (;;) {
+        if (reader->length >= 4) {
+            unsigned int length = net_get_u32(reader->data);
+            if (length < QP_HEADER_SIZE - 4 || length > QP_MAX_FRAME)
+                return 0;
+            if (reader->length >= 4 + (size_t)length)
+                return length;
+        }
+        if (reader->capacity - reader->length < 64 * 1024) {
+            size_t capacity = reader->capacity ? reader->capacity * 2 : 256 * 1024;
+            unsigned char* data = realloc(reader->data, capacity);
+            if (!data)
+                return 0;
+            reader->data = data;
+            reader->capacity = capacity;
+        }
+        int n = net_recv(reader->socket, reader->data + reader->length, (int)(reader->capacity - reader->length));
+        if (n <= 0)
+            return 0;
+        reader->length += n;
+    }
+}
+
+static void drop_frame(FrameReader* reader, unsigned int length) {
+    memmove(reader->data, reader->data + 4 + length, reader->length - 4 - length);
+    reader->length -= 4 + (size_t)length;
+}
+
+static int compare_ticks(const void* a, const void* b) {
+    Uint64 x = *(const Uint64*)a, y = *(const Uint64*)b;
+    return (x > y) - (x < y);
+}
+
+int query_client_run_tool(const char* address, const char* map_path, int requests, int pipeline, int k) {
+    if (requests <= 0)
+        requests = 10000;
+    pipeline = SDL_max(pipeline, 1);
+    k = SDL_clamp(k, 1, 64);
+
+    // The map is loaded here too, just to pick walkable endpoints
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    int cells = map->width * map->height;
+    int* walkable = malloc(sizeof(int) * cells);
+    int walkable_count = 0;
+    for (int i = 0; walkable && i < cells; i++) {
+        if (!gridmap_is_wall(map, i))
+            walkable[walkable_count++] = i;
+    }
+    Uint64* sent_at = malloc(sizeof(Uint64) * requests);
+    Uint64* latency = malloc(sizeof(Uint64) * requests);
+    if (!walkable || !walkable_count || !sent_at || !latency || !net_startup()) {
+        free(walkable);
+        free(sent_at);
+        free(latency);
+        gridmap_free(map);
+        return 1;
+    }
+
+    FrameReader reader = { net_connect(address), NULL, 0, 0 };
+    if (reader.socket == NET_INVALID_SOCKET) {
+        free(walkable);
+        free(sent_at);
+        free(latency);
+        gridmap_free(map);
+        return 1;
+    }
+
+    // Load the map on the server (the path is opened by the server process)
+    size_t path_length = strlen(map_path);
+    unsigned char header[QP_HEADER_SIZE];
+    net_put_u32(header, (unsigned int)(QP_HEADER_SIZE - 4 + path_length));
+    net_put_u32(header + 4, QC_LOAD_ID);
+    header[8] = QP_LOAD_MAP;
+    bool ok = net_send_all(reader.socket, header, sizeof(header)) && net_send_all(reader.socket, map_path, path_length);
+    unsigned int length = ok ? read_frame(&reader) : 0;
+    if (!length || reader.data[8] != QP_OK) {
+        fprintf(stderr, "The server could not load %s\n", map_path);
+        ok = false;
+    }
+    if (length)
+        drop_frame(&reader, length);
+
+    int request_size = QP_HEADER_SIZE + (k > 1 ? 10 : 8);
+    unsigned char* batch = malloc((size_t)request_size * pipeline);
+    int sent = 0, received = 0, no_path = 0, busy = 0, errors = 0;
+    long long path_points = 0;
+    srand(4242);
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    while (ok && batch && received < requests) {
+        // Top the pipeline up, in one send
+        int batch_count = 0;
+        Uint64 now = SDL_GetPerformanceCounter();
+        while (sent < requests && sent - received < pipeline) {
+            unsigned char* p = batch + (size_t)batch_count++ * request_size;
+            int a = walkable[rand() % walkable_count];
+            int b = walkable[rand() % walkable_count];
+            net_put_u32(p, (unsigned int)(request_size - 4));
+            net_put_u32(p + 4, (unsigned int)sent);
+            p[8] = k > 1 ? QP_K_PATHS : QP_QUERY;
+            net_put_u16(p + 9, (unsigned int)(a % map->width));
+            net_put_u16(p + 11, (unsigned int)(a / map->width));
+            net_put_u16(p + 13, (unsigned int)(b % map->width));
+            net_put_u16(p + 15, (unsigned int)(b / map->width));
+            if (k > 1)
+                net_put_u16(p + 17, (unsigned int)k);
+            sent_at[sent++] = now;
+        }
+        if (batch_count && !net_send_all(reader.socket, batch, (size_t)batch_count * request_size))
+            break;
+
+        length = read_frame(&reader);
+        if (!length)
+            break;
+        unsigned int id = net_get_u32(reader.data + 4);
+        if (id < (unsigned int)sent) {
+            latency[received++] = SDL_GetPerformanceCounter() - sent_at[id];
+            int status = reader.data[8];
+            if (status == QP_NO_PATH)
+                no_path++;
+            else if (status == QP_BUSY)
+                busy++;
+            else if (status != QP_OK)
+                errors++;
+            else if (k == 1)
+                path_points += net_get_u32(reader.data + QP_HEADER_SIZE + 4);
+        }
+        drop_frame(&reader, length);
+    }
+    Uint64 t1 = SDL_GetPerformanceCounter();
+
+    if (received > 0) {
+        double seconds = (double)(t1 - t0) / freq;
+        qsort(latency, received, sizeof(Uint64), compare_ticks);
+        printf("%s: %d %s requests on %dx%d, pipeline depth %d\n", address, received,
+            k > 1 ? "K-path" : "single-path", map->width, map->height, pipeline);
+        if (k > 1)
+            printf("  K:          %d\n", k);
+        printf("  Throughput: %.0f requests/s\n", received / seconds);
+        printf("  Latency:    p50 %.1f us, p99 %.1f us, max %.1f us\n",
+            latency[received / 2] * 1e6 / freq,
+            latency[SDL_min(received - 1, received * 99 / 100)] * 1e6 / freq,
+            latency[received - 1] * 1e6 / freq);
+        printf("  No path:    %d, busy: %d, errors: %d", no_path, busy, errors);
+        if (k == 1 && received > no_path + busy + errors)
+            printf(", average path %.1f points", (double)path_points / (received - no_path - busy - errors));
+        printf("\n");
+    }
+    if (received < requests)
+        fprintf(stderr, "Connection lost after %d of %d responses\n", received, requests);
+
+    net_close(reader.socket);
+    net_shutdown();
+    free(reader.data);
+    free(batch);
+    free(walkable);
+    free(sent_at);
+    free(latency);
+    gridmap_free(map);
+    return received == requests ? 0 : 1;
+}
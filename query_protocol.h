@@ -0,0 +1,39 @@
+#ifndef QUERY_PROTOCOL_H
+#define QUERY_PROTOCOL_H
+
+// Binary protocol of the query server (--serve). All integers little endian.
+//
+// Every message, in both directions, is a frame:
+//   u32 length     bytes after this field (header rest + payload)
+//   u32 request_id chosen by the client, echoed in the response
+//   u8  type       request type, or response status
+//   payload
+//
+// Clients may pipeline: send many requests without waiting. Queries are run
+// by a worker pool, so responses can arrive out of order; match them by id.
+// QP_LOAD_MAP is a barrier: it is handled once every earlier request of the
+// same connection is answered, and before any later one is read.
+
+#define QP_HEADER_SIZE 9
+#define QP_MAX_FRAME (1u << 24)
+
+enum {
+    // payload: map file path (no terminator). Response: u32 width, u32 height
+    QP_LOAD_MAP = 1,
+    // payload: u16 sx, sy, tx, ty. Response: one path
+    QP_QUERY = 2,
+    // payload: u16 sx, sy, tx, ty, u16 k. Response: u16 count, then count paths
+    QP_K_PATHS = 3,
+};
+// A path in a response: u32 cost, u32 length, then length * (u16 x, u16 y)
+
+enum {
+    QP_OK = 0,
+    QP_NO_PATH = 1,     // Response has no payload
+    QP_BAD_REQUEST = 2,
+    QP_NO_MAP = 3,      // No QP_LOAD_MAP yet, or it failed
+    QP_BUSY = 4,        // Too many queries queued; retry later
+    QP_SERVER_ERROR = 5, // The response did not fit in memory
+};
+
+#endif // QUERY_PROTOCOL_H
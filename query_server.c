@@ -0,0 +1,589 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "net.h"
+#include "query_protocol.h"
+#include "query_server.h"
+#include "grid_search.h"
+#include "map_snapshot.h"
+
+#define QS_MAX_CONNECTIONS 256
+#define QS_MAX_K 64
+#define QS_MAX_WORKERS MAP_STORE_MAX_READERS
+// Queries queued over all connections; more are answered with QP_BUSY
+#define QS_MAX_QUEUED 4096
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+typedef struct {
+    NetSocket socket;    // NET_INVALID_SOCKET when the slot is free
+    unsigned int serial; // Bumped when the slot is closed, so late responses are dropped
+    ByteBuffer in;       // I/O thread only
+    ByteBuffer out;      // Guarded by out_lock
+    size_t out_sent;
+    int in_flight;       // Queries queued or running, guarded by out_lock
+    bool failed;         // A response could not be queued; guarded by out_lock
+    bool load_pending;   // A QP_LOAD_MAP waits for in_flight to reach 0 (I/O thread only)
+} Connection;
+
+typedef struct Job {
+    int slot;
+    unsigned int serial;
+    unsigned int request_id;
+    int type;
+    Point from, to;
+    int k;
+    struct Job* next;
+} Job;
+
+typedef struct {
+    // Maps are only replaced by the I/O thread. A load of the same size is
+    // published into the current store; other sizes get a new store, and the
+    // old ones stay alive until exit because workers may still be reading them.
+    SDL_Mutex* map_lock;
+    MapStore** stores;
+    int store_count;
+
+    SDL_Mutex* queue_lock;
+    SDL_Condition* queue_ready;
+    Job* queue_head;
+    Job* queue_tail;
+    int queue_count;
+
+    SDL_Mutex* out_lock;
+    Connection connections[QS_MAX_CONNECTIONS];
+    NetSocket wake[2]; // Workers write a byte to wake[1] when they queued output
+} QueryServer;
+
+static bool buffer_reserve(ByteBuffer* buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity)
+        return true;
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra)
+        capacity *= 2;
+    unsigned char* data = realloc(buffer->data, capacity);
+    if (!data)
+        return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool buffer_append(ByteBuffer* buffer, const void* bytes, size_t size) {
+    if (size == 0)
+        return true;
+    if (!buffer_reserve(buffer, size))
+        return false;
+    memcpy(buffer->data + buffer->length, bytes, size);
+    buffer->length += size;
+    return true;
+}
+
+static void buffer_consume(ByteBuffer* buffer, size_t size) {
+    memmove(buffer->data, buffer->data + size, buffer->length - size);
+    buffer->length -= size;
+}
+
+// Starts a response frame at *start; finish_frame() fills in the length once
+// the payload is appended. False, with nothing appended, if out of memory.
+static bool begin_frame(ByteBuffer* buffer, unsigned int request_id, int status, size_t* start) {
+    *start = buffer->length;
+    unsigned char header[QP_HEADER_SIZE];
+    net_put_u32(header + 4, request_id);
+    header[8] = (unsigned char)status;
+    return buffer_append(buffer, header, sizeof(header));
+}
+
+static void finish_frame(ByteBuffer* buffer, size_t start) {
+    net_put_u32(buffer->data + start, (unsigned int)(buffer->length - start - 4));
+}
+
+static bool append_path(ByteBuffer* buffer, const PathBuffer* path) {
+    if (!buffer_reserve(buffer, 8 + (size_t)path->length * 4))
+        return false;
+    unsigned char* p = buffer->data + buffer->length;
+    net_put_u32(p, (unsigned int)path->cost);
+    net_put_u32(p + 4, (unsigned int)path->length);
+    p += 8;
+    for (int i = 0; i < path->length; i++, p += 4) {
+        net_put_u16(p, (unsigned int)path->points[i].x);
+        net_put_u16(p + 2, (unsigned int)path->points[i].y);
+    }
+    buffer->length += 8 + (size_t)path->length * 4;
+    return true;
+}
+
+// A response without payload. Leaves the buffer as it was if out of memory.
+static bool status_frame(ByteBuffer* buffer, unsigned int request_id, int status) {
+    size_t frame;
+    if (!begin_frame(buffer, request_id, status, &frame))
+        return false;
+    finish_frame(buffer, frame);
+    return true;
+}
+
+// Called by workers: hands a finished response to the I/O thread
+static void deliver(QueryServer* server, int slot, unsigned int serial, const ByteBuffer* response) {
+    SDL_LockMutex(server->out_lock);
+    Connection* connection = &server->connections[slot];
+    if (connection->serial == serial && connection->socket != NET_INVALID_SOCKET) {
+        connection->in_flight--;
+        // An empty response could not be built: the client would wait for it forever
+        if (response->length == 0 || !buffer_append(&connection->out, response->data, response->length))
+            connection->failed = true;
+    }
+    SDL_UnlockMutex(server->out_lock);
+
+    char wake = 1;
+    net_send(server->wake[1], &wake, 1); // Already pending if the pipe is full
+}
+
+static Job* pop_job(QueryServer* server) {
+    SDL_LockMutex(server->queue_lock);
+    while (!server->queue_head)
+        SDL_WaitCondition(server->queue_ready, server->queue_lock);
+    Job* job = server->queue_head;
+    server->queue_head = job->next;
+    if (!server->queue_head)
+        server->queue_tail = NULL;
+    server->queue_count--;
+    SDL_UnlockMutex(server->queue_lock);
+    return job;
+}
+
+// False if the queue is full
+static bool push_job(QueryServer* server, Job* job) {
+    job->next = NULL;
+    SDL_LockMutex(server->queue_lock);
+    if (server->queue_count >= QS_MAX_QUEUED) {
+        SDL_UnlockMutex(server->queue_lock);
+        return false;
+    }
+    server->queue_count++;
+    if (server->queue_tail)
+        server->queue_tail->next = job;
+    else
+        server->queue_head = job;
+    server->queue_tail = job;
+    SDL_SignalCondition(server->queue_ready);
+    SDL_UnlockMutex(server->queue_lock);
+    return true;
+}
+
+// Per-worker state, reused across queries as long as the map does not change
+typedef struct {
+    MapStore* store;
+    int reader;
+    const MapSnapshot* snapshot;
+    GridSearch* search;
+    BlockOverlay* overlay;
+    Point* points;
+    int capacity;
+    PathBuffer paths[QS_MAX_K];
+    ByteBuffer response;
+} Worker;
+
+static void worker_release_map(Worker* worker) {
+    grid_search_free(worker->search);
+    map_snapshot_release(worker->snapshot);
+    block_overlay_free(worker->overlay);
+    free(worker->points);
+    worker->search = NULL;
+    worker->snapshot = NULL;
+    worker->overlay = NULL;
+    worker->points = NULL;
+}
+
+// Makes sure the worker searches the newest published map. Returns false if there is none.
+static bool worker_update_map(QueryServer* server, Worker* worker) {
+    SDL_LockMutex(server->map_lock);
+    MapStore* store = server->store_count ? server->stores[server->store_count - 1] : NULL;
+    SDL_UnlockMutex(server->map_lock);
+    if (!store)
+        return false;
+
+    if (store != worker->store) {
+        worker_release_map(worker);
+        if (worker->store)
+            map_store_unregister_reader(worker->store, worker->reader);
+        worker->store = store;
+        worker->reader = map_store_register_reader(store);
+    }
+
+    const MapSnapshot* snapshot = map_store_acquire(store, worker->reader);
+    if (snapshot == worker->snapshot) {
+        map_snapshot_release(snapshot); // Still holding a reference from an earlier query
+        return worker->search != NULL;
+    }
+
+    worker_release_map(worker);
+    worker->snapshot = snapshot;
+    const GridMap* map = map_snapshot_map(snapshot);
+    int cells = map->width * map->height;
+    worker->capacity = cells + 2 * QS_MAX_K;
+    worker->search = grid_search_create(map);
+    worker->overlay = block_overlay_create(map->width, map->height);
+    worker->points = malloc(sizeof(Point) * worker->capacity);
+    if (!worker->search || !worker->overlay || !worker->points) {
+        worker_release_map(worker);
+        return false;
+    }
+    return true;
+}
+
+static void run_job(QueryServer* server, Worker* worker, const Job* job) {
+    ByteBuffer* response = &worker->response;
+    response->length = 0;
+
+    if (!worker_update_map(server, worker)) {
+        status_frame(response, job->request_id, QP_NO_MAP);
+        return;
+    }
+
+    const GridMap* map = map_snapshot_map(worker->snapshot);
+    SearchOptions options = { NULL, grid_manhattan_heuristic, map, NULL, NULL };
+    int k = job->type == QP_QUERY ? 1 : job->k;
+    int found = grid_disjoint_paths(worker->search, job->from, job->to, k, &options,
+        worker->overlay, worker->points, worker->capacity, worker->paths);
+
+    size_t frame;
+    bool built = begin_frame(response, job->request_id, found ? QP_OK : QP_NO_PATH, &frame);
+    if (built && found && job->type == QP_K_PATHS) {
+        unsigned char count[2];
+        net_put_u16(count, (unsigned int)found);
+        built = buffer_append(response, count, sizeof(count));
+    }
+    for (int i = 0; built && i < found; i++)
+        built = append_path(response, &worker->paths[i]);
+    if (built) {
+        finish_frame(response, frame);
+        return;
+    }
+    // Out of memory part way: a short error frame instead of a truncated one.
+    // If even that does not fit, the response stays empty and deliver() has
+    // the connection closed.
+    response->length = 0;
+    status_frame(response, job->request_id, QP_SERVER_ERROR);
+}
+
+static int worker_main(void* data) {
+    QueryServer* server = data;
+    Worker worker;
+    memset(&worker, 0, sizeof(worker));
+    worker.reader = -1;
+
+    for (;;) {
+        Job* job = pop_job(server);
+        run_job(server, &worker, job);
+        deliver(server, job->slot, job->serial, &worker.response);
+        free(job);
+    }
+    return 0;
+}
+
+// --- I/O thread ---
+
+static void send_status(QueryServer* server, int slot, unsigned int request_id, int status,
+    const unsigned char* payload, size_t size) {
+    SDL_LockMutex(server->out_lock);
+    Connection* connection = &server->connections[slot];
+    ByteBuffer* out = &connection->out;
+    size_t frame;
+    if (begin_frame(out, request_id, status, &frame) && buffer_append(out, payload, size)) {
+        finish_frame(out, frame);
+    }
+    else {
+        out->length = frame; // Drop the partial frame and close the connection
+        connection->failed = true;
+    }
+    SDL_UnlockMutex(server->out_lock);
+}
+
+static int in_flight(QueryServer* server, int slot) {
+    SDL_LockMutex(server->out_lock);
+    int count = server->connections[slot].in_flight;
+    SDL_UnlockMutex(server->out_lock);
+    return count;
+}
+
+static void load_map(QueryServer* server, int slot, unsigned int request_id, const unsigned char* payload, size_t size) {
+    char path[1024];
+    if (size == 0 || size >= sizeof(path)) {
+        send_status(server, slot, request_id, QP_BAD_REQUEST, NULL, 0);
+        return;
+    }
+    memcpy(path, payload, size);
+    path[size] = '\0';
+
+    GridMap* map = gridmap_load(path);
+    if (!map || map->width > 65535 || map->height > 65535) {
+        gridmap_free(map);
+        send_status(server, slot, request_id, QP_NO_MAP, NULL, 0);
+        return;
+    }
+
+    MapStore* current = server->store_count ? server->stores[server->store_count - 1] : NULL;
+    const MapSnapshot* snapshot = NULL;
+    if (current) {
+        snapshot = map_store_acquire(current, 0);
+        const GridMap* old = map_snapshot_map(snapshot);
+        if (old->width != map->width || old->height != map->height)
+            current = NULL;
+    }
+
+    if (current) {
+        // Same size: publish as a new version, copying only the tiles that differ
+        MapSnapshot* draft = map_store_begin_edit(current);
+        if (draft) {
+            for (int y = 0; y < map->height; y++) {
+                for (int x = 0; x < map->width; x++)
+                    map_snapshot_set_wall(draft, x, y, gridmap_wall_xy(map, x, y));
+            }
+            map_store_publish(current, draft);
+        }
+    }
+    else {
+        MapStore* store = map_store_create(map);
+        MapStore** stores = realloc(server->stores, sizeof(MapStore*) * (server->store_count + 1));
+        if (store && stores) {
+            map_store_register_reader(store); // First slot of a new store: 0, used by the I/O thread above
+            server->stores = stores;
+            SDL_LockMutex(server->map_lock);
+            stores[server->store_count++] = store;
+            SDL_UnlockMutex(server->map_lock);
+        }
+        else {
+            map_store_destroy(store);
+            if (stores)
+                server->stores = stores;
+        }
+    }
+    map_snapshot_release(snapshot);
+
+    unsigned char size_payload[8];
+    net_put_u32(size_payload, (unsigned int)map->width);
+    net_put_u32(size_payload + 4, (unsigned int)map->height);
+    printf("Loaded %s (%dx%d)\n", path, map->width, map->height);
+    send_status(server, slot, request_id, QP_OK, size_payload, sizeof(size_payload));
+    gridmap_free(map);
+}
+
+static void handle_request(QueryServer* server, int slot, unsigned int request_id, int type,
+    const unsigned char* payload, size_t size) {
+    if (type == QP_LOAD_MAP) {
+        load_map(server, slot, request_id, payload, size); // The caller waited for in_flight == 0
+        return;
+    }
+
+    bool valid = (type == QP_QUERY && size == 8) || (type == QP_K_PATHS && size == 10);
+    Job* job = valid ? malloc(sizeof(Job)) : NULL;
+    if (!job) {
+        send_status(server, slot, request_id, QP_BAD_REQUEST, NULL, 0);
+        return;
+    }
+    job->slot = slot;
+    job->serial = server->connections[slot].serial;
+    job->request_id = request_id;
+    job->type = type;
+    job->from = (Point){ (int)net_get_u16(payload), (int)net_get_u16(payload + 2) };
+    job->to = (Point){ (int)net_get_u16(payload + 4), (int)net_get_u16(payload + 6) };
+    job->k = type == QP_K_PATHS ? SDL_clamp((int)net_get_u16(payload + 8), 1, QS_MAX_K) : 1;
+
+    // Counted before it is queued, so a worker's deliver() never sees it negative
+    SDL_LockMutex(server->out_lock);
+    server->connections[slot].in_flight++;
+    SDL_UnlockMutex(server->out_lock);
+    if (!push_job(server, job)) {
+        free(job);
+        SDL_LockMutex(server->out_lock);
+        server->connections[slot].in_flight--;
+        SDL_UnlockMutex(server->out_lock);
+        send_status(server, slot, request_id, QP_BUSY, NULL, 0);
+    }
+}
+
+static void close_connection(QueryServer* server, int slot) {
+    Connection* connection = &server->connections[slot];
+    SDL_LockMutex(server->out_lock);
+    net_close(connection->socket);
+    connection->socket = NET_INVALID_SOCKET;
+    connection->serial++;
+    connection->out.length = 0;
+    connection->out_sent = 0;
+    connection->in_flight = 0; // Late responses of the old serial are dropped uncounted
+    connection->failed = false;
+    SDL_UnlockMutex(server->out_lock);
+    connection->in.length = 0;
+    connection->load_pending = false;
+}
+
+// Dispatches the complete frames received so far. A QP_LOAD_MAP waits in the
+// buffer, with everything after it, until the connection's earlier queries
+// are answered: they must not run on the new map. Returns false on garbage.
+static bool dispatch_frames(QueryServer* server, int slot) {
+    Connection* connection = &server->connections[slot];
+    connection->load_pending = false;
+    size_t offset = 0;
+    while (connection->in.length - offset >= 4) {
+        unsigned char* frame = connection->in.data + offset;
+        unsigned int length = net_get_u32(frame);
+        if (length < QP_HEADER_SIZE - 4 || length > QP_MAX_FRAME)
+            return false; // Not speaking our protocol
+        if (connection->in.length - offset < 4 + (size_t)length)
+            break;
+        if (frame[8] == QP_LOAD_MAP && in_flight(server, slot) > 0) {
+            connection->load_pending = true;
+            break;
+        }
+        handle_request(server, slot, net_get_u32(frame + 4), frame[8], frame + QP_HEADER_SIZE, length - (QP_HEADER_SIZE - 4));
+        offset += 4 + (size_t)length;
+    }
+    buffer_consume(&connection->in, offset);
+    return true;
+}
+
+// Reads what is available and dispatches every complete frame. Returns false if the connection is gone.
+static bool read_connection(QueryServer* server, int slot) {
+    Connection* connection = &server->connections[slot];
+    for (;;) {
+        if (!buffer_reserve(&connection->in, 64 * 1024))
+            return false;
+        int n = net_recv(connection->socket, connection->in.data + connection->in.length,
+            (int)(connection->in.capacity - connection->in.length));
+        if (n == NET_WOULD_BLOCK)
+            break;
+        if (n <= 0)
+            return false;
+        connection->in.length += n;
+    }
+    return dispatch_frames(server, slot);
+}
+
+// Sends queued responses. Returns false if the connection is gone.
+static bool flush_connection(QueryServer* server, int slot) {
+    Connection* connection = &server->connections[slot];
+    SDL_LockMutex(server->out_lock);
+    bool alive = !connection->failed;
+    while (connection->out_sent < connection->out.length) {
+        size_t pending = connection->out.length - connection->out_sent;
+        int n = net_send(connection->socket, connection->out.data + connection->out_sent,
+            pending > (1u << 30) ? (1 << 30) : (int)pending);
+        if (n == NET_WOULD_BLOCK)
+            break;
+        if (n <= 0) {
+            alive = false;
+            break;
+        }
+        connection->out_sent += n;
+    }
+    if (connection->out_sent == connection->out.length)
+        connection->out.length = connection->out_sent = 0;
+    SDL_UnlockMutex(server->out_lock);
+    return alive;
+}
+
+static bool has_output(QueryServer* server, int slot) {
+    SDL_LockMutex(server->out_lock);
+    bool pending = server->connections[slot].out.length > server->connections[slot].out_sent;
+    SDL_UnlockMutex(server->out_lock);
+    return pending;
+}
+
+int query_server_run_tool(const char* address, int worker_count) {
+    if (worker_count <= 0)
+        worker_count = SDL_GetNumLogicalCPUCores();
+    worker_count = SDL_clamp(worker_count, 1, QS_MAX_WORKERS - 1);
+
+    if (!net_startup())
+        return 1;
+    QueryServer* server = calloc(1, sizeof(QueryServer));
+    NetSocket listener = net_listen(address);
+    if (!server || listener == NET_INVALID_SOCKET || !net_wake_pair(server->wake)) {
+        net_close(listener);
+        free(server);
+        return 1;
+    }
+    server->map_lock = SDL_CreateMutex();
+    server->queue_lock = SDL_CreateMutex();
+    server->queue_ready = SDL_CreateCondition();
+    server->out_lock = SDL_CreateMutex();
+    for (int i = 0; i < QS_MAX_CONNECTIONS; i++)
+        server->connections[i].socket = NET_INVALID_SOCKET;
+
+    for (int i = 0; i < worker_count; i++) {
+        SDL_Thread* thread = SDL_CreateThread(worker_main, "query worker", server);
+        if (!thread) {
+            fprintf(stderr, "Could not start worker: %s\n", SDL_GetError());
+            return 1;
+        }
+        SDL_DetachThread(thread);
+    }
+    printf("Serving on %s with %d workers\n", address, worker_count);
+
+    NetPollFd fds[2 + QS_MAX_CONNECTIONS];
+    int fd_slot[2 + QS_MAX_CONNECTIONS];
+    for (;;) {
+        int count = 0;
+        fds[count].fd = listener;
+        fds[count++].events = POLLIN;
+        fds[count].fd = server->wake[0];
+        fds[count++].events = POLLIN;
+        for (int i = 0; i < QS_MAX_CONNECTIONS; i++) {
+            if (server->connections[i].socket == NET_INVALID_SOCKET)
+                continue;
+            fd_slot[count] = i;
+            fds[count].fd = server->connections[i].socket;
+            // A connection waiting to load a map is not read until it can: its buffer stays bounded
+            short read = server->connections[i].load_pending ? 0 : POLLIN;
+            fds[count++].events = read | (has_output(server, i) ? POLLOUT : 0);
+        }
+        for (int i = 0; i < count; i++)
+            fds[i].revents = 0;
+
+        if (net_poll(fds, count, -1) < 0)
+            continue;
+
+        if (fds[0].revents & POLLIN) {
+            NetSocket accepted;
+            while ((accepted = net_accept(listener)) != NET_INVALID_SOCKET) {
+                int slot = 0;
+                while (slot < QS_MAX_CONNECTIONS && server->connections[slot].socket != NET_INVALID_SOCKET)
+                    slot++;
+                if (slot == QS_MAX_CONNECTIONS || !net_set_nonblocking(accepted)) {
+                    net_close(accepted);
+                    continue;
+                }
+                server->connections[slot].socket = accepted;
+            }
+        }
+        if (fds[1].revents & POLLIN) {
+            char drain[256];
+            while (net_recv(server->wake[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        for (int i = 2; i < count; i++) {
+            int slot = fd_slot[i];
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !read_connection(server, slot))
+                close_connection(server, slot);
+        }
+        // Map loads whose connection's earlier queries have all been answered now
+        for (int slot = 0; slot < QS_MAX_CONNECTIONS; slot++) {
+            Connection* connection = &server->connections[slot];
+            if (connection->socket != NET_INVALID_SOCKET && connection->load_pending &&
+                in_flight(server, slot) == 0 && !dispatch_frames(server, slot))
+                close_connection(server, slot);
+        }
+
+        // Send whatever the workers finished, without waiting for another POLLOUT round
+        for (int slot = 0; slot < QS_MAX_CONNECTIONS; slot++) {
+            if (server->connections[slot].socket != NET_INVALID_SOCKET && !flush_connection(server, slot))
+                close_connection(server, slot);
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+// Serves route queries to other processes over localhost TCP or a Unix
+// socket (protocol in query_protocol.h). One I/O thread multiplexes all
+// connections with poll() and hands queries to a pool of worker threads,
+// each with its own search workspace. Workers read the map through a pinned
+// MapStore snapshot, so loading a new map never blocks running queries.
+
+// --serve <address> [workers]; runs until killed. workers <= 0 means one per core.
+int query_server_run_tool(const char* address, int worker_count);
+
+// --query-client <address> <map> [requests] [pipeline] [k]: load generator.
+// Keeps `pipeline` requests in flight and reports throughput and p50/p99 latency.
+int query_client_run_tool(const char* address, const char* map_path, int requests, int pipeline, int k);
+
+#endif // QUERY_SERVER_H
@@ -0,0 +1,545 @@
+#include <SDL3/SDL.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_SSE2 1
+#endif
+
+#include "raster.h"
+#include "palette.h"
+#include "grid_search.h"
+
+#define RASTER_DEFAULT_BAND_BYTES (16u << 20)
+#define RASTER_LINE_COLOR CELL_TYPE_COUNT // Index of the grid line pattern
+// Pixels in one fill pattern: 48 bytes, three SSE2 stores
+#define RASTER_PATTERN_PIXELS 16
+
+// A path cell, bucketed by row
+typedef struct {
+    int x;
+    unsigned char type;
+} RasterMark;
+
+struct Raster {
+    RasterScene scene;
+    int width, height; // Image size in pixels
+    int* row_first;    // map->height + 1 offsets into marks
+    RasterMark* marks;
+    // RASTER_PATTERN_PIXELS pixels of each colour, then of the grid lines
+    uint8_t patterns[CELL_TYPE_COUNT + 1][RASTER_PATTERN_PIXELS * 3];
+};
+
+static void make_pattern(uint8_t* pattern, SDL_Color color) {
+    for (int i = 0; i < RASTER_PATTERN_PIXELS; i++) {
+        pattern[i * 3] = color.r;
+        pattern[i * 3 + 1] = color.g;
+        pattern[i * 3 + 2] = color.b;
+    }
+}
+
+static CellType path_shade(int i) {
+    return i < K_PATHS ? (CellType)(CELL_PATH_1 + i) : CELL_PATH_5;
+}
+
+Raster* raster_create(const RasterScene* scene) {
+    const GridMap* map = scene->map;
+    if (!map || scene->cell_pixels < 1 || (long long)map->width * scene->cell_pixels * 3 > INT_MAX ||
+        (long long)map->height * scene->cell_pixels > INT_MAX)
+        return NULL;
+
+    Raster* raster = calloc(1, sizeof(Raster));
+    if (!raster)
+        return NULL;
+    raster->scene = *scene;
+    raster->width = map->width * scene->cell_pixels;
+    raster->height = map->height * scene->cell_pixels;
+    // Colours of the palette active now
+    const Palette* palette = palette_active();
+    for (int i = 0; i < CELL_TYPE_COUNT; i++)
+        make_pattern(raster->patterns[i], palette->cells[i]);
+    make_pattern(raster->patterns[RASTER_LINE_COLOR], palette->grid_line);
+
+    if (scene->path_cells || scene->path_count <= 0)
+        return raster;
+
+    // Counting sort of the path cells by row; paths stay in order, so a later
+    // path wins where two overlap, like record_path()
+    raster->row_first = calloc((size_t)map->height + 1, sizeof(int));
+    if (!raster->row_first) {
+        raster_free(raster);
+        return NULL;
+    }
+    int total = 0;
+    for (int i = 0; i < scene->path_count; i++) {
+        const PathBuffer* path = &scene->paths[i];
+        for (int j = 1; j < path->length - 1; j++) {
+            Point p = path->points[j];
+            if (p.x >= 0 && p.x < map->width && p.y >= 0 && p.y < map->height) {
+                raster->row_first[p.y + 1]++;
+                total++;
+            }
+        }
+    }
+    for (int y = 0; y < map->height; y++)
+        raster->row_first[y + 1] += raster->row_first[y];
+
+    raster->marks = malloc(sizeof(RasterMark) * (total > 0 ? total : 1));
+    int* fill = malloc(sizeof(int) * map->height);
+    if (!raster->marks || !fill) {
+        free(fill);
+        raster_free(raster);
+        return NULL;
+    }
+    memcpy(fill, raster->row_first, sizeof(int) * map->height);
+    for (int i = 0; i < scene->path_count; i++) {
+        const PathBuffer* path = &scene->paths[i];
+        for (int j = 1; j < path->length - 1; j++) {
+            Point p = path->points[j];
+            if (p.x >= 0 && p.x < map->width && p.y >= 0 && p.y < map->height)
+                raster->marks[fill[p.y]++] = (RasterMark){ p.x, (unsigned char)path_shade(i) };
+        }
+    }
+    free(fill);
+    return raster;
+}
+
+void raster_free(Raster* raster) {
+    if (!raster)
+        return;
+    free(raster->row_first);
+    free(raster->marks);
+    free(raster);
+}
+
+int raster_width(const Raster* raster) {
+    return raster->width;
+}
+
+int raster_height(const Raster* raster) {
+    return raster->height;
+}
+
+// What every cell of map row y shows, as a CellType
+static void row_states(const Raster* raster, int y, unsigned char* states) {
+    const RasterScene* scene = &raster->scene;
+    const GridMap* map = scene->map;
+    int width = map->width;
+
+    if (map->walls) {
+        const unsigned char* walls = map->walls + (size_t)y * width;
+        for (int x = 0; x < width; x++)
+            states[x] = walls[x] ? CELL_WALL : CELL_EMPTY;
+    }
+    else {
+        for (int x = 0; x < width; x++)
+            states[x] = gridmap_wall_xy(map, x, y) ? CELL_WALL : CELL_EMPTY;
+    }
+
+    if (scene->start.y == y && scene->start.x >= 0 && scene->start.x < width)
+        states[scene->start.x] = CELL_START;
+    if (scene->end.y == y && scene->end.x >= 0 && scene->end.x < width)
+        states[scene->end.x] = CELL_END;
+
+    if (scene->path_cells) {
+        const CellType* path_row = scene->path_cells + (size_t)y * width;
+        for (int x = 0; x < width; x++)
+            states[x] = (unsigned char)visible_cell_type((CellType)states[x], path_row[x]);
+    }
+    else if (raster->marks) {
+        for (int i = raster->row_first[y]; i < raster->row_first[y + 1]; i++)
+            states[raster->marks[i].x] = raster->marks[i].type;
+    }
+}
+
+// Writes count pixels of one colour
+static void fill_pattern(uint8_t* out, const uint8_t* pattern, int count) {
+#ifdef RASTER_SSE2
+    if (count >= RASTER_PATTERN_PIXELS) {
+        __m128i a = _mm_loadu_si128((const __m128i*)pattern);
+        __m128i b = _mm_loadu_si128((const __m128i*)(pattern + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(pattern + 32));
+        for (; count >= RASTER_PATTERN_PIXELS; count -= RASTER_PATTERN_PIXELS) {
+            _mm_storeu_si128((__m128i*)out, a);
+            _mm_storeu_si128((__m128i*)(out + 16), b);
+            _mm_storeu_si128((__m128i*)(out + 32), c);
+            out += RASTER_PATTERN_PIXELS * 3;
+        }
+    }
+#else
+    for (; count >= RASTER_PATTERN_PIXELS; count -= RASTER_PATTERN_PIXELS) {
+        memcpy(out, pattern, RASTER_PATTERN_PIXELS * 3);
+        out += RASTER_PATTERN_PIXELS * 3;
+    }
+#endif
+    memcpy(out, pattern, (size_t)count * 3);
+}
+
+// One image row through a whole row of cells, one run of equal cells at a time
+static void fill_cells(const Raster* raster, const unsigned char* states, uint8_t* out) {
+    int width = raster->scene.map->width;
+    int cell_pixels = raster->scene.cell_pixels;
+    if (cell_pixels == 1) {
+        // Runs of one pixel are too short to pay for finding them: a branch-free
+        // lookup per cell, 4-byte stores whose extra byte the next pixel overwrites
+        for (int x = 0; x < width - 1; x++)
+            memcpy(out + x * 3, raster->patterns[states[x]], 4);
+        memcpy(out + (width - 1) * 3, raster->patterns[states[width - 1]], 3);
+        return;
+    }
+
+    int x = 0;
+    while (x < width) {
+        unsigned char state = states[x];
+        int run = 1;
+        while (x + run < width && states[x + run] == state)
+            run++;
+
+        const uint8_t* pattern = raster->patterns[state];
+        uint8_t* at = out + (size_t)x * cell_pixels * 3;
+        int count = run * cell_pixels;
+        if (count >= RASTER_PATTERN_PIXELS || x + run == width) {
+            fill_pattern(at, pattern, count);
+        }
+        else {
+            // Short run with more pixels after it: 4-byte stores, each one's
+            // extra byte is overwritten by the next pixel
+            for (int i = 0; i < count; i++)
+                memcpy(at + i * 3, pattern, 4);
+        }
+        x += run;
+    }
+}
+
+void raster_render_rows(const Raster* raster, int first_row, int row_count, uint8_t* pixels, size_t pitch) {
+    const GridMap* map = raster->scene.map;
+    int cell_pixels = raster->scene.cell_pixels;
+    bool lines = raster->scene.grid_lines && cell_pixels >= 3;
+    size_t row_bytes = (size_t)raster->width * 3;
+    const uint8_t* line = raster->patterns[RASTER_LINE_COLOR];
+
+    unsigned char* states = malloc(map->width);
+    if (!states)
+        return;
+
+    for (int r = 0; r < row_count; r++) {
+        row_states(raster, first_row + r, states);
+        uint8_t* top = pixels + (size_t)r * cell_pixels * pitch;
+        if (!lines) {
+            fill_cells(raster, states, top);
+            for (int i = 1; i < cell_pixels; i++)
+                memcpy(top + i * pitch, top, row_bytes);
+            continue;
+        }
+
+        // Outlines on the first and last pixel of every cell, as SDL_RenderRect draws them
+        uint8_t* inner = top + pitch;
+        fill_cells(raster, states, inner);
+        for (int x = 0; x < map->width; x++) {
+            memcpy(inner + (size_t)x * cell_pixels * 3, line, 3);
+            memcpy(inner + ((size_t)(x + 1) * cell_pixels - 1) * 3, line, 3);
+        }
+        for (int i = 2; i < cell_pixels - 1; i++)
+            memcpy(top + i * pitch, inner, row_bytes);
+        fill_pattern(top, line, raster->width);
+        memcpy(top + (cell_pixels - 1) * pitch, top, row_bytes);
+    }
+    free(states);
+}
+
+RasterFormat raster_format_for(const char* path) {
+    size_t length = strlen(path);
+    return length >= 4 && SDL_strcasecmp(path + length - 4, ".png") == 0 ? RASTER_PNG : RASTER_PPM;
+}
+
+// --- PNG encoding: every IDAT holds stored deflate blocks, so only CRC-32 and Adler-32 are needed ---
+
+#define PNG_STORED_BLOCK 65535u
+#define ADLER_MOD 65521u
+#define ADLER_NMAX 5552 // Bytes before the sums must be reduced
+
+typedef struct {
+    SDL_IOStream* io;
+    bool ok;
+    uint32_t crc;
+    uint32_t adler_a, adler_b;
+    uint32_t crc_table[8][256]; // Slicing-by-8
+} PngWriter;
+
+static void png_init(PngWriter* png, SDL_IOStream* io) {
+    png->io = io;
+    png->ok = true;
+    png->adler_a = 1;
+    png->adler_b = 0;
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        png->crc_table[0][i] = c;
+    }
+    for (int t = 1; t < 8; t++) {
+        for (int i = 0; i < 256; i++)
+            png->crc_table[t][i] = (png->crc_table[t - 1][i] >> 8) ^ png->crc_table[0][png->crc_table[t - 1][i] & 0xFF];
+    }
+}
+
+static void png_crc(PngWriter* png, const uint8_t* data, size_t length) {
+    uint32_t (*table)[256] = png->crc_table;
+    uint32_t c = png->crc;
+    for (; length >= 8; length -= 8, data += 8) {
+        uint32_t lo = c ^ ((uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24);
+        c = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+            table[3][data[4]] ^ table[2][data[5]] ^ table[1][data[6]] ^ table[0][data[7]];
+    }
+    while (length--)
+        c = table[0][(c ^ *data++) & 0xFF] ^ (c >> 8);
+    png->crc = c;
+}
+
+static void png_adler(PngWriter* png, const uint8_t* data, size_t length) {
+    uint32_t a = png->adler_a, b = png->adler_b;
+    while (length > 0) {
+        size_t n = length < ADLER_NMAX ? length : ADLER_NMAX;
+        length -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_MOD;
+        b %= ADLER_MOD;
+    }
+    png->adler_a = a;
+    png->adler_b = b;
+}
+
+// Chunk payload bytes, which count towards the CRC
+static void png_put(PngWriter* png, const void* data, size_t length) {
+    png_crc(png, data, length);
+    png->ok = png->ok && SDL_WriteIO(png->io, data, length) == length;
+}
+
+static void png_put_u32(PngWriter* png, uint32_t value) {
+    uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+    png_put(png, bytes, 4);
+}
+
+static void png_begin_chunk(PngWriter* png, const char* type, uint32_t length) {
+    uint8_t bytes[4] = { (uint8_t)(length >> 24), (uint8_t)(length >> 16), (uint8_t)(length >> 8), (uint8_t)length };
+    png->ok = png->ok && SDL_WriteIO(png->io, bytes, 4) == 4; // The length is outside the CRC
+    png->crc = 0xFFFFFFFFu;
+    png_put(png, type, 4);
+}
+
+static void png_end_chunk(PngWriter* png) {
+    uint32_t crc = png->crc ^ 0xFFFFFFFFu;
+    uint8_t bytes[4] = { (uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc };
+    png->ok = png->ok && SDL_WriteIO(png->io, bytes, 4) == 4;
+}
+
+static void png_write_header(PngWriter* png, int width, int height) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png->ok = SDL_WriteIO(png->io, signature, 8) == 8;
+
+    png_begin_chunk(png, "IHDR", 13);
+    png_put_u32(png, (uint32_t)width);
+    png_put_u32(png, (uint32_t)height);
+    static const uint8_t format[5] = { 8, 2, 0, 0, 0 }; // 8-bit RGB, deflate, adaptive filters, no interlace
+    png_put(png, format, 5);
+    png_end_chunk(png);
+}
+
+// One IDAT of stored blocks holding data; the zlib header goes into the first one
+static void png_write_data(PngWriter* png, const uint8_t* data, size_t length, bool first) {
+    size_t blocks = (length + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+    png_begin_chunk(png, "IDAT", (uint32_t)(length + blocks * 5 + (first ? 2 : 0)));
+    if (first) {
+        static const uint8_t zlib_header[2] = { 0x78, 0x01 };
+        png_put(png, zlib_header, 2);
+    }
+    png_adler(png, data, length);
+    while (length > 0) {
+        uint16_t n = (uint16_t)(length < PNG_STORED_BLOCK ? length : PNG_STORED_BLOCK);
+        uint8_t block[5] = { 0, (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)~n, (uint8_t)(~n >> 8) };
+        png_put(png, block, 5);
+        png_put(png, data, n);
+        data += n;
+        length -= n;
+    }
+    png_end_chunk(png);
+}
+
+static void png_write_end(PngWriter* png) {
+    // An empty final block, then the Adler-32 of everything
+    static const uint8_t final_block[5] = { 1, 0, 0, 0xFF, 0xFF };
+    png_begin_chunk(png, "IDAT", 9);
+    png_put(png, final_block, 5);
+    png_put_u32(png, png->adler_b << 16 | png->adler_a);
+    png_end_chunk(png);
+
+    png_begin_chunk(png, "IEND", 0);
+    png_end_chunk(png);
+}
+
+bool raster_write(const Raster* raster, const char* path, RasterFormat format, size_t max_band_bytes, RasterStats* stats) {
+    if (!max_band_bytes)
+        max_band_bytes = RASTER_DEFAULT_BAND_BYTES;
+    const GridMap* map = raster->scene.map;
+    int cell_pixels = raster->scene.cell_pixels;
+
+    // PNG rows start with their filter byte (0, none), so pixels sit one byte in
+    size_t row_bytes = (size_t)raster->width * 3;
+    size_t pitch = format == RASTER_PNG ? row_bytes + 1 : row_bytes;
+    size_t cell_row_bytes = pitch * cell_pixels;
+    size_t band_rows = max_band_bytes / cell_row_bytes;
+    if (band_rows < 1)
+        band_rows = 1;
+    if (band_rows > (size_t)map->height)
+        band_rows = map->height;
+
+    RasterStats local = { 0 };
+    local.band_bytes = cell_row_bytes * band_rows;
+    uint8_t* band = malloc(local.band_bytes);
+    PngWriter* png = format == RASTER_PNG ? malloc(sizeof(PngWriter)) : NULL;
+    if (!band || (format == RASTER_PNG && !png)) {
+        fprintf(stderr, "Out of memory for a %zu byte image band.\n", local.band_bytes);
+        free(band);
+        free(png);
+        return false;
+    }
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        fprintf(stderr, "Could not open %s for writing: %s\n", path, SDL_GetError());
+        free(band);
+        free(png);
+        return false;
+    }
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 render_ticks = 0, write_ticks = 0;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    bool ok;
+    if (png) {
+        png_init(png, io);
+        png_write_header(png, raster->width, raster->height);
+        ok = png->ok;
+    }
+    else {
+        ok = SDL_IOprintf(io, "P6\n%d %d\n255\n", raster->width, raster->height) > 0;
+    }
+    write_ticks += SDL_GetPerformanceCounter() - t0;
+
+    for (int y = 0; ok && y < map->height; y += (int)band_rows) {
+        int rows = map->height - y < (int)band_rows ? map->height - y : (int)band_rows;
+        size_t bytes = cell_row_bytes * rows;
+
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        raster_render_rows(raster, y, rows, png ? band + 1 : band, pitch);
+        if (png) {
+            for (size_t i = 0; i < bytes; i += pitch)
+                band[i] = 0;
+        }
+        Uint64 t2 = SDL_GetPerformanceCounter();
+        if (png) {
+            png_write_data(png, band, bytes, y == 0);
+            ok = png->ok;
+        }
+        else {
+            ok = SDL_WriteIO(io, band, bytes) == bytes;
+        }
+        Uint64 t3 = SDL_GetPerformanceCounter();
+        render_ticks += t2 - t1;
+        write_ticks += t3 - t2;
+        local.bands++;
+    }
+
+    Uint64 t4 = SDL_GetPerformanceCounter();
+    if (ok && png) {
+        png_write_end(png);
+        ok = png->ok;
+    }
+    ok = SDL_CloseIO(io) && ok;
+    write_ticks += SDL_GetPerformanceCounter() - t4;
+    if (!ok)
+        fprintf(stderr, "Could not write %s.\n", path);
+
+    local.render_ms = (double)render_ticks * 1000.0 / freq;
+    local.write_ms = (double)write_ticks * 1000.0 / freq;
+    if (stats)
+        *stats = local;
+    free(band);
+    free(png);
+    return ok;
+}
+
+int raster_run_export_tool(const char* map_path, const char* image_path, int cell_pixels, int k) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (cell_pixels < 1)
+        cell_pixels = 1;
+    if (k < 0)
+        k = K_PATHS;
+
+    // Paths between the first and the last walkable cell in reading order
+    int cells = map->width * map->height;
+    int first = 0, last = cells - 1;
+    while (first < cells && gridmap_is_wall(map, first))
+        first++;
+    while (last > first && gridmap_is_wall(map, last))
+        last--;
+    RasterScene scene = { map, NULL, 0, NULL, { -1, -1 }, { -1, -1 }, cell_pixels, cell_pixels >= 8 };
+    if (first < last) {
+        scene.start = (Point){ first % map->width, first / map->width };
+        scene.end = (Point){ last % map->width, last / map->width };
+    }
+
+    PathBuffer* paths = NULL;
+    Point* points = NULL;
+    BlockOverlay* overlay = NULL;
+    GridSearch* search = NULL;
+    if (k > 0 && first < last) {
+        paths = malloc(sizeof(PathBuffer) * k);
+        points = malloc(sizeof(Point) * cells);
+        overlay = block_overlay_create(map->width, map->height);
+        search = grid_search_create(map);
+        if (!paths || !points || !overlay || !search) {
+            fprintf(stderr, "Not enough memory for paths on a %dx%d map; use k = 0.\n", map->width, map->height);
+            k = 0;
+        }
+        else {
+            SearchOptions options = { NULL, grid_manhattan_heuristic, map, NULL, NULL };
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            scene.path_count = grid_disjoint_paths(search, scene.start, scene.end, k, &options, overlay, points, cells, paths);
+            scene.paths = paths;
+            printf("Found %d of %d paths in %.1f ms\n", scene.path_count, k,
+                (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / SDL_GetPerformanceFrequency());
+        }
+    }
+
+    int status = 1;
+    Raster* raster = raster_create(&scene);
+    RasterStats stats;
+    if (!raster) {
+        fprintf(stderr, "Cannot render a %dx%d map at %d pixels per cell.\n", map->width, map->height, cell_pixels);
+    }
+    else if (raster_write(raster, image_path, raster_format_for(image_path), 0, &stats)) {
+        double megapixels = (double)raster_width(raster) * raster_height(raster) / 1e6;
+        printf("Exported %s: %dx%d pixels (%.1f Mpx) from a %dx%d map\n", image_path,
+            raster_width(raster), raster_height(raster), megapixels, map->width, map->height);
+        printf("  Bands:  %d of at most %.1f MiB\n", stats.bands, stats.band_bytes / (1024.0 * 1024.0));
+        printf("  Render: %.1f ms (%.0f Mpx/s)\n", stats.render_ms, stats.render_ms > 0.0 ? megapixels * 1000.0 / stats.render_ms : 0.0);
+        printf("  Write:  %.1f ms\n", stats.write_ms);
+        status = 0;
+    }
+
+    raster_free(raster);
+    grid_search_free(search);
+    block_overlay_free(overlay);
+    free(points);
+    free(paths);
+    gridmap_free(map);
+    return status;
+}
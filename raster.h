@@ -0,0 +1,70 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Headless rendering of a map and its paths into memory, in the colours of
+// draw_grid() (the active palette), for image export on machines without a display.
+// Pixels are packed RGB, 3 bytes each. The image is produced in bands of cell
+// rows so a 16k x 16k map never needs the whole picture in memory.
+typedef struct {
+    const GridMap* map;
+    // Optional: path i is drawn in the shade of CELL_PATH_1 + i (the lightest
+    // shade past K_PATHS); its first and last points are left to start/end.
+    const PathBuffer* paths;
+    int path_count;
+    // Optional: one CellType per cell, e.g. grid_path_type; used instead of paths
+    const CellType* path_cells;
+    Point start; // { -1, -1 } when not set
+    Point end;
+    int cell_pixels; // Side of a cell in pixels, at least 1
+    bool grid_lines; // Outline every cell like draw_grid (needs cell_pixels >= 3)
+} RasterScene;
+
+typedef enum {
+    RASTER_PPM, // Binary P6
+    RASTER_PNG  // 8-bit RGB, stored deflate blocks (no zlib needed)
+} RasterFormat;
+
+typedef struct {
+    double render_ms; // Time spent producing pixels
+    double write_ms;  // Time spent encoding and writing
+    int bands;
+    size_t band_bytes; // Size of the band buffer, the peak pixel memory
+} RasterStats;
+
+// A scene prepared for rendering: path points are bucketed by row once.
+typedef struct Raster Raster;
+
+// The scene is referenced, not copied, and must outlive the Raster.
+Raster* raster_create(const RasterScene* scene);
+void raster_free(Raster* raster);
+
+int raster_width(const Raster* raster);
+int raster_height(const Raster* raster);
+
+/**
+ * @brief Renders cell rows [first_row, first_row + row_count) into pixels.
+ * That is row_count * cell_pixels image rows of raster_width() RGB pixels,
+ * each starting pitch bytes after the previous one.
+ */
+void raster_render_rows(const Raster* raster, int first_row, int row_count, uint8_t* pixels, size_t pitch);
+
+/**
+ * @brief Renders the whole image band by band and writes it to path.
+ * @param max_band_bytes Upper bound for the band buffer, 0 for the default (16 MiB).
+ * A band is never smaller than one cell row.
+ */
+bool raster_write(const Raster* raster, const char* path, RasterFormat format, size_t max_band_bytes, RasterStats* stats);
+
+// RASTER_PNG for a ".png" file name, RASTER_PPM otherwise
+RasterFormat raster_format_for(const char* path);
+
+// --export-image tool: renders a map file with k disjoint paths between its
+// first and last walkable cells, and prints timings.
+int raster_run_export_tool(const char* map_path, const char* image_path, int cell_pixels, int k);
+
+#endif // RASTER_H
@@ -0,0 +1,668 @@
+#include <SDL3/SDL.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "search_tree.h"
+#include "min_heap.h"
+#include "mem_track.h"
+
+// Bits of SearchTree.flags
+#define TREE_SETTLED 1
+#define TREE_TOUCHED 2 // Listed in touched, so a reset can find it
+#define TREE_MARKED 4  // In the subtree being repaired
+
+// Expansions between two reads of the performance counter in search_tree_grow()
+#define TREE_CLOCK_INTERVAL 64
+
+struct SearchTree {
+    const GridMap* map;
+    const BlockOverlay* overlay;
+    int cells;
+    int* dist; // INT_MAX while unlabelled
+    int* parent;
+    unsigned char* flags;
+    int* touched; // Every cell labelled since the reset, once each
+    int touched_count;
+    int* scratch;  // Cells torn down by a repair
+    int* boundary; // Those of them next to a settled cell
+    MinHeap heap; // Lazy deletion: an entry is live while its key equals dist
+    bool scan_order; // heap is an unordered list, see search_tree_set_scan_order()
+    int source;   // -1 before the first reset
+    SearchStats stats;
+};
+
+SearchTree* search_tree_create(const GridMap* map) {
+    SearchTree* tree = mem_calloc(1, sizeof(SearchTree));
+    if (!tree)
+        return NULL;
+    tree->map = map;
+    tree->cells = map->width * map->height;
+    tree->dist = mem_alloc(sizeof(int) * tree->cells);
+    tree->parent = mem_alloc(sizeof(int) * tree->cells);
+    tree->flags = mem_calloc(tree->cells, 1);
+    tree->touched = mem_alloc(sizeof(int) * tree->cells);
+    tree->scratch = mem_alloc(sizeof(int) * tree->cells);
+    tree->boundary = mem_alloc(sizeof(int) * tree->cells);
+    if (!tree->dist || !tree->parent || !tree->flags || !tree->touched || !tree->scratch || !tree->boundary) {
+        search_tree_free(tree);
+        return NULL;
+    }
+    for (int i = 0; i < tree->cells; i++)
+        tree->dist[i] = INT_MAX;
+    heap_init(&tree->heap, 256);
+    tree->source = -1;
+    return tree;
+}
+
+void search_tree_free(SearchTree* tree) {
+    if (!tree)
+        return;
+    heap_free(&tree->heap);
+    mem_free(tree->dist);
+    mem_free(tree->parent);
+    mem_free(tree->flags);
+    mem_free(tree->touched);
+    mem_free(tree->scratch);
+    mem_free(tree->boundary);
+    mem_free(tree);
+}
+
+static inline bool tree_blocked(const SearchTree* tree, int x, int y) {
+    return !gridmap_walkable(tree->map, x, y) || (tree->overlay && block_overlay_test(tree->overlay, x, y));
+}
+
+static inline void tree_label(SearchTree* tree, int cell, int dist, int parent) {
+    if (!(tree->flags[cell] & TREE_TOUCHED)) {
+        tree->flags[cell] |= TREE_TOUCHED;
+        tree->touched[tree->touched_count++] = cell;
+    }
+    tree->dist[cell] = dist;
+    tree->parent[cell] = parent;
+    if (tree->scan_order)
+        heap_append(&tree->heap, dist, cell);
+    else
+        heap_push(&tree->heap, dist, cell);
+    tree->stats.pushed++;
+}
+
+// Empties the tree, visiting only the cells the old one labelled, not the whole map
+static void tree_clear(SearchTree* tree, const BlockOverlay* overlay) {
+    for (int i = 0; i < tree->touched_count; i++) {
+        int cell = tree->touched[i];
+        tree->dist[cell] = INT_MAX;
+        tree->flags[cell] = 0;
+    }
+    tree->touched_count = 0;
+    heap_clear(&tree->heap);
+    tree->overlay = overlay;
+    tree->stats.expanded = tree->stats.pushed = 0;
+    tree->source = -1;
+}
+
+void search_tree_reset(SearchTree* tree, Point source, const BlockOverlay* overlay) {
+    tree_clear(tree, overlay);
+    if (tree_blocked(tree, source.x, source.y))
+        return;
+    tree->source = gridmap_index(tree->map, source.x, source.y);
+    tree_label(tree, tree->source, 0, -1);
+}
+
+bool search_tree_copy(SearchTree* dst, const SearchTree* src, const BlockOverlay* overlay) {
+    if (dst->cells != src->cells)
+        return false;
+    tree_clear(dst, overlay);
+    for (int i = 0; i < src->touched_count; i++) {
+        int cell = src->touched[i];
+        dst->dist[cell] = src->dist[cell];
+        dst->parent[cell] = src->parent[cell];
+        dst->flags[cell] = src->flags[cell];
+        dst->touched[i] = cell;
+    }
+    dst->touched_count = src->touched_count;
+    // The frontier as it lies: still a heap, or the same list in scan order
+    dst->scan_order = src->scan_order;
+    for (int i = 0; i < src->heap.count; i++) {
+        if (!heap_append(&dst->heap, src->heap.items[i].key, src->heap.items[i].value)) {
+            tree_clear(dst, overlay);
+            return false;
+        }
+    }
+    dst->source = src->source;
+    return true;
+}
+
+void search_tree_set_scan_order(SearchTree* tree, bool scan_order) {
+    tree_clear(tree, tree->overlay);
+    tree->scan_order = scan_order;
+}
+
+Point search_tree_source(const SearchTree* tree) {
+    if (tree->source < 0)
+        return (Point){ -1, -1 };
+    return (Point){ tree->source % tree->map->width, tree->source / tree->map->width };
+}
+
+SearchStatus search_tree_grow(SearchTree* tree, Point target, int max_expansions, double max_ms) {
+    const GridMap* map = tree->map;
+    int goal = -1;
+    if (target.x >= 0) {
+        if (tree->source < 0 || tree_blocked(tree, target.x, target.y))
+            return SEARCH_NO_PATH;
+        goal = gridmap_index(map, target.x, target.y);
+        if (tree->flags[goal] & TREE_SETTLED)
+            return SEARCH_FOUND;
+    }
+
+    Uint64 deadline = 0;
+    if (max_ms > 0.0)
+        deadline = SDL_GetPerformanceCounter() + (Uint64)(max_ms * SDL_GetPerformanceFrequency() / 1000.0);
+    int expanded = 0;
+    while (!heap_empty(&tree->heap)) {
+        if (max_expansions > 0 && expanded >= max_expansions)
+            return SEARCH_RUNNING;
+        if (deadline && expanded > 0 && expanded % TREE_CLOCK_INTERVAL == 0 && SDL_GetPerformanceCounter() >= deadline)
+            return SEARCH_RUNNING;
+        HeapItem item = tree->scan_order ? heap_pop_scan(&tree->heap) : heap_pop(&tree->heap);
+        int current = item.value;
+        if ((tree->flags[current] & TREE_SETTLED) || item.key != tree->dist[current])
+            continue; // Stale: settled already, or relabelled since the push
+
+        tree->flags[current] |= TREE_SETTLED;
+        expanded++;
+        tree->stats.expanded++;
+
+        int cx = current % map->width;
+        int cy = current / map->width;
+        int new_cost = tree->dist[current] + 1;
+        for (int i = 0; i < 4; i++) {
+            int nx = cx + grid_dx[i];
+            int ny = cy + grid_dy[i];
+            if (tree_blocked(tree, nx, ny))
+                continue;
+            int neighbor = gridmap_index(map, nx, ny);
+            if (!(tree->flags[neighbor] & TREE_SETTLED) && new_cost < tree->dist[neighbor])
+                tree_label(tree, neighbor, new_cost, current);
+        }
+        if (current == goal)
+            return SEARCH_FOUND;
+    }
+    return goal < 0 ? SEARCH_FOUND : SEARCH_NO_PATH;
+}
+
+int search_tree_distance(const SearchTree* tree, Point cell) {
+    if (cell.x < 0 || cell.x >= tree->map->width || cell.y < 0 || cell.y >= tree->map->height)
+        return -1;
+    int index = gridmap_index(tree->map, cell.x, cell.y);
+    return (tree->flags[index] & TREE_SETTLED) ? tree->dist[index] : -1;
+}
+
+bool search_tree_path(const SearchTree* tree, Point target, PathBuffer* out) {
+    out->length = 0;
+    out->cost = -1;
+    int cost = search_tree_distance(tree, target);
+    if (cost < 0 || cost >= out->capacity)
+        return false;
+
+    int width = tree->map->width;
+    out->cost = cost;
+    out->length = cost + 1;
+    int at = gridmap_index(tree->map, target.x, target.y);
+    for (int i = out->length - 1; i >= 0; i--) {
+        out->points[i] = (Point){ at % width, at / width };
+        at = tree->parent[at];
+    }
+    return true;
+}
+
+// A settled neighbour of cell one move closer to the source, outside the
+// torn-down part of the tree; -1 if there is none
+static int other_parent(const SearchTree* tree, int cell) {
+    const GridMap* map = tree->map;
+    int cx = cell % map->width;
+    int cy = cell / map->width;
+    for (int d = 0; d < 4; d++) {
+        int nx = cx + grid_dx[d];
+        int ny = cy + grid_dy[d];
+        if (nx < 0 || nx >= map->width || ny < 0 || ny >= map->height)
+            continue;
+        int neighbor = gridmap_index(map, nx, ny);
+        if ((tree->flags[neighbor] & (TREE_SETTLED | TREE_MARKED)) == TREE_SETTLED &&
+            tree->dist[neighbor] == tree->dist[cell] - 1)
+            return neighbor;
+    }
+    return -1;
+}
+
+static int compare_keys(const void* a, const void* b) {
+    int ka = ((const HeapItem*)a)->key, kb = ((const HeapItem*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Takes a cell out of the tree for the repair
+static inline void tear_down(SearchTree* tree, int cell) {
+    tree->flags[cell] = (unsigned char)((tree->flags[cell] & ~TREE_SETTLED) | TREE_MARKED);
+    tree->dist[cell] = INT_MAX;
+    tree->parent[cell] = -1;
+}
+
+int search_tree_block(SearchTree* tree, const Point* cells, int count) {
+    const GridMap* map = tree->map;
+    HeapItem* roots = count > 0 ? mem_alloc(sizeof(HeapItem) * count) : NULL;
+    int root_count = 0;
+    for (int i = 0; roots && i < count; i++) {
+        if (cells[i].x < 0 || cells[i].x >= map->width || cells[i].y < 0 || cells[i].y >= map->height)
+            continue;
+        int cell = gridmap_index(map, cells[i].x, cells[i].y);
+        if (tree->dist[cell] != INT_MAX && !(tree->flags[cell] & TREE_MARKED)) {
+            roots[root_count++] = (HeapItem){ tree->dist[cell], cell };
+            tear_down(tree, cell);
+        }
+    }
+    if (root_count > 1)
+        qsort(roots, root_count, sizeof(HeapItem), compare_keys);
+
+    // Walk down from the blocked cells one distance level at a time. A child
+    // keeps its distance, and with it its whole subtree, if another settled
+    // neighbour one move closer is not torn down; going by level makes sure
+    // that neighbour's own fate is already known. Costs are unit, so the
+    // children of one level are the next one, joined by the blocked cells at
+    // that distance. Torn-down cells next to a settled one are noted: only
+    // they can be relabelled directly.
+    int* subtree = tree->scratch;
+    int* boundary = tree->boundary;
+    int size = 0, boundary_count = 0;
+    int next_root = 0;
+    int level_start = 0;
+    int level = 0;
+    while (level_start < size || next_root < root_count) {
+        level = level_start < size ? level + 1 : roots[next_root].key;
+        while (next_root < root_count && roots[next_root].key <= level)
+            subtree[size++] = roots[next_root++].value;
+        int level_end = size;
+        for (int i = level_start; i < level_end; i++) {
+            int cell = subtree[i];
+            int cx = cell % map->width;
+            int cy = cell / map->width;
+            bool next_to_settled = false;
+            for (int d = 0; d < 4; d++) {
+                int nx = cx + grid_dx[d];
+                int ny = cy + grid_dy[d];
+                if (nx < 0 || nx >= map->width || ny < 0 || ny >= map->height)
+                    continue;
+                int child = gridmap_index(map, nx, ny);
+                unsigned char flags = tree->flags[child];
+                if (flags & TREE_MARKED)
+                    continue;
+                if (tree->parent[child] == cell && tree->dist[child] != INT_MAX) {
+                    int parent = other_parent(tree, child);
+                    if (parent < 0) {
+                        tear_down(tree, child);
+                        subtree[size++] = child;
+                        continue;
+                    }
+                    tree->parent[child] = parent;
+                }
+                next_to_settled = next_to_settled || (flags & TREE_SETTLED);
+            }
+            if (next_to_settled)
+                boundary[boundary_count++] = cell;
+        }
+        level_start = level_end;
+    }
+    mem_free(roots);
+
+    // Relabel the boundary from its settled neighbours outside the subtree
+    // (some may have been torn down after they were noted). The rest of the
+    // subtree, and frontier labels that get better through it, follow as the
+    // search settles these again.
+    for (int i = 0; i < boundary_count; i++) {
+        int cell = boundary[i];
+        int cx = cell % map->width;
+        int cy = cell / map->width;
+        if (tree->overlay && block_overlay_test(tree->overlay, cx, cy))
+            continue;
+        int best = INT_MAX, best_parent = -1;
+        for (int d = 0; d < 4; d++) {
+            int nx = cx + grid_dx[d];
+            int ny = cy + grid_dy[d];
+            if (nx < 0 || nx >= map->width || ny < 0 || ny >= map->height)
+                continue;
+            // Settled cells outside the subtree are never walls or blocked
+            int neighbor = gridmap_index(map, nx, ny);
+            if ((tree->flags[neighbor] & (TREE_SETTLED | TREE_MARKED)) == TREE_SETTLED && tree->dist[neighbor] + 1 < best) {
+                best = tree->dist[neighbor] + 1;
+                best_parent = neighbor;
+            }
+        }
+        if (best_parent >= 0)
+            tree_label(tree, cell, best, best_parent);
+    }
+    for (int i = 0; i < size; i++)
+        tree->flags[subtree[i]] &= ~TREE_MARKED;
+    return size;
+}
+
+SearchStats search_tree_stats(const SearchTree* tree) {
+    return tree->stats;
+}
+
+int search_tree_disjoint_paths(SearchTree* tree, Point from, Point to, int k, BlockOverlay* overlay,
+    Point* points, int capacity, PathBuffer* paths) {
+    block_overlay_clear(overlay);
+    search_tree_reset(tree, from, overlay);
+    int found = 0;
+    int used = 0;
+    while (found < k) {
+        PathBuffer* path = &paths[found];
+        path->points = points + used;
+        path->capacity = capacity - used;
+        if (search_tree_grow(tree, to, 0, 0.0) != SEARCH_FOUND || !search_tree_path(tree, to, path))
+            break;
+
+        used += path->length;
+        found++;
+        if (!block_overlay_add_path_inner(overlay, path->points, path->length))
+            break;
+        // Start and end next to each other block nothing: like grid_disjoint_paths(),
+        // the direct step is then returned again for every path
+        if (path->length > 2)
+            search_tree_block(tree, path->points + 1, path->length - 2);
+    }
+    return found;
+}
+
+static uint32_t next_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+int search_tree_run_benchmark_tool(const char* map_path, int k, int queries) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (k <= 0)
+        k = 50;
+    if (queries <= 0)
+        queries = 20;
+
+    int cells = map->width * map->height;
+    int capacity = cells + 2 * k;
+    GridSearch* search = grid_search_create(map);
+    SearchTree* tree = search_tree_create(map);
+    BlockOverlay* overlay = block_overlay_create(map->width, map->height);
+    Point* points = malloc(sizeof(Point) * 2 * capacity); // The second half for the check
+    PathBuffer* paths = malloc(sizeof(PathBuffer) * k);
+    if (!search || !tree || !overlay || !points || !paths) {
+        fprintf(stderr, "Out of memory.\n");
+        grid_search_free(search);
+        search_tree_free(tree);
+        block_overlay_free(overlay);
+        free(points);
+        free(paths);
+        gridmap_free(map);
+        return 1;
+    }
+
+    Uint64 full_ticks = 0, repair_ticks = 0;
+    long long full_expanded = 0, repair_expanded = 0, full_paths = 0, repair_paths = 0, full_searches = 0;
+    int done = 0, mismatches = 0;
+    uint32_t state = 4711u;
+    for (int attempt = 0; attempt < queries * 1000 && done < queries; attempt++) {
+        Point from = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+        Point to = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+        if (!gridmap_walkable(map, from.x, from.y) || !gridmap_walkable(map, to.x, to.y) ||
+            (from.x == to.x && from.y == to.y))
+            continue;
+        done++;
+
+        // The loop of handle_click: a full Dijkstra per path
+        SearchOptions options = { overlay, NULL, NULL, NULL, NULL };
+        block_overlay_clear(overlay);
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        for (int i = 0; i < k; i++) {
+            PathBuffer path = { points, capacity, 0, -1 };
+            grid_search_begin(search, from, to, &options);
+            grid_search_step(search, 0, 0.0);
+            full_expanded += grid_search_stats(search).expanded;
+            full_searches++;
+            if (!grid_search_path(search, &path))
+                break;
+            full_paths++;
+            block_overlay_add_path_inner(overlay, path.points, path.length);
+        }
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        int found = search_tree_disjoint_paths(tree, from, to, k, overlay, points, capacity, paths);
+        Uint64 t2 = SDL_GetPerformanceCounter();
+        full_ticks += t1 - t0;
+        repair_ticks += t2 - t1;
+        repair_expanded += search_tree_stats(tree).expanded;
+        repair_paths += found;
+
+        // Untimed: every repaired distance must be what a fresh search finds
+        block_overlay_clear(overlay);
+        search_tree_reset(tree, from, overlay);
+        for (int i = 0; i < k; i++) {
+            PathBuffer path = { points, capacity, 0, -1 }, fresh = { points + capacity, capacity, 0, -1 };
+            SearchStatus status = search_tree_grow(tree, to, 0, 0.0);
+            grid_search_begin(search, from, to, &options);
+            grid_search_step(search, 0, 0.0);
+            grid_search_path(search, &fresh);
+            int cost = status == SEARCH_FOUND ? search_tree_distance(tree, to) : -1;
+            if (cost != fresh.cost) {
+                mismatches++;
+                break;
+            }
+            if (cost < 0 || !search_tree_path(tree, to, &path))
+                break;
+            block_overlay_add_path_inner(overlay, path.points, path.length);
+            if (path.length > 2)
+                search_tree_block(tree, path.points + 1, path.length - 2);
+        }
+    }
+
+    double ms = 1000.0 / SDL_GetPerformanceFrequency();
+    printf("%s: %dx%d, %d K-loops with K = %d\n", map_path, map->width, map->height, done, k);
+    printf("  Full searches:  %.3f ms per loop, %lld expansions (%lld searches, %lld paths)\n",
+        done ? full_ticks * ms / done : 0.0, done ? full_expanded / done : 0, full_searches, full_paths);
+    printf("  Repaired tree:  %.3f ms per loop, %lld expansions (%lld paths)\n",
+        done ? repair_ticks * ms / done : 0.0, done ? repair_expanded / done : 0, repair_paths);
+    printf("  Speedup %.2fx, %.1f%% of the expansions\n", repair_ticks ? (double)full_ticks / repair_ticks : 0.0,
+        full_expanded ? 100.0 * repair_expanded / full_expanded : 0.0);
+    if (mismatches)
+        printf("  %d loops where a repaired distance differs from a fresh search!\n", mismatches);
+
+    grid_search_free(search);
+    search_tree_free(tree);
+    block_overlay_free(overlay);
+    free(points);
+    free(paths);
+    gridmap_free(map);
+    return mismatches ? 1 : 0;
+}
+
+int search_tree_run_retarget_tool(const char* map_path, int starts, int ends) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (starts <= 0)
+        starts = 10;
+    if (ends <= 0)
+        ends = 50;
+
+    int capacity = map->width * map->height;
+    GridSearch* search = grid_search_create(map);
+    SearchTree* tree = search_tree_create(map);
+    Point* points = malloc(sizeof(Point) * capacity);
+    if (!search || !tree || !points) {
+        fprintf(stderr, "Out of memory.\n");
+        grid_search_free(search);
+        search_tree_free(tree);
+        free(points);
+        gridmap_free(map);
+        return 1;
+    }
+
+    Uint64 fresh_ticks = 0, cached_ticks = 0;
+    long long fresh_expanded = 0, cached_expanded = 0;
+    int queries = 0, settled_already = 0, mismatches = 0;
+    uint32_t state = 4711u;
+    for (int s = 0, attempt = 0; s < starts && attempt < starts * 1000; attempt++) {
+        Point from = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+        if (!gridmap_walkable(map, from.x, from.y))
+            continue;
+        s++;
+        search_tree_reset(tree, from, NULL);
+
+        // The same start with the end moved around, as a user clicking ends
+        for (int e = 0, tries = 0; e < ends && tries < ends * 1000; tries++) {
+            Point to = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+            if (!gridmap_walkable(map, to.x, to.y) || (from.x == to.x && from.y == to.y))
+                continue;
+            e++;
+            queries++;
+
+            // A fresh Dijkstra per end, like dijkstra_find_path()
+            SearchOptions options = { NULL, NULL, NULL, NULL, NULL };
+            PathBuffer fresh = { points, capacity, 0, -1 };
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            grid_search_begin(search, from, to, &options);
+            grid_search_step(search, 0, 0.0);
+            grid_search_path(search, &fresh);
+            Uint64 t1 = SDL_GetPerformanceCounter();
+            fresh_expanded += grid_search_stats(search).expanded;
+            int fresh_cost = fresh.cost;
+
+            long long before = search_tree_stats(tree).expanded;
+            settled_already += search_tree_distance(tree, to) >= 0;
+            PathBuffer cached = { points, capacity, 0, -1 };
+            Uint64 t2 = SDL_GetPerformanceCounter();
+            if (search_tree_grow(tree, to, 0, 0.0) == SEARCH_FOUND)
+                search_tree_path(tree, to, &cached);
+            Uint64 t3 = SDL_GetPerformanceCounter();
+            cached_expanded += search_tree_stats(tree).expanded - before;
+            fresh_ticks += t1 - t0;
+            cached_ticks += t3 - t2;
+            if (cached.cost != fresh_cost)
+                mismatches++;
+        }
+    }
+
+    double us = 1000000.0 / SDL_GetPerformanceFrequency();
+    printf("%s: %dx%d, %d starts with %d ends each (%d queries)\n", map_path, map->width, map->height, starts, ends, queries);
+    printf("  Fresh search: %.1f us per end, %lld expansions\n",
+        queries ? fresh_ticks * us / queries : 0.0, queries ? fresh_expanded / queries : 0);
+    printf("  Cached tree:  %.1f us per end, %lld expansions; %d ends (%.1f%%) were settled already\n",
+        queries ? cached_ticks * us / queries : 0.0, queries ? cached_expanded / queries : 0, settled_already,
+        queries ? 100.0 * settled_already / queries : 0.0);
+    printf("  Speedup %.2fx\n", cached_ticks ? (double)fresh_ticks / cached_ticks : 0.0);
+    if (mismatches)
+        printf("  %d ends where the cached tree's cost differs from a fresh search!\n", mismatches);
+
+    grid_search_free(search);
+    search_tree_free(tree);
+    free(points);
+    gridmap_free(map);
+    return mismatches ? 1 : 0;
+}
+
+int search_tree_run_hover_tool(const char* map_path, int frames, double budget_ms) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (frames <= 0)
+        frames = 600;
+    if (budget_ms <= 0.0)
+        budget_ms = 4.0;
+
+    int capacity = map->width * map->height;
+    GridSearch* search = grid_search_create(map);
+    SearchTree* tree = search_tree_create(map);
+    Point* points = malloc(sizeof(Point) * capacity);
+    if (!search || !tree || !points) {
+        fprintf(stderr, "Out of memory.\n");
+        grid_search_free(search);
+        search_tree_free(tree);
+        free(points);
+        gridmap_free(map);
+        return 1;
+    }
+
+    uint32_t state = 4711u;
+    Point start = { -1, -1 };
+    for (int attempt = 0; attempt < 100000 && start.x < 0; attempt++) {
+        Point p = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+        if (gridmap_walkable(map, p.x, p.y))
+            start = p;
+    }
+    search_tree_reset(tree, start, NULL);
+
+    // The cursor heads for random waypoints, several motion events a frame;
+    // like the visualizer, only the last cell of each frame is answered
+    const int events_per_frame = 4;
+    int speed = map->width / 256 > 1 ? map->width / 256 : 1;
+    Point cursor = start, waypoint = start;
+    double us = 1000000.0 / SDL_GetPerformanceFrequency();
+    Uint64 worst = 0, answer_ticks = 0, fresh_ticks = 0;
+    int shown = 0, pending = 0, blocked = 0, fresh_count = 0, complete_frame = -1;
+    for (int frame = 0; frame < frames; frame++) {
+        for (int e = 0; e < events_per_frame; e++) {
+            if (cursor.x == waypoint.x && cursor.y == waypoint.y)
+                waypoint = (Point){ (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+            int dx = waypoint.x - cursor.x, dy = waypoint.y - cursor.y;
+            cursor.x += dx > speed ? speed : (dx < -speed ? -speed : dx);
+            cursor.y += dy > speed ? speed : (dy < -speed ? -speed : dy);
+        }
+
+        // update_hover_preview()
+        PathBuffer path = { points, capacity, 0, -1 };
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        SearchStatus status = search_tree_grow(tree, cursor, 0, budget_ms);
+        if (status == SEARCH_FOUND)
+            search_tree_path(tree, cursor, &path);
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        double left = budget_ms - (double)(t1 - t0) * us / 1000.0;
+        if (left > 0.0 && search_tree_grow(tree, (Point){ -1, -1 }, 0, left) == SEARCH_FOUND && complete_frame < 0)
+            complete_frame = frame;
+        Uint64 t2 = SDL_GetPerformanceCounter();
+        if (t2 - t0 > worst)
+            worst = t2 - t0;
+        if (status == SEARCH_FOUND) {
+            shown++;
+            answer_ticks += t1 - t0;
+        }
+        else if (status == SEARCH_RUNNING) {
+            pending++;
+        }
+        else {
+            blocked++;
+        }
+
+        // Untimed by the frame: what a fresh A* per hover would cost, every 20th frame
+        if (frame % 20 == 0 && gridmap_walkable(map, cursor.x, cursor.y)) {
+            SearchOptions options = { NULL, grid_manhattan_heuristic, map, NULL, NULL };
+            Uint64 t3 = SDL_GetPerformanceCounter();
+            grid_search_begin(search, start, cursor, &options);
+            grid_search_step(search, 0, 0.0);
+            fresh_ticks += SDL_GetPerformanceCounter() - t3;
+            fresh_count++;
+        }
+    }
+
+    printf("%s: %dx%d, %d frames of %d motion events, %.1f ms budget per frame\n", map_path, map->width, map->height,
+        frames, events_per_frame, budget_ms);
+    printf("  Preview shown in %d frames (%.1f%%), still growing in %d, wall or unreachable in %d\n", shown,
+        100.0 * shown / frames, pending, blocked);
+    printf("  %.1f us per shown preview, worst frame %.2f ms; tree complete after %d frames\n",
+        shown ? answer_ticks * us / shown : 0.0, worst * us / 1000.0, complete_frame < 0 ? -1 : complete_frame + 1);
+    printf("  A fresh A* per hover: %.2f ms (%d sampled)\n", fresh_count ? fresh_ticks * us / 1000.0 / fresh_count : 0.0,
+        fresh_count);
+
+    grid_search_free(search);
+    search_tree_free(tree);
+    free(points);
+    gridmap_free(map);
+    return 0;
+}
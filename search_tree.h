@@ -0,0 +1,85 @@
+#ifndef SEARCH_TREE_H
+#define SEARCH_TREE_H
+
+#include "block_overlay.h"
+#include "grid_search.h"
+
+// Dijkstra shortest-path tree from one source that is kept between queries.
+// It settles cells only as far as the current target needs and keeps its
+// frontier, so it can be grown further later. When cells get blocked, only the
+// subtrees below them are torn down and relabelled from their settled
+// neighbours (dynamic SSSP for vertex deletions); everything else stays
+// settled. This is what the K-loop needs: each iteration blocks the cells of
+// the path just found and searches again from the same start to the same end.
+//
+// Cells in the overlay are never entered, including the target: callers block
+// only the inner cells of paths. Unit cost per move, like GridSearch.
+typedef struct SearchTree SearchTree;
+
+SearchTree* search_tree_create(const GridMap* map);
+void search_tree_free(SearchTree* tree);
+
+// Drops the tree and roots a new one at source. overlay may be NULL; it is
+// referenced and must stay valid while the tree is used.
+void search_tree_reset(SearchTree* tree, Point source, const BlockOverlay* overlay);
+
+// Makes dst the same tree as src, frontier included, at the cost of the cells
+// src labelled. Both must be on the same map. dst then searches with overlay,
+// which must block no more than src's did: add cells with search_tree_block().
+// Lets a cached tree be branched off for a K-loop that blocks cells in it.
+bool search_tree_copy(SearchTree* dst, const SearchTree* src, const BlockOverlay* overlay);
+
+// Makes the frontier pop equal distances in dijkstra_find_path's order (the
+// first pushed of the smallest, with the last entry moved into the gap), so a
+// tree that was never repaired settles cells and picks parents exactly like
+// it. Pops are linear in the frontier, so only for small maps such as the
+// visualizer's grid. Drops the tree; search_tree_copy() carries the setting.
+void search_tree_set_scan_order(SearchTree* tree, bool scan_order);
+
+// Cell the tree is rooted at, { -1, -1 } before a reset or if it is blocked
+Point search_tree_source(const SearchTree* tree);
+
+/**
+ * @brief Settles cells until target is settled or the frontier is empty.
+ * @param target Cell to grow to, or { -1, -1 } to settle everything reachable.
+ * @param max_expansions Node budget, 0 for none; SEARCH_RUNNING when it runs out.
+ * @param max_ms Time budget in milliseconds, 0 for none, read like grid_search_step().
+ */
+SearchStatus search_tree_grow(SearchTree* tree, Point target, int max_expansions, double max_ms);
+
+// Distance of a settled cell, -1 if it is not settled (yet)
+int search_tree_distance(const SearchTree* tree, Point cell);
+// Writes the path to a settled target, false if it is not settled or out is too small
+bool search_tree_path(const SearchTree* tree, Point target, PathBuffer* out);
+
+/**
+ * @brief Repairs the tree after cells were added to its overlay. Cells not in
+ * the tree are ignored, so passing a whole path is fine.
+ * @return Number of cells whose labels were dropped.
+ */
+int search_tree_block(SearchTree* tree, const Point* cells, int count);
+
+// Expansions and pushes since the last reset
+SearchStats search_tree_stats(const SearchTree* tree);
+
+/**
+ * @brief grid_disjoint_paths() on a SearchTree: the tree from the last path
+ * is repaired instead of being searched again from scratch. Dijkstra only.
+ */
+int search_tree_disjoint_paths(SearchTree* tree, Point from, Point to, int k, BlockOverlay* overlay,
+    Point* points, int capacity, PathBuffer* paths);
+
+// --bench-repair tool: the K-loop with full Dijkstra searches against the
+// repaired tree on a map file, checking every repaired distance against a
+// fresh search.
+int search_tree_run_benchmark_tool(const char* map_path, int k, int queries);
+
+// --bench-retarget tool: keeps each start and moves the end around, a fresh
+// Dijkstra per end against one tree per start that is grown as needed.
+int search_tree_run_retarget_tool(const char* map_path, int starts, int ends);
+
+// --bench-hover tool: the visualizer's hover preview on a map file, a cursor
+// moving around one start with a time budget per frame for the tree.
+int search_tree_run_hover_tool(const char* map_path, int frames, double budget_ms);
+
+#endif // SEARCH_TREE_H
@@ -0,0 +1,507 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "shm_ring.h"
+#include "grid_search.h"
+#include "net.h"
+
+#define SHM_RING_MAGIC "SPRB"
+#define SHM_RING_VERSION 1u
+#define SHM_RING_ALIGN 64
+
+// Start of the shared region. published gets a cache line of its own.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t max_points;
+    uint32_t slot_stride;
+    unsigned char pad0[SHM_RING_ALIGN - 20];
+    SDL_AtomicInt published; // Sequence of the newest complete path, 0 if none
+    unsigned char pad1[SHM_RING_ALIGN - sizeof(SDL_AtomicInt)];
+} ShmRingHeader;
+
+// Slot header; max_points Points follow it
+typedef struct {
+    SDL_AtomicInt sequence; // 2n once path n is complete, 2n-1 while it is written
+    uint32_t tag;
+    int cost;
+    int length;
+} ShmSlot;
+
+struct ShmRing {
+    unsigned char* base;
+    size_t bytes;
+    ShmRingHeader* header;
+    bool owner;
+    uint32_t next; // Producer: sequence of the path being written
+    char name[128];
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+};
+
+static inline ShmSlot* ring_slot(const ShmRing* ring, uint32_t sequence) {
+    uint32_t index = (sequence - 1) % ring->header->slot_count;
+    return (ShmSlot*)(ring->base + sizeof(ShmRingHeader) + (size_t)index * ring->header->slot_stride);
+}
+
+static inline Point* slot_points(ShmSlot* slot) {
+    return (Point*)(slot + 1);
+}
+
+// Maps the region; size 0 means open an existing one and take its size from the header
+static ShmRing* ring_map(const char* name, size_t size) {
+    ShmRing* ring = calloc(1, sizeof(ShmRing));
+    if (!ring)
+        return NULL;
+    ring->owner = size != 0;
+
+#ifdef _WIN32
+    SDL_snprintf(ring->name, sizeof(ring->name), "Local\\%s", name);
+    if (ring->owner) {
+        ring->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            (DWORD)((uint64_t)size >> 32), (DWORD)size, ring->name);
+    }
+    else {
+        ring->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, ring->name);
+    }
+    ring->base = ring->mapping ? MapViewOfFile(ring->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : NULL;
+    if (ring->base) {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(ring->base, &info, sizeof(info));
+        ring->bytes = size ? size : info.RegionSize;
+    }
+#else
+    SDL_snprintf(ring->name, sizeof(ring->name), "/%s", name);
+    int fd = ring->owner ? shm_open(ring->name, O_RDWR | O_CREAT | O_TRUNC, 0600) : shm_open(ring->name, O_RDWR, 0);
+    if (fd >= 0) {
+        struct stat st;
+        if (ring->owner && ftruncate(fd, (off_t)size) != 0)
+            size = 0;
+        else if (!ring->owner && fstat(fd, &st) == 0)
+            size = (size_t)st.st_size;
+        if (size) {
+            ring->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (ring->base == MAP_FAILED)
+                ring->base = NULL;
+            ring->bytes = size;
+        }
+        close(fd);
+    }
+#endif
+
+    if (!ring->base) {
+        fprintf(stderr, "Could not map shared memory %s\n", ring->name);
+        shm_ring_close(ring);
+        return NULL;
+    }
+    ring->header = (ShmRingHeader*)ring->base;
+    return ring;
+}
+
+ShmRing* shm_ring_create(const char* name, int slot_count, int max_points) {
+    if (slot_count <= 0 || max_points <= 0)
+        return NULL;
+    size_t stride = sizeof(ShmSlot) + (size_t)max_points * sizeof(Point);
+    stride = (stride + SHM_RING_ALIGN - 1) & ~(size_t)(SHM_RING_ALIGN - 1);
+    if (stride > UINT32_MAX)
+        return NULL;
+
+    ShmRing* ring = ring_map(name, sizeof(ShmRingHeader) + stride * slot_count);
+    if (!ring)
+        return NULL;
+
+    // Fresh pages are zero: every slot starts at sequence 0, "never written"
+    ShmRingHeader* header = ring->header;
+    header->version = SHM_RING_VERSION;
+    header->slot_count = (uint32_t)slot_count;
+    header->max_points = (uint32_t)max_points;
+    header->slot_stride = (uint32_t)stride;
+    SDL_SetAtomicInt(&header->published, 0);
+    memcpy(header->magic, SHM_RING_MAGIC, 4); // Last, so openers never see a half-made header
+    ring->next = 1;
+    return ring;
+}
+
+ShmRing* shm_ring_open(const char* name) {
+    ShmRing* ring = ring_map(name, 0);
+    if (!ring)
+        return NULL;
+    const ShmRingHeader* header = ring->header;
+    if (ring->bytes < sizeof(ShmRingHeader) || memcmp(header->magic, SHM_RING_MAGIC, 4) != 0 ||
+        header->version != SHM_RING_VERSION || header->slot_count == 0 ||
+        ring->bytes < sizeof(ShmRingHeader) + (size_t)header->slot_stride * header->slot_count) {
+        fprintf(stderr, "%s is not a path ring\n", name);
+        shm_ring_close(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+void shm_ring_close(ShmRing* ring) {
+    if (!ring)
+        return;
+#ifdef _WIN32
+    if (ring->base)
+        UnmapViewOfFile(ring->base);
+    if (ring->mapping)
+        CloseHandle(ring->mapping); // The mapping goes away with its last handle
+#else
+    if (ring->base)
+        munmap(ring->base, ring->bytes);
+    if (ring->owner)
+        shm_unlink(ring->name);
+#endif
+    free(ring);
+}
+
+int shm_ring_slot_count(const ShmRing* ring) {
+    return (int)ring->header->slot_count;
+}
+
+PathBuffer shm_ring_begin_write(ShmRing* ring) {
+    ShmSlot* slot = ring_slot(ring, ring->next);
+    // Odd: consumers still reading the slot's previous path will notice
+    SDL_SetAtomicInt(&slot->sequence, (int)(ring->next * 2 - 1));
+    PathBuffer buffer = { slot_points(slot), (int)ring->header->max_points, 0, -1 };
+    return buffer;
+}
+
+void shm_ring_commit(ShmRing* ring, const PathBuffer* path, uint32_t tag) {
+    ShmSlot* slot = ring_slot(ring, ring->next);
+    slot->tag = tag;
+    slot->cost = path->cost;
+    slot->length = path->length;
+    SDL_SetAtomicInt(&slot->sequence, (int)(ring->next * 2));
+    SDL_SetAtomicInt(&ring->header->published, (int)ring->next);
+    ring->next++;
+}
+
+uint32_t shm_ring_cursor(const ShmRing* ring) {
+    return (uint32_t)SDL_GetAtomicInt(&ring->header->published) + 1;
+}
+
+ShmRingStatus shm_ring_read(const ShmRing* ring, uint32_t* cursor, ShmPathView* view) {
+    uint32_t published = (uint32_t)SDL_GetAtomicInt(&ring->header->published);
+    uint32_t slot_count = ring->header->slot_count;
+    if ((int32_t)(published - *cursor) < 0)
+        return SHM_RING_EMPTY;
+    if (published - *cursor >= slot_count) {
+        *cursor = published - slot_count + 1;
+        return SHM_RING_OVERRUN;
+    }
+
+    ShmSlot* slot = ring_slot(ring, *cursor);
+    uint32_t expected = *cursor * 2;
+    if ((uint32_t)SDL_GetAtomicInt(&slot->sequence) != expected) {
+        // Already being reused: skip to what will still be there after the write in progress
+        *cursor = published - slot_count + 2;
+        return SHM_RING_OVERRUN;
+    }
+    view->sequence = *cursor;
+    view->tag = slot->tag;
+    view->cost = slot->cost;
+    view->length = slot->length;
+    view->points = slot_points(slot);
+    if ((uint32_t)SDL_GetAtomicInt(&slot->sequence) != expected ||
+        view->length < 0 || (uint32_t)view->length > ring->header->max_points) {
+        *cursor = published - slot_count + 2;
+        return SHM_RING_OVERRUN;
+    }
+    (*cursor)++;
+    return SHM_RING_OK;
+}
+
+bool shm_ring_still_valid(const ShmRing* ring, const ShmPathView* view) {
+    return (uint32_t)SDL_GetAtomicInt(&ring_slot(ring, view->sequence)->sequence) == view->sequence * 2;
+}
+
+// ----------------------------------------------------------------------------
+// Benchmark: search results delivered through the ring vs. a local socket
+// carrying the query server's path encoding
+// ----------------------------------------------------------------------------
+
+#define BENCH_QUERIES 64
+#define BENCH_SLOTS 16
+#define BENCH_WALL_PERCENT 20
+
+// One endpoint pair and what its path must add up to on the consumer's side
+typedef struct {
+    Point from, to;
+    int length;
+    long long checksum; // Sum of x + y over the points
+} BenchQuery;
+
+typedef struct {
+    const GridMap* map;
+    BenchQuery* queries;
+    int paths; // Path i answers queries[i % BENCH_QUERIES]
+    GridSearch* search; // The producer's
+    ShmRing* ring;
+    SDL_AtomicInt consumed; // Flow control for the benchmark only, so no path is lost
+    NetSocket socket;
+} RingBenchmark;
+
+static uint32_t bench_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static long long bench_checksum(const Point* points, int length) {
+    long long sum = 0;
+    for (int i = 0; i < length; i++)
+        sum += points[i].x + points[i].y;
+    return sum;
+}
+
+// The producer's work for path i: a full A* search that writes its path to out
+static bool bench_search(const RingBenchmark* bench, int i, PathBuffer* out) {
+    const BenchQuery* query = &bench->queries[i % BENCH_QUERIES];
+    SearchOptions options = { NULL, grid_manhattan_heuristic, bench->map, NULL, NULL };
+    grid_search_begin(bench->search, query->from, query->to, &options);
+    grid_search_step(bench->search, 0, 0.0);
+    return grid_search_path(bench->search, out);
+}
+
+// Far apart walkable endpoints whose paths exist; false if the map has too few
+static bool pick_bench_queries(RingBenchmark* bench, Point* points, int capacity) {
+    const GridMap* map = bench->map;
+    BenchQuery* queries = bench->queries;
+    uint32_t state = 58u;
+    int found = 0;
+    for (int attempt = 0; found < BENCH_QUERIES && attempt < 100000; attempt++) {
+        BenchQuery* query = &queries[found];
+        query->from = (Point){ (int)(bench_random(&state) % map->width), (int)(bench_random(&state) % map->height) };
+        query->to = (Point){ (int)(bench_random(&state) % map->width), (int)(bench_random(&state) % map->height) };
+        if (abs(query->from.x - query->to.x) + abs(query->from.y - query->to.y) < (map->width + map->height) / 4 ||
+            !gridmap_walkable(map, query->from.x, query->from.y) || !gridmap_walkable(map, query->to.x, query->to.y))
+            continue;
+        PathBuffer out = { points, capacity, 0, -1 };
+        if (!bench_search(bench, found, &out))
+            continue;
+        query->length = out.length;
+        query->checksum = bench_checksum(out.points, out.length);
+        found++;
+    }
+    return found == BENCH_QUERIES;
+}
+
+// Spin briefly, then sleep for longer and longer (20 us up to about 1 ms).
+// No yielding: on a shared core that only switches back and forth with the
+// search the waiting side is waiting for.
+static void bench_backoff(int spins) {
+    if (spins < 256)
+        SDL_CPUPauseInstruction();
+    else
+        SDL_DelayNS(20000ull << (spins - 256 < 6 ? spins - 256 : 6));
+}
+
+static int ring_producer(void* data) {
+    RingBenchmark* bench = data;
+    int slots = shm_ring_slot_count(bench->ring);
+    for (int i = 0; i < bench->paths; i++) {
+        for (int spins = 0; i - SDL_GetAtomicInt(&bench->consumed) >= slots; spins++)
+            bench_backoff(spins);
+        // The search writes its points straight into shared memory
+        PathBuffer out = shm_ring_begin_write(bench->ring);
+        bench_search(bench, i, &out);
+        shm_ring_commit(bench->ring, &out, (uint32_t)i);
+    }
+    return 0;
+}
+
+static bool send_blocking(NetSocket socket, const unsigned char* bytes, size_t size) {
+    while (size > 0) {
+        int n = net_send(socket, bytes, size > (1u << 20) ? (1 << 20) : (int)size);
+        if (n == NET_WOULD_BLOCK) {
+            NetPollFd fd = { socket, POLLOUT, 0 };
+            net_poll(&fd, 1, -1);
+            continue;
+        }
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+static int socket_producer(void* data) {
+    RingBenchmark* bench = data;
+    int cells = bench->map->width * bench->map->height;
+    Point* points = malloc(sizeof(Point) * cells);
+    unsigned char* frame = malloc(8 + (size_t)cells * 4);
+    for (int i = 0; points && frame && i < bench->paths; i++) {
+        PathBuffer out = { points, cells, 0, -1 };
+        bench_search(bench, i, &out);
+        // Same encoding as a query server response: cost, length, u16 x/y pairs
+        net_put_u32(frame, (unsigned int)out.cost);
+        net_put_u32(frame + 4, (unsigned int)out.length);
+        for (int p = 0; p < out.length; p++) {
+            net_put_u16(frame + 8 + p * 4, (unsigned int)out.points[p].x);
+            net_put_u16(frame + 10 + p * 4, (unsigned int)out.points[p].y);
+        }
+        if (!send_blocking(bench->socket, frame, 8 + (size_t)out.length * 4))
+            break;
+    }
+    free(points);
+    free(frame);
+    return 0;
+}
+
+static bool recv_blocking(NetSocket socket, unsigned char* bytes, size_t size) {
+    while (size > 0) {
+        int n = net_recv(socket, bytes, size > (1u << 20) ? (1 << 20) : (int)size);
+        if (n == NET_WOULD_BLOCK) {
+            NetPollFd fd = { socket, POLLIN, 0 };
+            net_poll(&fd, 1, -1);
+            continue;
+        }
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+int shm_ring_run_benchmark_tool(int side, int paths) {
+    side = side > 1 ? side : 256;
+    paths = paths > 0 ? paths : 2000;
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    int cells = side * side;
+
+    BenchQuery queries[BENCH_QUERIES];
+    RingBenchmark bench = { NULL, queries, paths, NULL, NULL, { 0 }, NET_INVALID_SOCKET };
+    GridMap* map = gridmap_create_random(side, side, BENCH_WALL_PERCENT, (unsigned int)side);
+    bench.map = map;
+    bench.search = map ? grid_search_create(map) : NULL;
+    Point* points = malloc(sizeof(Point) * cells);
+    if (!bench.search || !points || !pick_bench_queries(&bench, points, cells)) {
+        fprintf(stderr, "Could not set up %d queries on a %dx%d map.\n", BENCH_QUERIES, side, side);
+        grid_search_free(bench.search);
+        gridmap_free(map);
+        free(points);
+        return 1;
+    }
+    long long total_points = 0;
+    for (int i = 0; i < paths; i++)
+        total_points += queries[i % BENCH_QUERIES].length;
+    printf("%d paths on a %dx%d map with %d%% walls (%d endpoint pairs, %.0f points per path)\n", paths, side, side,
+        BENCH_WALL_PERCENT, BENCH_QUERIES, (double)total_points / paths);
+    printf("Every path is searched by the producer; consumers check its points against a reference run.\n");
+
+    // The search alone, into private memory: what neither transport can save
+    long long checksum_errors = 0;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    for (int i = 0; i < paths; i++) {
+        PathBuffer out = { points, cells, 0, -1 };
+        bench_search(&bench, i, &out);
+        const BenchQuery* query = &queries[i % BENCH_QUERIES];
+        if (out.length != query->length || bench_checksum(out.points, out.length) != query->checksum)
+            checksum_errors++;
+    }
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    double search_us = (double)(t1 - t0) * 1e6 / freq / paths;
+
+    char name[64];
+    SDL_snprintf(name, sizeof(name), "spgrid-bench-%llu", (unsigned long long)SDL_GetPerformanceCounter());
+    bench.ring = shm_ring_create(name, BENCH_SLOTS, cells);
+    ShmRing* consumer = bench.ring ? shm_ring_open(name) : NULL; // Separate mapping, like another process
+    if (!consumer) {
+        fprintf(stderr, "Could not create the ring (%d slots of %d points).\n", BENCH_SLOTS, cells);
+        shm_ring_close(bench.ring);
+        grid_search_free(bench.search);
+        gridmap_free(map);
+        free(points);
+        return 1;
+    }
+
+    // Shared-memory ring: consumers check the points where they lie
+    SDL_SetAtomicInt(&bench.consumed, 0);
+    uint32_t cursor = shm_ring_cursor(consumer);
+    t0 = SDL_GetPerformanceCounter();
+    SDL_Thread* producer = SDL_CreateThread(ring_producer, "ring producer", &bench);
+    for (int received = 0, spins = 0; producer && received < paths;) {
+        ShmPathView view;
+        ShmRingStatus status = shm_ring_read(consumer, &cursor, &view);
+        if (status == SHM_RING_EMPTY) {
+            bench_backoff(spins++);
+            continue;
+        }
+        spins = 0;
+        if (status == SHM_RING_OVERRUN) {
+            fprintf(stderr, "Unexpected overrun\n");
+            break;
+        }
+        const BenchQuery* query = &queries[view.tag % BENCH_QUERIES];
+        long long sum = bench_checksum(view.points, view.length);
+        if (!shm_ring_still_valid(consumer, &view) || view.length != query->length || sum != query->checksum)
+            checksum_errors++;
+        received++;
+        SDL_SetAtomicInt(&bench.consumed, received);
+    }
+    SDL_WaitThread(producer, NULL);
+    t1 = SDL_GetPerformanceCounter();
+    double ring_us = (double)(t1 - t0) * 1e6 / freq / paths;
+
+    // Socket: search, serialise, send through the kernel, receive and decode into Points
+    NetSocket pair[2];
+    double socket_us = 0.0;
+    if (net_startup() && net_wake_pair(pair)) {
+        bench.socket = pair[1];
+        unsigned char* frame = malloc(8 + (size_t)cells * 4);
+        t0 = SDL_GetPerformanceCounter();
+        producer = SDL_CreateThread(socket_producer, "socket producer", &bench);
+        for (int received = 0; producer && frame && received < paths; received++) {
+            if (!recv_blocking(pair[0], frame, 8))
+                break;
+            int length = (int)net_get_u32(frame + 4);
+            if (length < 0 || length > cells || !recv_blocking(pair[0], frame + 8, (size_t)length * 4))
+                break;
+            for (int i = 0; i < length; i++) {
+                points[i].x = (int)net_get_u16(frame + 8 + i * 4);
+                points[i].y = (int)net_get_u16(frame + 10 + i * 4);
+            }
+            const BenchQuery* query = &queries[received % BENCH_QUERIES];
+            if (length != query->length || bench_checksum(points, length) != query->checksum)
+                checksum_errors++;
+        }
+        SDL_WaitThread(producer, NULL);
+        t1 = SDL_GetPerformanceCounter();
+        socket_us = (double)(t1 - t0) * 1e6 / freq / paths;
+        free(frame);
+        net_close(pair[0]);
+        net_close(pair[1]);
+        net_shutdown();
+    }
+
+    printf("  %-22s %10s %12s %14s\n", "Producer to consumer", "us/path", "paths/s", "over search");
+    printf("  %-22s %10.2f %12.0f %14s\n", "Search only", search_us, 1e6 / search_us, "-");
+    printf("  %-22s %10.2f %12.0f %14.2f\n", "Shared-memory ring", ring_us, 1e6 / ring_us, ring_us - search_us);
+    if (socket_us > 0.0)
+        printf("  %-22s %10.2f %12.0f %14.2f\n", "Local socket", socket_us, 1e6 / socket_us, socket_us - search_us);
+    printf("  %lld checksum errors\n", checksum_errors);
+
+    shm_ring_close(consumer);
+    shm_ring_close(bench.ring);
+    grid_search_free(bench.search);
+    gridmap_free(map);
+    free(points);
+    return checksum_errors ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "grid_map.h"
+
+// Single-producer / multi-consumer ring of path results in named shared
+// memory (shm_open, or a pagefile-backed file mapping on Windows), for
+// consumers on the same machine that should not pay for a socket.
+//
+// The producer's search writes each path straight into a slot through a
+// PathBuffer, and consumers read the points in place. Every slot carries a
+// sequence number that works as a seqlock: consumers never block the
+// producer, and a consumer that falls a full ring behind sees SHM_RING_OVERRUN
+// instead of torn data. A consumer must check shm_ring_still_valid() after
+// using a view, because the slot may have been overwritten while it read.
+typedef struct ShmRing ShmRing;
+
+typedef enum {
+    SHM_RING_EMPTY,   // Nothing new yet
+    SHM_RING_OK,
+    SHM_RING_OVERRUN, // The producer lapped this consumer; the cursor was moved to the oldest kept path
+} ShmRingStatus;
+
+// A published path, pointing into shared memory
+typedef struct {
+    uint32_t sequence; // 1 for the first path ever published
+    uint32_t tag;      // Caller-defined, e.g. a request id
+    int cost;
+    int length;
+    const Point* points;
+} ShmPathView;
+
+// Producer side: creates (or replaces) the region. max_points bounds every path.
+ShmRing* shm_ring_create(const char* name, int slot_count, int max_points);
+// Consumer side
+ShmRing* shm_ring_open(const char* name);
+// The creator also removes the name.
+void shm_ring_close(ShmRing* ring);
+
+int shm_ring_slot_count(const ShmRing* ring);
+
+// Next slot as a PathBuffer for the search to write into; publish it with shm_ring_commit().
+PathBuffer shm_ring_begin_write(ShmRing* ring);
+void shm_ring_commit(ShmRing* ring, const PathBuffer* path, uint32_t tag);
+
+// Cursor to pass to shm_ring_read(): the next path published after this call.
+uint32_t shm_ring_cursor(const ShmRing* ring);
+// On SHM_RING_OK, view describes path *cursor and the cursor is advanced.
+ShmRingStatus shm_ring_read(const ShmRing* ring, uint32_t* cursor, ShmPathView* view);
+bool shm_ring_still_valid(const ShmRing* ring, const ShmPathView* view);
+
+// --bench-shm-ring [side] [paths]: A* results on a random side x side map
+// delivered through the ring vs a local socket, end to end
+int shm_ring_run_benchmark_tool(int points, int paths);
+
+#endif // SHM_RING_H
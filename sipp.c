@@ -0,0 +1,411 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sipp.h"
+#include "mem_track.h"
+#include "min_heap.h"
+
+typedef struct {
+    int start;
+    int end; // Inclusive, SIPP_FOREVER if open for good
+} SafeInterval;
+
+struct SippMap {
+    int width;
+    int height;
+    int* first;              // cells + 1 entries: intervals of cell i are [first[i], first[i + 1])
+    SafeInterval* intervals; // Ascending within a cell; none for walls
+    int* interval_cell;      // Cell of each interval
+    int interval_count;
+};
+
+static int compare_blocks(const void* a, const void* b) {
+    const SippBlock* x = a;
+    const SippBlock* y = b;
+    if (x->cell.y != y->cell.y)
+        return x->cell.y < y->cell.y ? -1 : 1;
+    if (x->cell.x != y->cell.x)
+        return x->cell.x < y->cell.x ? -1 : 1;
+    return (x->from > y->from) - (x->from < y->from);
+}
+
+SippMap* sipp_create(const GridMap* map, const SippBlock* blocks, int count) {
+    int cells = map->width * map->height;
+    SippMap* sipp = mem_calloc(1, sizeof(SippMap));
+    SippBlock* sorted = mem_alloc(sizeof(SippBlock) * (count > 0 ? count : 1));
+    if (!sipp || !sorted) {
+        mem_free(sipp);
+        mem_free(sorted);
+        return NULL;
+    }
+    sipp->width = map->width;
+    sipp->height = map->height;
+
+    // Row-major order, then by start, so each cell's blocks are one run
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        const SippBlock* b = &blocks[i];
+        if (b->cell.x >= 0 && b->cell.x < map->width && b->cell.y >= 0 && b->cell.y < map->height && b->from <= b->to)
+            sorted[kept++] = *b;
+    }
+    qsort(sorted, kept, sizeof(SippBlock), compare_blocks);
+
+    // Each block splits at most one interval in two, so this is enough
+    sipp->first = mem_alloc(sizeof(int) * (cells + 1));
+    sipp->intervals = mem_alloc(sizeof(SafeInterval) * (cells + kept));
+    sipp->interval_cell = mem_alloc(sizeof(int) * (cells + kept));
+    if (!sipp->first || !sipp->intervals || !sipp->interval_cell) {
+        mem_free(sorted);
+        sipp_free(sipp);
+        return NULL;
+    }
+
+    int n = 0;
+    int b = 0;
+    for (int cell = 0; cell < cells; cell++) {
+        sipp->first[cell] = n;
+        int x = cell % map->width, y = cell / map->width;
+        bool wall = gridmap_is_wall(map, cell);
+        // The complement of the cell's (possibly overlapping) blocks
+        int open_from = 0;
+        for (; b < kept && sorted[b].cell.x == x && sorted[b].cell.y == y; b++) {
+            if (wall || open_from == SIPP_FOREVER)
+                continue;
+            if (sorted[b].from > open_from) {
+                sipp->intervals[n] = (SafeInterval){ open_from, sorted[b].from - 1 };
+                sipp->interval_cell[n++] = cell;
+            }
+            if (sorted[b].to == SIPP_FOREVER)
+                open_from = SIPP_FOREVER;
+            else if (sorted[b].to + 1 > open_from)
+                open_from = sorted[b].to + 1;
+        }
+        if (!wall && open_from != SIPP_FOREVER) {
+            sipp->intervals[n] = (SafeInterval){ open_from, SIPP_FOREVER };
+            sipp->interval_cell[n++] = cell;
+        }
+    }
+    sipp->first[cells] = n;
+    sipp->interval_count = n;
+    mem_free(sorted);
+    return sipp;
+}
+
+void sipp_free(SippMap* sipp) {
+    if (!sipp)
+        return;
+    mem_free(sipp->first);
+    mem_free(sipp->intervals);
+    mem_free(sipp->interval_cell);
+    mem_free(sipp);
+}
+
+int sipp_interval_count(const SippMap* sipp) {
+    return sipp->interval_count;
+}
+
+// Interval of cell containing time, -1 if the cell is closed then
+static int interval_at(const SippMap* sipp, int cell, int time) {
+    int lo = sipp->first[cell], hi = sipp->first[cell + 1];
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (sipp->intervals[mid].end < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < sipp->first[cell + 1] && sipp->intervals[lo].start <= time ? lo : -1;
+}
+
+bool sipp_cell_free(const SippMap* sipp, Point cell, int time) {
+    if (cell.x < 0 || cell.x >= sipp->width || cell.y < 0 || cell.y >= sipp->height)
+        return false;
+    return interval_at(sipp, cell.y * sipp->width + cell.x, time) >= 0;
+}
+
+bool sipp_find_path(const SippMap* sipp, Point from, Point to, int depart, SippPath* out, SearchStats* stats) {
+    SearchStats local;
+    if (!stats)
+        stats = &local;
+    stats->expanded = stats->pushed = 0;
+    out->length = 0;
+    out->arrival = -1;
+    out->waits = 0;
+
+    int width = sipp->width;
+    if (from.x < 0 || from.x >= width || from.y < 0 || from.y >= sipp->height ||
+        to.x < 0 || to.x >= width || to.y < 0 || to.y >= sipp->height)
+        return false;
+    int source = interval_at(sipp, from.y * width + from.x, depart);
+    if (source < 0)
+        return false; // Closed at departure
+    int target = to.y * width + to.x;
+
+    // Earliest arrival in each safe interval and the interval it came from
+    int* arrival = mem_alloc(sizeof(int) * sipp->interval_count);
+    int* parent = mem_alloc(sizeof(int) * sipp->interval_count);
+    MinHeap heap;
+    heap_init(&heap, 256);
+    int found = -1;
+    if (arrival && parent && heap.items) {
+        for (int i = 0; i < sipp->interval_count; i++)
+            arrival[i] = INT_MAX;
+#define SIPP_HEURISTIC(cell) (abs((cell) % width - to.x) + abs((cell) / width - to.y))
+        arrival[source] = depart;
+        parent[source] = -1;
+        heap_push(&heap, depart + SIPP_HEURISTIC(from.y * width + from.x), source);
+        stats->pushed++;
+
+        while (!heap_empty(&heap)) {
+            HeapItem item = heap_pop(&heap);
+            int state = item.value;
+            int cell = sipp->interval_cell[state];
+            int time = item.key - SIPP_HEURISTIC(cell);
+            if (time > arrival[state])
+                continue; // Stale entry
+
+            stats->expanded++;
+            if (cell == target) {
+                found = state;
+                break;
+            }
+
+            // Wait here at most until the interval closes, then step over
+            int last_leave = sipp->intervals[state].end;
+            int x = cell % width, y = cell / width;
+            for (int d = 0; d < 4; d++) {
+                int nx = x + grid_dx[d], ny = y + grid_dy[d];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= sipp->height)
+                    continue;
+                int neighbor = ny * width + nx;
+                for (int j = sipp->first[neighbor]; j < sipp->first[neighbor + 1]; j++) {
+                    const SafeInterval* next = &sipp->intervals[j];
+                    if (next->start - 1 > last_leave)
+                        break; // Opens only after we must have left
+                    int t = time + 1 > next->start ? time + 1 : next->start;
+                    if (t > next->end || t - 1 > last_leave || t >= arrival[j])
+                        continue;
+                    arrival[j] = t;
+                    parent[j] = state;
+                    if (!heap_push(&heap, t + SIPP_HEURISTIC(neighbor), j))
+                        continue;
+                    stats->pushed++;
+                }
+            }
+        }
+#undef SIPP_HEURISTIC
+    }
+
+    bool ok = false;
+    if (found >= 0 && arrival[found] - depart + 1 <= out->capacity) {
+        // Back to front: the interval's cell at its arrival, preceded by the
+        // waits in the interval before it
+        int length = arrival[found] - depart + 1;
+        int moves = 0;
+        int i = length - 1;
+        for (int state = found; state >= 0; state = parent[state]) {
+            int cell = sipp->interval_cell[state];
+            int leave = state == found ? arrival[state] : out->points[i + 1].time - 1;
+            for (int t = leave; t >= arrival[state]; t--, i--)
+                out->points[i] = (TimedPoint){ { cell % width, cell / width }, t };
+            if (parent[state] >= 0)
+                moves++;
+        }
+        out->length = length;
+        out->arrival = arrival[found];
+        out->waits = length - 1 - moves;
+        ok = true;
+    }
+    heap_free(&heap);
+    mem_free(arrival);
+    mem_free(parent);
+    return ok;
+}
+
+SippBlock* sipp_random_doors(const GridMap* map, int door_percent, int horizon, unsigned int seed, int* count) {
+    *count = 0;
+    int cells = map->width * map->height;
+    uint32_t state = seed ? seed : 0x9E3779B9u;
+#define SIPP_RANDOM() (state ^= state << 13, state ^= state >> 17, state ^= state << 5, state)
+
+    // Count first so the blocks are one allocation
+    size_t total = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        SippBlock* blocks = NULL;
+        if (pass == 1) {
+            if (total == 0 || total > INT_MAX)
+                return NULL;
+            blocks = mem_alloc(sizeof(SippBlock) * total);
+            if (!blocks)
+                return NULL;
+        }
+        uint32_t saved = state;
+        int n = 0;
+        for (int cell = 0; cell < cells; cell++) {
+            if (gridmap_is_wall(map, cell) || (int)(SIPP_RANDOM() % 100) >= door_percent)
+                continue;
+            int period = 6 + (int)(SIPP_RANDOM() % 11);
+            int closed = 2 + (int)(SIPP_RANDOM() % (period / 2 - 1));
+            int phase = (int)(SIPP_RANDOM() % period);
+            for (int t = phase; t <= horizon; t += period) {
+                if (pass == 1)
+                    blocks[n] = (SippBlock){ { cell % map->width, cell / map->width }, t, t + closed - 1 };
+                n++;
+            }
+        }
+        if (pass == 0) {
+            total = n;
+            state = saved; // Replay the same doors
+        }
+        else {
+            *count = n;
+            return blocks;
+        }
+    }
+#undef SIPP_RANDOM
+    return NULL;
+}
+
+// The baseline: A* over (cell, step) pairs up to horizon, one state per cell
+// and step whether or not anything changes there
+static int space_time_arrival(const SippMap* sipp, Point from, Point to, int depart, int horizon,
+    uint8_t* seen, MinHeap* heap, SearchStats* stats) {
+    int width = sipp->width, cells = sipp->width * sipp->height;
+    int steps = horizon - depart + 1;
+    memset(seen, 0, ((size_t)cells * steps + 7) / 8);
+    heap_clear(heap);
+    stats->expanded = stats->pushed = 0;
+    if (!sipp_cell_free(sipp, from, depart))
+        return -1;
+
+    int target = to.y * width + to.x;
+#define SPACE_TIME_HEURISTIC(cell) (abs((cell) % width - to.x) + abs((cell) / width - to.y))
+    // The key is the step plus the heuristic; values pack cell and step
+    int source = from.y * width + from.x;
+    seen[(size_t)source / 8] |= 1 << (source % 8);
+    heap_push(heap, depart + SPACE_TIME_HEURISTIC(source), source);
+    stats->pushed++;
+    while (!heap_empty(heap)) {
+        HeapItem item = heap_pop(heap);
+        int cell = item.value % cells;
+        int time = depart + item.value / cells;
+        stats->expanded++;
+        if (cell == target)
+            return time;
+        if (time == horizon)
+            continue;
+
+        int x = cell % width, y = cell / width;
+        for (int d = -1; d < 4; d++) { // -1 waits in place
+            int nx = d < 0 ? x : x + grid_dx[d], ny = d < 0 ? y : y + grid_dy[d];
+            if (!sipp_cell_free(sipp, (Point){ nx, ny }, time + 1))
+                continue;
+            size_t state = (size_t)(time + 1 - depart) * cells + ny * width + nx;
+            if (seen[state / 8] & (1 << (state % 8)))
+                continue;
+            seen[state / 8] |= 1 << (state % 8);
+            heap_push(heap, time + 1 + SPACE_TIME_HEURISTIC(ny * width + nx), (int)state);
+            stats->pushed++;
+        }
+    }
+#undef SPACE_TIME_HEURISTIC
+    return -1;
+}
+
+int sipp_run_benchmark_tool(const char* map_path, int door_percent, int queries) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (door_percent <= 0)
+        door_percent = 10;
+    if (queries <= 0)
+        queries = 100;
+
+    int cells = map->width * map->height;
+    int schedule = 4 * (map->width + map->height); // Doors cycle until then
+    int horizon = schedule + 2 * (map->width + map->height);
+    if ((double)cells * (horizon + 1) > INT_MAX) {
+        fprintf(stderr, "%s is too large for the space-time baseline.\n", map_path);
+        gridmap_free(map);
+        return 1;
+    }
+
+    int block_count = 0;
+    SippBlock* blocks = sipp_random_doors(map, door_percent, schedule, 4242, &block_count);
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    SippMap* sipp = sipp_create(map, blocks, block_count);
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    uint8_t* seen = malloc(((size_t)cells * (horizon + 1) + 7) / 8);
+    SippPath path = { malloc(sizeof(TimedPoint) * (horizon + 1)), horizon + 1, 0, -1, 0 };
+    MinHeap heap;
+    heap_init(&heap, 1024);
+    if (!sipp || !seen || !path.points || !heap.items) {
+        fprintf(stderr, "Out of memory.\n");
+        sipp_free(sipp);
+        mem_free(blocks);
+        free(seen);
+        free(path.points);
+        heap_free(&heap);
+        gridmap_free(map);
+        return 1;
+    }
+
+    double freq = (double)SDL_GetPerformanceFrequency();
+    printf("Map %s: %dx%d, %d%% doors (%d closed windows), %d safe intervals, built in %.2f ms\n",
+        map_path, map->width, map->height, door_percent, block_count, sipp_interval_count(sipp),
+        (double)(t1 - t0) * 1000.0 / freq);
+    printf("  Space-time grid: %d steps x %d cells = %.1f M states\n", horizon, cells, (double)horizon * cells / 1e6);
+
+    long long expanded[2] = { 0, 0 };
+    Uint64 ticks[2] = { 0, 0 };
+    long long waits = 0;
+    int done = 0, mismatches = 0, unreachable = 0;
+    uint32_t state = 99;
+    for (int attempt = 0; attempt < queries * 100 && done < queries; attempt++) {
+        state = state * 1664525u + 1013904223u;
+        Point a = { (int)((state >> 8) % map->width), (int)((state >> 16) % map->height) };
+        state = state * 1664525u + 1013904223u;
+        Point b = { (int)((state >> 8) % map->width), (int)((state >> 16) % map->height) };
+        if (!sipp_cell_free(sipp, a, 0) || !gridmap_walkable(map, b.x, b.y))
+            continue;
+
+        SearchStats stats;
+        Uint64 q0 = SDL_GetPerformanceCounter();
+        sipp_find_path(sipp, a, b, 0, &path, &stats);
+        Uint64 q1 = SDL_GetPerformanceCounter();
+        ticks[0] += q1 - q0;
+        expanded[0] += stats.expanded;
+        int baseline = space_time_arrival(sipp, a, b, 0, horizon, seen, &heap, &stats);
+        ticks[1] += SDL_GetPerformanceCounter() - q1;
+        expanded[1] += stats.expanded;
+
+        // Beyond the horizon only SIPP can answer
+        if (path.arrival < 0 || path.arrival > horizon) {
+            unreachable += path.arrival < 0;
+            mismatches += baseline >= 0;
+        }
+        else if (baseline != path.arrival) {
+            mismatches++;
+        }
+        waits += path.waits;
+        done++;
+    }
+
+    if (done > 0) {
+        printf("  %-16s %14s %10s\n", "Engine", "Expanded/query", "us/query");
+        printf("  %-16s %14.0f %10.1f\n", "SIPP", (double)expanded[0] / done, ticks[0] * 1e6 / freq / done);
+        printf("  %-16s %14.0f %10.1f\n", "Space-time A*", (double)expanded[1] / done, ticks[1] * 1e6 / freq / done);
+        printf("  SIPP is %.1fx faster; %.1f waits per path, %d unreachable, %d arrival mismatches (%d queries)\n",
+            ticks[0] ? (double)ticks[1] / ticks[0] : 0.0, (double)waits / done, unreachable, mismatches, done);
+    }
+
+    heap_free(&heap);
+    free(seen);
+    free(path.points);
+    sipp_free(sipp);
+    mem_free(blocks);
+    gridmap_free(map);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+#ifndef SIPP_H
+#define SIPP_H
+
+#include <limits.h>
+
+#include "grid_search.h"
+
+#define SIPP_FOREVER INT_MAX
+
+// Time-dependent search over cells that are closed at known times (doors on
+// a schedule). Time is counted in steps; a move takes one step and the agent
+// may wait in a cell. Safe Interval Path Planning keeps one search state per
+// maximal interval a cell is open instead of one per cell and time step, so
+// the state count does not grow with the length of the schedule.
+
+// A cell closed from step from to step to, both inclusive
+typedef struct {
+    Point cell;
+    int from;
+    int to; // SIPP_FOREVER for a cell that never opens again
+} SippBlock;
+
+typedef struct {
+    Point point;
+    int time;
+} TimedPoint;
+
+// Caller-owned output: the agent's cell at every step from departure to arrival
+typedef struct {
+    TimedPoint* points;
+    int capacity;
+    int length;
+    int arrival; // -1 if no path was found
+    int waits;   // Steps spent standing still
+} SippPath;
+
+// Safe intervals of every cell of a map
+typedef struct SippMap SippMap;
+
+SippMap* sipp_create(const GridMap* map, const SippBlock* blocks, int count);
+void sipp_free(SippMap* sipp);
+
+// Whether the cell is open (walkable and not blocked) at step time
+bool sipp_cell_free(const SippMap* sipp, Point cell, int time);
+// Number of safe intervals, i.e. search states
+int sipp_interval_count(const SippMap* sipp);
+
+/**
+ * @brief Earliest arrival at to when leaving from at step depart. The agent
+ * leaves the map on arrival, so to only has to be open at that step.
+ * @return true if a path was written to out (out->arrival is -1 otherwise).
+ */
+bool sipp_find_path(const SippMap* sipp, Point from, Point to, int depart, SippPath* out, SearchStats* stats);
+
+/**
+ * @brief Turns door_percent of the walkable cells into doors that open and
+ * close periodically (random period and phase) until step horizon.
+ * @return Blocks sorted by cell (free with mem_free()), count in *count; NULL if none.
+ */
+SippBlock* sipp_random_doors(const GridMap* map, int door_percent, int horizon, unsigned int seed, int* count);
+
+// --bench-sipp tool: SIPP against A* on the naive space-time grid with random doors
+int sipp_run_benchmark_tool(const char* map_path, int door_percent, int queries);
+
+#endif // SIPP_H
@@ -0,0 +1,442 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "speculative_paths.h"
+#include "mem_track.h"
+
+#define SPEC_MAX_THREADS 16
+// Predictions the rounds cannot supply come from A* with the Manhattan
+// distance times this: far fewer expansions, paths mostly along the same corridors
+#define PREDICTION_WEIGHT 2
+
+typedef struct {
+    SpeculativeSearch* owner;
+    int index;
+    GridSearch* search;
+    BlockOverlay* overlay; // Committed paths plus the predictions before this slot
+    SearchStatus status;
+} SpecSlot;
+
+// A predicted path in SpeculativeSearch.prediction_points
+typedef struct {
+    int offset;
+    int length;
+} Prediction;
+
+struct SpeculativeSearch {
+    const GridMap* map;
+    int slot_count;
+    SpecSlot slots[SPEC_MAX_THREADS];
+    SDL_Thread* threads[SPEC_MAX_THREADS]; // Slot 0 runs on the calling thread
+
+    SDL_Mutex* lock;
+    SDL_Condition* work_ready;
+    SDL_Condition* work_done;
+    int generation; // Bumped for every round
+    int active;     // Slots in the current round
+    int pending;    // Of those, still running on workers
+    bool quit;
+
+    Point from, to;
+    SearchOptions options;
+    BlockOverlay* committed; // Inner cells of the paths found so far
+    BlockOverlay* actual;    // Validation: paths committed this round,
+    BlockOverlay* guessed;   // and the predictions the slots assumed for them
+    Prediction predictions[SPEC_MAX_THREADS];
+    int prediction_count;
+    Point* prediction_points;
+    int prediction_capacity;
+};
+
+static void run_slot(SpeculativeSearch* spec, SpecSlot* slot) {
+    SearchOptions options = spec->options;
+    options.overlay = slot->overlay;
+    grid_search_begin(slot->search, spec->from, spec->to, &options);
+    slot->status = grid_search_step(slot->search, 0, 0.0);
+}
+
+static int worker_main(void* data) {
+    SpecSlot* slot = data;
+    SpeculativeSearch* spec = slot->owner;
+    int seen = 0;
+    SDL_LockMutex(spec->lock);
+    for (;;) {
+        while (!spec->quit && spec->generation == seen)
+            SDL_WaitCondition(spec->work_ready, spec->lock);
+        if (spec->quit)
+            break;
+        seen = spec->generation;
+        if (slot->index >= spec->active)
+            continue;
+        SDL_UnlockMutex(spec->lock);
+        run_slot(spec, slot);
+        SDL_LockMutex(spec->lock);
+        if (--spec->pending == 0)
+            SDL_SignalCondition(spec->work_done);
+    }
+    SDL_UnlockMutex(spec->lock);
+    return 0;
+}
+
+// Runs slots [0, active) at once and waits for all of them
+static void run_round(SpeculativeSearch* spec, int active) {
+    SDL_LockMutex(spec->lock);
+    spec->active = active;
+    spec->pending = active - 1;
+    spec->generation++;
+    SDL_BroadcastCondition(spec->work_ready);
+    SDL_UnlockMutex(spec->lock);
+
+    run_slot(spec, &spec->slots[0]);
+
+    SDL_LockMutex(spec->lock);
+    while (spec->pending > 0)
+        SDL_WaitCondition(spec->work_done, spec->lock);
+    SDL_UnlockMutex(spec->lock);
+}
+
+SpeculativeSearch* speculative_create(const GridMap* map, int threads) {
+    if (threads <= 0)
+        threads = SDL_GetNumLogicalCPUCores();
+    threads = SDL_clamp(threads, 1, SPEC_MAX_THREADS);
+    SpeculativeSearch* spec = mem_calloc(1, sizeof(SpeculativeSearch));
+    if (!spec)
+        return NULL;
+    spec->map = map;
+    spec->lock = SDL_CreateMutex();
+    spec->work_ready = SDL_CreateCondition();
+    spec->work_done = SDL_CreateCondition();
+    spec->committed = block_overlay_create(map->width, map->height);
+    spec->actual = block_overlay_create(map->width, map->height);
+    spec->guessed = block_overlay_create(map->width, map->height);
+    if (!spec->lock || !spec->work_ready || !spec->work_done || !spec->committed || !spec->actual || !spec->guessed) {
+        speculative_free(spec);
+        return NULL;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        SpecSlot* slot = &spec->slots[i];
+        slot->owner = spec;
+        slot->index = i;
+        slot->search = grid_search_create(map);
+        slot->overlay = block_overlay_create(map->width, map->height);
+        if (!slot->search || !slot->overlay) {
+            grid_search_free(slot->search);
+            block_overlay_free(slot->overlay);
+            slot->search = NULL;
+            slot->overlay = NULL;
+            break;
+        }
+        if (i > 0) {
+            spec->threads[i] = SDL_CreateThread(worker_main, "speculative search", slot);
+            if (!spec->threads[i]) {
+                grid_search_free(slot->search);
+                block_overlay_free(slot->overlay);
+                slot->search = NULL;
+                slot->overlay = NULL;
+                break;
+            }
+        }
+        spec->slot_count = i + 1;
+    }
+    if (spec->slot_count == 0) {
+        speculative_free(spec);
+        return NULL;
+    }
+    return spec;
+}
+
+void speculative_free(SpeculativeSearch* spec) {
+    if (!spec)
+        return;
+    if (spec->lock) {
+        SDL_LockMutex(spec->lock);
+        spec->quit = true;
+        SDL_BroadcastCondition(spec->work_ready);
+        SDL_UnlockMutex(spec->lock);
+    }
+    for (int i = 0; i < spec->slot_count; i++) {
+        if (spec->threads[i])
+            SDL_WaitThread(spec->threads[i], NULL);
+        grid_search_free(spec->slots[i].search);
+        block_overlay_free(spec->slots[i].overlay);
+    }
+    block_overlay_free(spec->committed);
+    block_overlay_free(spec->actual);
+    block_overlay_free(spec->guessed);
+    mem_free(spec->prediction_points);
+    SDL_DestroyCondition(spec->work_ready);
+    SDL_DestroyCondition(spec->work_done);
+    SDL_DestroyMutex(spec->lock);
+    mem_free(spec);
+}
+
+int speculative_thread_count(const SpeculativeSearch* spec) {
+    return spec->slot_count;
+}
+
+static int inflated_manhattan(const void* context, int cell, int target) {
+    return PREDICTION_WEIGHT * grid_manhattan_heuristic(context, cell, target);
+}
+
+static void copy_cell(void* context, int x, int y) {
+    block_overlay_add(context, x, y);
+}
+
+// Appends the path of a finished search to the predictions
+static bool store_prediction(SpeculativeSearch* spec, const GridSearch* search) {
+    int offset = spec->prediction_count ?
+        spec->predictions[spec->prediction_count - 1].offset + spec->predictions[spec->prediction_count - 1].length : 0;
+    for (;;) {
+        PathBuffer path = { spec->prediction_points + offset, spec->prediction_capacity - offset, 0, -1 };
+        if (spec->prediction_points && grid_search_path(search, &path)) {
+            spec->predictions[spec->prediction_count++] = (Prediction){ offset, path.length };
+            return true;
+        }
+        if (grid_search_status(search) != SEARCH_FOUND)
+            return false;
+        int capacity = spec->prediction_capacity ? 2 * spec->prediction_capacity : 1024;
+        Point* points = mem_realloc(spec->prediction_points, sizeof(Point) * capacity);
+        if (!points)
+            return false;
+        spec->prediction_points = points;
+        spec->prediction_capacity = capacity;
+    }
+}
+
+static void add_prediction(const SpeculativeSearch* spec, int index, BlockOverlay* overlay) {
+    const Prediction* p = &spec->predictions[index];
+    block_overlay_add_path_inner(overlay, spec->prediction_points + p->offset, p->length);
+}
+
+// Tops up the predictions for the next steps, for as many slots as there
+// are, by running the loop on from them with a cheap inflated heuristic
+static void predict_ahead(SpeculativeSearch* spec, int steps_left, SpeculationStats* stats) {
+    int wanted = SDL_min(spec->slot_count, steps_left) - 1;
+    if (spec->prediction_count >= wanted)
+        return;
+    SpecSlot* slot = &spec->slots[0];
+    SearchOptions options = spec->options;
+    options.heuristic = inflated_manhattan;
+    options.heuristic_context = spec->map;
+    options.overlay = slot->overlay;
+    block_overlay_clear(slot->overlay);
+    block_overlay_visit(spec->committed, copy_cell, slot->overlay);
+    for (int j = 0; j < spec->prediction_count; j++)
+        add_prediction(spec, j, slot->overlay);
+    while (spec->prediction_count < wanted) {
+        grid_search_begin(slot->search, spec->from, spec->to, &options);
+        grid_search_step(slot->search, 0, 0.0);
+        stats->predictions++;
+        if (!store_prediction(spec, slot->search))
+            break;
+        add_prediction(spec, spec->prediction_count - 1, slot->overlay);
+    }
+}
+
+typedef struct {
+    const GridSearch* search;
+    const BlockOverlay* other;     // A cell in here is in both sets
+    const BlockOverlay* committed; // Optional, likewise
+    bool conflict;
+} ConflictCheck;
+
+static void check_cell(void* context, int x, int y) {
+    ConflictCheck* check = context;
+    if (check->conflict || block_overlay_test(check->other, x, y) ||
+        (check->committed && block_overlay_test(check->committed, x, y)))
+        return;
+    // Blocked in one set only: the search must never have looked at it, so
+    // no neighbour may have been expanded
+    for (int d = 0; d < 4; d++) {
+        if (grid_search_expanded(check->search, x + grid_dx[d], y + grid_dy[d])) {
+            check->conflict = true;
+            return;
+        }
+    }
+}
+
+// Whether a speculative search made the same moves it would have made under
+// the real paths: actual and guessed hold what differs between the two sets
+static bool speculation_holds(const SpeculativeSearch* spec, const GridSearch* search) {
+    ConflictCheck check = { search, spec->guessed, NULL, false };
+    block_overlay_visit(spec->actual, check_cell, &check);
+    if (check.conflict)
+        return false;
+    // Guessed cells that were committed in an earlier round are in both sets
+    check.other = spec->actual;
+    check.committed = spec->committed;
+    block_overlay_visit(spec->guessed, check_cell, &check);
+    return !check.conflict;
+}
+
+int speculative_disjoint_paths(SpeculativeSearch* spec, Point from, Point to, int k, const SearchOptions* options,
+    Point* points, int capacity, PathBuffer* paths, SpeculationStats* stats) {
+    SpeculationStats local;
+    memset(&local, 0, sizeof(local));
+    spec->from = from;
+    spec->to = to;
+    spec->options = options ? *options : (SearchOptions){ NULL, NULL, NULL, NULL, NULL };
+    spec->options.overlay = NULL;
+    block_overlay_clear(spec->committed);
+    spec->prediction_count = 0;
+
+    int found = 0;
+    int used = 0;
+    bool done = false;
+    while (!done && found < k) {
+        predict_ahead(spec, k - found, &local);
+        // Slot s assumes the predictions for the s steps before its own
+        int active = SDL_min(SDL_min(spec->slot_count, k - found), spec->prediction_count + 1);
+        for (int s = 0; s < active; s++) {
+            BlockOverlay* overlay = spec->slots[s].overlay;
+            block_overlay_clear(overlay);
+            block_overlay_visit(spec->committed, copy_cell, overlay);
+            for (int j = 0; j < s; j++)
+                add_prediction(spec, j, overlay);
+        }
+        run_round(spec, active);
+        local.rounds++;
+        local.searches += active;
+        local.speculated += active - 1;
+
+        // Commit in order while the speculation holds
+        block_overlay_clear(spec->actual);
+        block_overlay_clear(spec->guessed);
+        int s = 0;
+        while (s < active && !done) {
+            SpecSlot* slot = &spec->slots[s];
+            if (s > 0) {
+                if (!speculation_holds(spec, slot->search))
+                    break;
+                local.accepted++;
+            }
+            PathBuffer* path = &paths[found];
+            path->points = points + used;
+            path->capacity = capacity - used;
+            if (slot->status != SEARCH_FOUND || !grid_search_path(slot->search, path)) {
+                done = true; // The sequential loop ends here too
+                s++;
+                break;
+            }
+            used += path->length;
+            found++;
+            block_overlay_add_path_inner(spec->committed, path->points, path->length);
+            block_overlay_add_path_inner(spec->actual, path->points, path->length);
+            if (s < spec->prediction_count)
+                add_prediction(spec, s, spec->guessed);
+            done = found == k;
+            s++;
+        }
+
+        // The results that were not kept predict the next round
+        spec->prediction_count = 0;
+        for (; !done && s < active; s++) {
+            if (spec->slots[s].status != SEARCH_FOUND || !store_prediction(spec, spec->slots[s].search))
+                break;
+        }
+    }
+    if (stats)
+        *stats = local;
+    return found;
+}
+
+static uint32_t next_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+int speculative_run_benchmark_tool(const char* map_path, int threads, int queries) {
+    GridMap* map = gridmap_load(map_path);
+    if (!map)
+        return 1;
+    if (queries <= 0)
+        queries = 50;
+
+    int cells = map->width * map->height;
+    int capacity = cells + 2 * K_PATHS;
+    SpeculativeSearch* spec = speculative_create(map, threads);
+    GridSearch* search = grid_search_create(map);
+    BlockOverlay* overlay = block_overlay_create(map->width, map->height);
+    Point* points = malloc(sizeof(Point) * capacity);
+    Point* spec_points = malloc(sizeof(Point) * capacity);
+    if (!spec || !search || !overlay || !points || !spec_points) {
+        fprintf(stderr, "Out of memory.\n");
+        speculative_free(spec);
+        grid_search_free(search);
+        block_overlay_free(overlay);
+        free(points);
+        free(spec_points);
+        gridmap_free(map);
+        return 1;
+    }
+
+    SearchOptions options = { NULL, grid_manhattan_heuristic, map, NULL, NULL };
+    SpeculationStats totals;
+    memset(&totals, 0, sizeof(totals));
+    Uint64 sequential_ticks = 0, speculative_ticks = 0;
+    int done = 0, mismatches = 0;
+    long long path_count = 0, sequential_searches = 0;
+    uint32_t state = 1234567u;
+    for (int attempt = 0; attempt < queries * 1000 && done < queries; attempt++) {
+        Point from = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+        Point to = { (int)(next_random(&state) % map->width), (int)(next_random(&state) % map->height) };
+        if (!gridmap_walkable(map, from.x, from.y) || !gridmap_walkable(map, to.x, to.y) ||
+            (from.x == to.x && from.y == to.y))
+            continue;
+        done++;
+
+        PathBuffer sequential[K_PATHS], speculative[K_PATHS];
+        SpeculationStats stats;
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        int found = grid_disjoint_paths(search, from, to, K_PATHS, &options, overlay, points, capacity, sequential);
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        int spec_found = speculative_disjoint_paths(spec, from, to, K_PATHS, &options, spec_points, capacity, speculative, &stats);
+        Uint64 t2 = SDL_GetPerformanceCounter();
+        sequential_ticks += t1 - t0;
+        speculative_ticks += t2 - t1;
+        path_count += found;
+        sequential_searches += found + (found < K_PATHS); // The last one finds nothing
+        totals.rounds += stats.rounds;
+        totals.searches += stats.searches;
+        totals.speculated += stats.speculated;
+        totals.accepted += stats.accepted;
+        totals.predictions += stats.predictions;
+
+        bool same = found == spec_found;
+        for (int i = 0; same && i < found; i++) {
+            same = sequential[i].length == speculative[i].length &&
+                memcmp(sequential[i].points, speculative[i].points, sizeof(Point) * sequential[i].length) == 0;
+        }
+        if (!same)
+            mismatches++;
+    }
+
+    double ms = 1000.0 / SDL_GetPerformanceFrequency();
+    printf("%s: %dx%d, %d K-loops with K = %d on %d threads (%lld paths)\n", map_path, map->width, map->height,
+        done, K_PATHS, speculative_thread_count(spec), path_count);
+    printf("  Sequential:  %.3f ms per loop\n", done ? sequential_ticks * ms / done : 0.0);
+    printf("  Speculative: %.3f ms per loop (%.2fx)\n", done ? speculative_ticks * ms / done : 0.0,
+        speculative_ticks ? (double)sequential_ticks / speculative_ticks : 0.0);
+    // Rounds are the critical path: what the loop takes with a core per thread
+    printf("  %.2f rounds per loop against %.2f sequential searches\n",
+        done ? (double)totals.rounds / done : 0.0, done ? (double)sequential_searches / done : 0.0);
+    printf("  %d exact searches of which %d speculative, %d cheap predictions\n",
+        totals.searches, totals.speculated, totals.predictions);
+    printf("  Hit rate: %d of %d speculative paths kept (%.1f%%)\n", totals.accepted, totals.speculated,
+        totals.speculated ? 100.0 * totals.accepted / totals.speculated : 0.0);
+    if (mismatches)
+        printf("  %d loops differ from the sequential one!\n", mismatches);
+
+    speculative_free(spec);
+    grid_search_free(search);
+    block_overlay_free(overlay);
+    free(points);
+    free(spec_points);
+    gridmap_free(map);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+#ifndef SPECULATIVE_PATHS_H
+#define SPECULATIVE_PATHS_H
+
+#include "grid_search.h"
+
+// The greedy K-loop on several threads. Path i + 1 depends on the cells of
+// paths 1..i, so the loop is run in rounds: in each, thread j searches path
+// found + j + 1 under the paths committed so far plus *predicted* paths for
+// the j steps in between. A speculative result is kept only if its search
+// never reached a cell where the prediction and the real paths differ; then
+// it made exactly the moves the sequential search would have made, so the
+// paths are identical to grid_disjoint_paths(). Rejected results become the
+// predictions of the next round; missing ones come from running the loop
+// ahead with a cheap inflated-heuristic search.
+//
+// Experimental: only --bench-speculative uses it, and no wall-clock speedup
+// has been measured yet (the machine it was written on has one core). The
+// visualizer and the query server keep the serial grid_disjoint_paths().
+typedef struct SpeculativeSearch SpeculativeSearch;
+
+typedef struct {
+    int rounds;
+    int searches;    // Exact searches run, on all threads
+    int speculated;  // Of those, run under a predicted blocking set
+    int accepted;    // Speculative results kept
+    int predictions; // Cheap searches run to predict paths
+} SpeculationStats;
+
+// threads <= 0 means one per core. The map must stay unchanged while in use.
+SpeculativeSearch* speculative_create(const GridMap* map, int threads);
+void speculative_free(SpeculativeSearch* spec);
+int speculative_thread_count(const SpeculativeSearch* spec);
+
+/**
+ * @brief grid_disjoint_paths() with speculation. Same arguments and results,
+ * without the caller's overlay: the object has its own.
+ * @param stats Optional, receives the counters of this call.
+ */
+int speculative_disjoint_paths(SpeculativeSearch* spec, Point from, Point to, int k, const SearchOptions* options,
+    Point* points, int capacity, PathBuffer* paths, SpeculationStats* stats);
+
+// --bench-speculative tool: sequential K-loop against the speculative one on
+// a map file; prints the hit rate and speedup and checks the paths match.
+int speculative_run_benchmark_tool(const char* map_path, int threads, int queries);
+
+#endif // SPECULATIVE_PATHS_H
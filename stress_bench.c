@@ -0,0 +1,192 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stress_bench.h"
+#include "grid_search.h"
+#include "path_runs.h"
+
+#define STRESS_MAX_K 64
+
+static const int k_columns[] = { 1, 2, 4, 8, 16, 32, 64 };
+#define K_COLUMN_COUNT ((int)(sizeof(k_columns) / sizeof(k_columns[0])))
+static const int densities[] = { 10, 25, 35 };
+#define DENSITY_COUNT ((int)(sizeof(densities) / sizeof(densities[0])))
+
+// Endpoint distance as a share of the largest Manhattan distance on the map
+typedef enum { DISTANCE_NEAR, DISTANCE_MID, DISTANCE_FAR, DISTANCE_COUNT } DistanceClass;
+static const char* const distance_names[DISTANCE_COUNT] = { "near", "mid", "far" };
+
+// Sums over the queries of one cell of the matrix, for each K column
+typedef struct {
+    double total_ms[K_COLUMN_COUNT];
+    double path_ms[K_COLUMN_COUNT]; // Spent on searches that found a path (with stamping)
+    double fail_ms[K_COLUMN_COUNT]; // Spent on the search that ended the loop early
+    long long paths[K_COLUMN_COUNT];
+    int queries;
+    int run_mismatches; // Paths whose runs from the search differ from path_runs_from_points
+} KLoopTotals;
+
+static uint32_t next_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Walkable endpoints whose Manhattan distance falls in the class's band
+static bool pick_endpoints(const GridMap* map, DistanceClass distance, uint32_t* state, Point* from, Point* to) {
+    int span = map->width + map->height - 2;
+    int lo = distance == DISTANCE_NEAR ? span / 16 : distance == DISTANCE_MID ? span * 3 / 8 : span * 3 / 4;
+    int hi = distance == DISTANCE_NEAR ? span / 8 : distance == DISTANCE_MID ? span / 2 : span;
+    for (int attempt = 0; attempt < 100000; attempt++) {
+        Point a = { (int)(next_random(state) % map->width), (int)(next_random(state) % map->height) };
+        Point b = { (int)(next_random(state) % map->width), (int)(next_random(state) % map->height) };
+        int d = abs(a.x - b.x) + abs(a.y - b.y);
+        if (d < lo || d > hi || !gridmap_walkable(map, a.x, a.y) || !gridmap_walkable(map, b.x, b.y))
+            continue;
+        *from = a;
+        *to = b;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief One K-loop with K = STRESS_MAX_K, timed per iteration. The first k
+ * paths of it are exactly what a loop with K = k finds, so every column of
+ * the table comes from this one run.
+ */
+static void run_kloop(GridSearch* search, const GridMap* map, Point from, Point to, BlockOverlay* overlay,
+    CellType* plane, Point* points, PathRun* runs, PathRun* expected, KLoopTotals* totals) {
+    int cells = map->width * map->height;
+    block_overlay_clear(overlay);
+    memset(plane, 0, sizeof(CellType) * cells);
+    SearchOptions options = { overlay, NULL, NULL, NULL, NULL };
+
+    double iteration_ms[STRESS_MAX_K];
+    double fail_ms = 0.0;
+    int found = 0;
+    double freq = (double)SDL_GetPerformanceFrequency();
+    while (found < STRESS_MAX_K) {
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        grid_search_begin(search, from, to, &options);
+        grid_search_step(search, 0, 0.0);
+        PathBuffer path = { points, cells, 0, -1 };
+        if (!grid_search_path(search, &path)) {
+            fail_ms = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / freq;
+            break;
+        }
+        // What record_path does: stamp the inner cells as runs and block them
+        int run_count = path.length > 2 ? grid_search_path_runs(search, 1, path.length - 2, runs, cells) : 0;
+        CellType type = (CellType)(CELL_PATH_1 + (found < K_PATHS ? found : K_PATHS - 1));
+        path_runs_stamp(runs, run_count, plane, map->width, type);
+        block_overlay_add_path_inner(overlay, path.points, path.length);
+        iteration_ms[found++] = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / freq;
+
+        // Untimed: the runs must be the ones the points give
+        int expected_count = path.length > 2 ? path_runs_from_points(path.points + 1, path.length - 2, expected, cells) : 0;
+        if (run_count != expected_count || memcmp(runs, expected, sizeof(PathRun) * (run_count > 0 ? run_count : 0)) != 0)
+            totals->run_mismatches++;
+    }
+
+    for (int c = 0; c < K_COLUMN_COUNT; c++) {
+        int k = k_columns[c];
+        int paths = found < k ? found : k;
+        double path_ms = 0.0;
+        for (int i = 0; i < paths; i++)
+            path_ms += iteration_ms[i];
+        double lost = found < k ? fail_ms : 0.0;
+        totals->total_ms[c] += path_ms + lost;
+        totals->path_ms[c] += path_ms;
+        totals->fail_ms[c] += lost;
+        totals->paths[c] += paths;
+    }
+    totals->queries++;
+}
+
+int stress_run_kloop_tool(int max_side, int queries) {
+    if (max_side <= 0)
+        max_side = 1024;
+    if (queries <= 0)
+        queries = 3;
+
+    printf("K-loop stress matrix: %d queries per cell, K up to %d\n", queries, STRESS_MAX_K);
+    printf("Columns per distance: total ms per loop | us per path found | ms lost on the failing search | paths\n");
+    printf("Start and end have at most 4 neighbours, so no loop finds more than 4 disjoint paths:\n");
+    printf("past that, a larger K only pays for the one search that fails.\n");
+    bool failed = false;
+    for (int side = 64; side <= max_side; side *= 4) {
+        int cells = side * side;
+        BlockOverlay* overlay = block_overlay_create(side, side);
+        CellType* plane = malloc(sizeof(CellType) * cells);
+        Point* points = malloc(sizeof(Point) * cells);
+        PathRun* runs = malloc(sizeof(PathRun) * cells);
+        PathRun* expected = malloc(sizeof(PathRun) * cells);
+        if (!overlay || !plane || !points || !runs || !expected) {
+            fprintf(stderr, "Out of memory for %dx%d.\n", side, side);
+            block_overlay_free(overlay);
+            free(plane);
+            free(points);
+            free(runs);
+            free(expected);
+            return 1;
+        }
+
+        for (int d = 0; d < DENSITY_COUNT; d++) {
+            GridMap* map = gridmap_create_random(side, side, densities[d], 7u * side + d);
+            GridSearch* search = map ? grid_search_create(map) : NULL;
+            if (!search) {
+                gridmap_free(map);
+                continue;
+            }
+
+            KLoopTotals totals[DISTANCE_COUNT];
+            memset(totals, 0, sizeof(totals));
+            uint32_t state = 2024u + side + d;
+            for (int dist = 0; dist < DISTANCE_COUNT; dist++) {
+                for (int q = 0; q < queries; q++) {
+                    Point from, to;
+                    if (pick_endpoints(map, (DistanceClass)dist, &state, &from, &to))
+                        run_kloop(search, map, from, to, overlay, plane, points, runs, expected, &totals[dist]);
+                }
+            }
+
+            printf("\n%dx%d, %d%% walls\n", side, side, densities[d]);
+            printf("  %3s", "K");
+            for (int dist = 0; dist < DISTANCE_COUNT; dist++)
+                printf(" | %-36s", distance_names[dist]);
+            printf("\n");
+            for (int c = 0; c < K_COLUMN_COUNT; c++) {
+                printf("  %3d", k_columns[c]);
+                for (int dist = 0; dist < DISTANCE_COUNT; dist++) {
+                    const KLoopTotals* t = &totals[dist];
+                    if (t->queries == 0) {
+                        printf(" | %-36s", "no endpoints");
+                        continue;
+                    }
+                    printf(" | %9.2f %9.1f %9.2f %5.1f", t->total_ms[c] / t->queries,
+                        t->paths[c] ? t->path_ms[c] * 1000.0 / t->paths[c] : 0.0,
+                        t->fail_ms[c] / t->queries, (double)t->paths[c] / t->queries);
+                }
+                printf("\n");
+            }
+            for (int dist = 0; dist < DISTANCE_COUNT; dist++) {
+                if (totals[dist].run_mismatches) {
+                    fprintf(stderr, "  %s: %d paths whose runs differ from path_runs_from_points\n",
+                        distance_names[dist], totals[dist].run_mismatches);
+                    failed = true;
+                }
+            }
+            grid_search_free(search);
+            gridmap_free(map);
+        }
+        block_overlay_free(overlay);
+        free(plane);
+        free(points);
+        free(runs);
+        free(expected);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#ifndef STRESS_BENCH_H
+#define STRESS_BENCH_H
+
+// --bench-kloop tool: the whole K-disjoint-path loop of handle_click (K
+// searches, each followed by stamping the path into a path-type plane and
+// blocking its cells) over a matrix of K, map size, wall density and endpoint
+// distance. Prints, per K, the total time of a loop, the time per path found
+// and the time lost on the final search that finds nothing.
+// Map sides go up from 64 by factors of 4 to max_side (default 1024).
+int stress_run_kloop_tool(int max_side, int queries);
+
+#endif // STRESS_BENCH_H
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+
+#include "task_pool.h"
+
+enum { TASK_IDLE, TASK_QUEUED, TASK_RUNNING };
+
+typedef struct {
+    PoolTask* head;
+    PoolTask* tail;
+} TaskQueue;
+
+struct TaskPool {
+    SDL_Mutex* lock;
+    SDL_Condition* work_ready;
+    SDL_Condition* slice_done; // For task_pool_cancel() waiting on a running task
+    TaskQueue* queues;
+    int queue_count;
+    int next_queue; // Round-robin position
+    int queued;     // Tasks in all queues
+    bool stopping;
+
+    double slice_ms;
+    SDL_Thread** threads;
+    int thread_count;
+};
+
+static void queue_push(TaskQueue* queue, PoolTask* task) {
+    task->next = NULL;
+    if (queue->tail)
+        queue->tail->next = task;
+    else
+        queue->head = task;
+    queue->tail = task;
+}
+
+// Pops from the first non-empty queue after the one served last. Called with the lock held.
+static PoolTask* take_task(TaskPool* pool) {
+    for (int i = 0; i < pool->queue_count; i++) {
+        int q = (pool->next_queue + i) % pool->queue_count;
+        TaskQueue* queue = &pool->queues[q];
+        if (!queue->head)
+            continue;
+        PoolTask* task = queue->head;
+        queue->head = task->next;
+        if (!queue->head)
+            queue->tail = NULL;
+        pool->next_queue = (q + 1) % pool->queue_count;
+        pool->queued--;
+        return task;
+    }
+    return NULL;
+}
+
+static int worker_main(void* data) {
+    TaskPool* pool = data;
+    SDL_LockMutex(pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->queued == 0)
+            SDL_WaitCondition(pool->work_ready, pool->lock);
+        if (pool->stopping)
+            break;
+
+        PoolTask* task = take_task(pool);
+        task->state = TASK_RUNNING;
+        SDL_UnlockMutex(pool->lock);
+        bool finished = task->step(task, pool->slice_ms);
+        SDL_LockMutex(pool->lock);
+
+        if (task->cancel || finished) {
+            task->state = TASK_IDLE;
+            if (finished && !task->cancel)
+                SDL_SetAtomicInt(&task->finished, 1);
+            SDL_BroadcastCondition(pool->slice_done);
+        }
+        else {
+            // Back to the end of its own queue; other sessions get the next slices
+            task->state = TASK_QUEUED;
+            queue_push(&pool->queues[task->queue], task);
+            pool->queued++;
+        }
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+TaskPool* task_pool_create(int thread_count, double slice_ms) {
+    if (thread_count <= 0)
+        thread_count = SDL_max(SDL_GetNumLogicalCPUCores() - 1, 1);
+
+    TaskPool* pool = calloc(1, sizeof(TaskPool));
+    if (!pool)
+        return NULL;
+    pool->slice_ms = slice_ms;
+    pool->lock = SDL_CreateMutex();
+    pool->work_ready = SDL_CreateCondition();
+    pool->slice_done = SDL_CreateCondition();
+    pool->threads = calloc(thread_count, sizeof(SDL_Thread*));
+    if (!pool->lock || !pool->work_ready || !pool->slice_done || !pool->threads) {
+        task_pool_destroy(pool);
+        return NULL;
+    }
+    for (int i = 0; i < thread_count; i++) {
+        pool->threads[i] = SDL_CreateThread(worker_main, "task pool", pool);
+        if (!pool->threads[i])
+            break;
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        task_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void task_pool_destroy(TaskPool* pool) {
+    if (!pool)
+        return;
+    if (pool->lock) {
+        SDL_LockMutex(pool->lock);
+        pool->stopping = true;
+        SDL_BroadcastCondition(pool->work_ready);
+        SDL_UnlockMutex(pool->lock);
+    }
+    for (int i = 0; i < pool->thread_count; i++)
+        SDL_WaitThread(pool->threads[i], NULL);
+    free(pool->threads);
+    free(pool->queues);
+    SDL_DestroyCondition(pool->slice_done);
+    SDL_DestroyCondition(pool->work_ready);
+    SDL_DestroyMutex(pool->lock);
+    free(pool);
+}
+
+int task_pool_add_queue(TaskPool* pool) {
+    SDL_LockMutex(pool->lock);
+    TaskQueue* queues = realloc(pool->queues, sizeof(TaskQueue) * (pool->queue_count + 1));
+    int id = -1;
+    if (queues) {
+        pool->queues = queues;
+        id = pool->queue_count++;
+        queues[id].head = queues[id].tail = NULL;
+    }
+    SDL_UnlockMutex(pool->lock);
+    return id;
+}
+
+void task_pool_submit(TaskPool* pool, int queue, PoolTask* task, PoolTaskStep step) {
+    task->step = step;
+    task->queue = queue;
+    task->cancel = false;
+    SDL_SetAtomicInt(&task->finished, 0);
+
+    SDL_LockMutex(pool->lock);
+    task->state = TASK_QUEUED;
+    queue_push(&pool->queues[queue], task);
+    pool->queued++;
+    SDL_SignalCondition(pool->work_ready);
+    SDL_UnlockMutex(pool->lock);
+}
+
+bool task_pool_finished(PoolTask* task) {
+    return SDL_GetAtomicInt(&task->finished) != 0;
+}
+
+void task_pool_cancel(TaskPool* pool, PoolTask* task) {
+    SDL_LockMutex(pool->lock);
+    if (task->state == TASK_QUEUED) {
+        TaskQueue* queue = &pool->queues[task->queue];
+        PoolTask* previous = NULL;
+        for (PoolTask* t = queue->head; t; previous = t, t = t->next) {
+            if (t != task)
+                continue;
+            if (previous)
+                previous->next = t->next;
+            else
+                queue->head = t->next;
+            if (queue->tail == t)
+                queue->tail = previous;
+            pool->queued--;
+            break;
+        }
+        task->state = TASK_IDLE;
+    }
+    else if (task->state == TASK_RUNNING) {
+        task->cancel = true;
+        while (task->state == TASK_RUNNING)
+            SDL_WaitCondition(pool->slice_done, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
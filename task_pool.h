@@ -0,0 +1,41 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+// Worker threads shared by all map sessions. Tasks run in time slices: a
+// worker runs one slice of a task, then requeues it and moves on to the next
+// queue round-robin. With one queue per session, a search on a huge map only
+// gets its fair share of the workers and cannot starve the other windows.
+typedef struct TaskPool TaskPool;
+typedef struct PoolTask PoolTask;
+
+// Runs the task for about budget_ms. Returns true once it is finished.
+typedef bool (*PoolTaskStep)(PoolTask* task, double budget_ms);
+
+// Embed as the first member of the caller's task struct. The pool never owns it.
+struct PoolTask {
+    PoolTaskStep step;
+    // Internal
+    int queue;
+    int state;
+    bool cancel;
+    SDL_AtomicInt finished;
+    PoolTask* next;
+};
+
+// thread_count <= 0 means one per core but one, which is left for the UI.
+TaskPool* task_pool_create(int thread_count, double slice_ms);
+// Every submitted task must be finished or cancelled first.
+void task_pool_destroy(TaskPool* pool);
+
+// A new fairness queue, e.g. one per session.
+int task_pool_add_queue(TaskPool* pool);
+void task_pool_submit(TaskPool* pool, int queue, PoolTask* task, PoolTaskStep step);
+// True once the last slice returned true; safe to poll from any thread.
+bool task_pool_finished(PoolTask* task);
+// Removes the task, waiting for a slice in progress to end. Afterwards the pool no longer touches it.
+void task_pool_cancel(TaskPool* pool, PoolTask* task);
+
+#endif // TASK_POOL_H